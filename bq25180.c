@@ -5,7 +5,7 @@
  */
 
 #include "bq25180.h"
-#include "bq25180_overrides.h"
+#include "bq25180_internal.h"
 #include <string.h>
 
 #if !defined(assert)
@@ -16,301 +16,1585 @@
 #define MIN(a, b)		(((a) > (b))? (b) : (a))
 #endif
 
-#define MIN_BAT_REG_mV		3500U
-#define MAX_BAT_REG_mV		4650U
-
-#define MIN_BAT_UNDERVOLTAGE_mV	2000U
-#define MAX_BAT_UNDERVOLTAGE_mV	3000U
-
-#define MIN_IN_CURR_mA		5U
-#define MAX_IN_CURR_mA		1000U
-
-enum registers {
-	STAT0		= 0,	/* Charger Status */
-	STAT1,			/* Charger Status and Faults */
-	FLAG0,			/* Charger Flag Registers */
-	VBAT_CTRL,		/* Battery Voltage Control */
-	ICHG_CTRL,		/* Fast Charge Current Control */
-	CHARGECTRL0,		/* Charger Control 0 */
-	CHARGECTRL1,		/* Charger Control 1 */
-	IC_CTRL,		/* IC Control */
-	TMR_ILIM,		/* Timer and Input Current Limit Control */
-	SHIP_RST,		/* Shipmode, Reset and Pushbutton Control */
-	SYS_REG,		/* SYS Regulation Voltage Control */
-	TS_CONTROL,		/* TS Control */
-	MASK_ID,		/* MASK and Device ID */
+/* Bits cleared by the device itself once the requested action is taken */
+#define SHIP_RST_SELF_CLEARING	\
+	(uint8_t)(FIELD_MASK(REG_RST) | FIELD_MASK(EN_RST_SHIP))
+
+const struct field bq25180_fields[NR_FIELDS] = {
+#define FIELD_DESC(name, r, s, w)	[FIELD_##name] = { \
+		.reg = (r), .shift = (s), .mask = ((1U << (w)) - 1) << (s) },
+	BQ25180_FIELDS(FIELD_DESC)
+#undef FIELD_DESC
+};
+
+static const uint8_t reset_defaults[NR_REGISTERS] = {
+#define REGISTER_DEFAULT(name, reset)	[name] = (reset),
+	BQ25180_REGISTERS(REGISTER_DEFAULT)
+#undef REGISTER_DEFAULT
 };
 
-static bool write_reg(uint8_t reg, uint8_t val)
+#define CHARGECTRL1_INTERRUPTS	(BQ25180_INTR_CHARGING_STATUS | \
+		BQ25180_INTR_CURRENT_LIMIT | BQ25180_INTR_VDPM)
+#define MASK_ID_INTERRUPTS	(BQ25180_INTR_ALL & ~CHARGECTRL1_INTERRUPTS)
+
+#if defined(BQ25180_TRACE)
+#define TRACE_BEGIN(dev, op)	trace_op_begin(dev, BQ25180_OP_##op)
+#define TRACE_END(dev, op, ok)	trace_op_end(dev, BQ25180_OP_##op, ok)
+#define TRACE_BUS_BEGIN(dev, write, reg, len)	\
+	trace_bus_begin(dev, write, reg, len)
+#define TRACE_BUS_END(dev, write, reg, len, res)	\
+	trace_bus_end(dev, write, reg, len, res)
+
+static uint32_t trace_time(const struct bq25180 *dev)
 {
-	return bq25180_write(BQ25180_DEVICE_ADDRESS, reg, &val, 1) >= 0;
+	const struct bq25180_trace_hooks *hooks = dev->trace.hooks;
+	return hooks && hooks->get_time? hooks->get_time(hooks->ctx) : 0;
 }
 
-static bool read_reg(uint8_t reg, uint8_t *p)
+static void trace_op_begin(struct bq25180 *dev, enum bq25180_op op)
 {
-	return bq25180_read(BQ25180_DEVICE_ADDRESS, reg, p, 1) >= 0;
+	const struct bq25180_trace_hooks *hooks = dev->trace.hooks;
+
+	dev->trace.op_started = trace_time(dev);
+
+	if (hooks && hooks->op_begin) {
+		hooks->op_begin(hooks->ctx, op, dev->trace.op_started);
+	}
 }
 
-static void set_reg(uint8_t reg, uint8_t bit, uint8_t mask, uint8_t val)
+static bool trace_op_end(struct bq25180 *dev, enum bq25180_op op, bool ok)
 {
-	uint8_t tmp;
+	const struct bq25180_trace_hooks *hooks = dev->trace.hooks;
+	const uint32_t now = trace_time(dev);
 
-	read_reg(reg, &tmp);
+	dev->trace.counters.ops[op].calls++;
+	if (!ok) {
+		dev->trace.counters.ops[op].failures++;
+	}
+	dev->trace.counters.ops[op].time += now - dev->trace.op_started;
 
-	tmp = tmp & (uint8_t)~(mask << bit);
-	tmp = tmp | (uint8_t)(val << bit);
+	if (hooks && hooks->op_end) {
+		hooks->op_end(hooks->ctx, op, ok, now);
+	}
 
-	write_reg(reg, tmp);
+	return ok;
 }
 
-static void set_interrupts(uint8_t mask, uint8_t enable)
+static void trace_bus_begin(struct bq25180 *dev,
+		bool write, uint8_t reg, size_t len)
 {
-	if (mask & BQ25180_INTR_CHARGING_STATUS) {
-		set_reg(CHARGECTRL1, 2, 1, !enable); /* CHG_STATUS_INT_MASK */
+	const struct bq25180_trace_hooks *hooks = dev->trace.hooks;
+
+	dev->trace.bus_started = trace_time(dev);
+
+	if (hooks && hooks->bus_begin) {
+		hooks->bus_begin(hooks->ctx, write, reg, len,
+				dev->trace.bus_started);
 	}
-	if (mask & BQ25180_INTR_CURRENT_LIMIT) {
-		set_reg(CHARGECTRL1, 1, 1, !enable); /* ILIM_INT_MASK */
+}
+
+static void trace_bus_end(struct bq25180 *dev,
+		bool write, uint8_t reg, size_t len, int res)
+{
+	const struct bq25180_trace_hooks *hooks = dev->trace.hooks;
+	const uint32_t now = trace_time(dev);
+
+	if (res < 0) {
+		dev->trace.counters.bus.errors++;
+	} else if (write) {
+		dev->trace.counters.bus.writes++;
+		dev->trace.counters.bus.written_bytes += (uint32_t)len;
+	} else {
+		dev->trace.counters.bus.reads++;
+		dev->trace.counters.bus.read_bytes += (uint32_t)len;
 	}
-	if (mask & BQ25180_INTR_VDPM) {
-		set_reg(CHARGECTRL1, 0, 1, !enable); /* VDPM_INT_MASK */
+	dev->trace.counters.bus.time += now - dev->trace.bus_started;
+
+	if (hooks && hooks->bus_end) {
+		hooks->bus_end(hooks->ctx, write, reg, len, res, now);
 	}
-	if (mask & BQ25180_INTR_THERMAL_FAULT) {
-		set_reg(MASK_ID, 7, 1, !enable); /* TS_INT_MASK */
+}
+#else
+#define TRACE_BEGIN(dev, op)				((void)0)
+#define TRACE_END(dev, op, ok)				(ok)
+#define TRACE_BUS_BEGIN(dev, write, reg, len)		((void)0)
+#define TRACE_BUS_END(dev, write, reg, len, res)	((void)0)
+#endif
+
+/* Wraps a public operation made of a single expression */
+#define TRACE(dev, op, expr)	\
+	(TRACE_BEGIN(dev, op), TRACE_END(dev, op, (expr)))
+
+static uint32_t get_time(const struct bq25180_retry_policy *policy)
+{
+	return policy->get_time? policy->get_time(policy->ctx) : 0;
+}
+
+static bool is_over_budget(const struct bq25180_retry_policy *policy,
+		uint32_t t0)
+{
+	return policy->budget && policy->get_time &&
+		(uint32_t)(get_time(policy) - t0) >= policy->budget;
+}
+
+static int bus_xfer(struct bq25180 *dev,
+		uint8_t reg, void *rbuf, const void *wbuf, size_t len)
+{
+	int res;
+
+	TRACE_BUS_BEGIN(dev, rbuf == NULL, reg, len);
+
+	if (rbuf) {
+		res = dev->bus->read(dev->bus_ctx, dev->addr, reg, rbuf, len);
+	} else {
+		res = dev->bus->write(dev->bus_ctx, dev->addr, reg, wbuf, len);
 	}
-	if (mask & BQ25180_INTR_THERMAL_REGULATION) {
-		set_reg(MASK_ID, 6, 1, !enable); /* TREG_INT_MASK */
+
+	TRACE_BUS_END(dev, rbuf == NULL, reg, len, res);
+
+	return res;
+}
+
+static int transfer(struct bq25180 *dev,
+		uint8_t reg, void *rbuf, const void *wbuf, size_t len)
+{
+	const struct bq25180_retry_policy *policy = dev->retry.policy;
+	int err = bus_xfer(dev, reg, rbuf, wbuf, len);
+
+	if (err >= 0 || policy == NULL || policy->max_retries == 0) {
+		if (err < 0) {
+			dev->retry.stats.failures++;
+		}
+		return err;
 	}
-	if (mask & BQ25180_INTR_BATTERY_RANGE) {
-		set_reg(MASK_ID, 5, 1, !enable); /* BAT_INT_MASK */
+
+	const uint32_t t0 = get_time(policy);
+
+	for (uint8_t i = 1; err < 0 && i <= policy->max_retries; i++) {
+		if (is_over_budget(policy, t0)) {
+			dev->retry.stats.budget_overruns++;
+			break;
+		}
+
+		if (policy->backoff) {
+			policy->backoff(policy->ctx, i, err);
+		}
+
+		dev->retry.stats.retries++;
+		dev->retry.stats.retried_bytes += (uint32_t)len;
+
+		err = bus_xfer(dev, reg, rbuf, wbuf, len);
 	}
-	if (mask & BQ25180_INTR_POWER_ERROR) {
-		set_reg(MASK_ID, 4, 1, !enable); /* PG_INT_MASK */
+
+	dev->retry.stats.retry_time += (uint32_t)(get_time(policy) - t0);
+
+	if (err < 0) {
+		dev->retry.stats.failures++;
 	}
+
+	return err;
 }
 
-void bq25180_reset(bool hardware_reset)
+static int bus_read(struct bq25180 *dev, uint8_t reg, void *buf, size_t len)
 {
-	if (hardware_reset) {
-		set_reg(SHIP_RST, 5, 3, 3); /* EN_RST_SHIP */
-	} else {
-		set_reg(SHIP_RST, 7, 1, 1); /* REG_RST */
-	}
+	return transfer(dev, reg, buf, NULL, len);
 }
 
-bool bq25180_read_event(struct bq25180_event *p)
+static int bus_write(struct bq25180 *dev,
+		uint8_t reg, const void *data, size_t len)
 {
-	uint8_t val;
+	return transfer(dev, reg, NULL, data, len);
+}
 
-	assert(p != NULL);
+static bool is_cached(const struct bq25180 *dev, uint8_t reg)
+{
+	return dev->shadow.enabled && reg >= VBAT_CTRL && reg <= MASK_ID;
+}
+
+static void seed_shadow(struct bq25180 *dev, const uint8_t *regs)
+{
+	memcpy(&dev->shadow.regs[VBAT_CTRL], &regs[VBAT_CTRL],
+			NR_REGISTERS - VBAT_CTRL);
+	dev->shadow.regs[SHIP_RST] &= (uint8_t)~SHIP_RST_SELF_CLEARING;
+}
+
+static bool write_regs(struct bq25180 *dev,
+		uint8_t reg, const uint8_t *vals, size_t len)
+{
+	uint8_t regs[NR_REGISTERS];
+
+	/* Writing EN_RST_SHIP back as 00 would cancel the mode pending. The
+	 * images and the cache keep it cleared, so it is put back here. */
+	if (dev->pending_mode != BQ25180_POWER_ACTIVE &&
+			reg <= SHIP_RST && reg + len > SHIP_RST &&
+			!(vals[SHIP_RST - reg] & SHIP_RST_SELF_CLEARING)) {
+		memcpy(&regs[reg], vals, len);
+		put_field(regs, FIELD_EN_RST_SHIP, (uint8_t)dev->pending_mode);
+		vals = &regs[reg];
+	}
 
-	if (!read_reg(FLAG0, &val)) {
+	if (bus_write(dev, reg, vals, len) < 0) {
 		return false;
 	}
 
-	memset(p, 0, sizeof(*p));
+	for (size_t i = 0; i < len; i++) {
+		const uint8_t r = (uint8_t)(reg + i);
 
-	p->battery_overcurrent = val & 1U; /* BAT_OCP_FAULT */
-	p->battery_undervoltage = (val >> 1) & 1U; /* BUVLO_FAULT_FLAG */
-	p->input_overvoltage = (val >> 2) & 1U; /* VIN_OVP_FAULT_FLAG */
-	p->thermal_regulation = (val >> 3) & 1U; /* THERMREG_ACTIVE_FLAG */
-	p->vindpm_fault = (val >> 4) & 1U; /* VINDPM_ACTIVE_FLAG */
-	p->vdppm_fault = (val >> 5) & 1U; /* VDPPM_ACTIVE_FLAG */
-	p->ilim_fault = (val >> 6) & 1U; /* ILIM_ACTIVE_FLAG */
-	p->battery_thermal_fault = (val >> 7) & 1U; /* TS_FAULT */
+		if (!is_cached(dev, r)) {
+			continue;
+		}
+
+		dev->shadow.regs[r] = vals[i];
+		if (r == SHIP_RST) {
+			dev->shadow.regs[r] &= (uint8_t)~SHIP_RST_SELF_CLEARING;
+		}
+	}
 
 	return true;
 }
 
-bool bq25180_read_state(struct bq25180_state *p)
+static bool write_reg(struct bq25180 *dev, uint8_t reg, uint8_t val)
 {
-	uint8_t val0, val1;
+	return write_regs(dev, reg, &val, 1);
+}
 
-	assert(p != NULL);
+static bool read_reg(struct bq25180 *dev, uint8_t reg, uint8_t *p)
+{
+	return bus_read(dev, reg, p, 1) >= 0;
+}
+
+static bool get_reg(struct bq25180 *dev, uint8_t reg, uint8_t *p)
+{
+	if (is_cached(dev, reg)) {
+		*p = dev->shadow.regs[reg];
+		return true;
+	}
+
+	return read_reg(dev, reg, p);
+}
+
+static bool set_field(struct bq25180 *dev, enum fields field, uint8_t val)
+{
+	const uint8_t reg = bq25180_fields[field].reg;
+	uint8_t regs[NR_REGISTERS];
 
-	if (!read_reg(STAT0, &val0) || !read_reg(STAT1, &val1)) {
+	if (!get_reg(dev, reg, &regs[reg])) {
 		return false;
 	}
 
-	memset(p, 0, sizeof(*p));
+	put_field(regs, field, val);
+
+	return write_reg(dev, reg, regs[reg]);
+}
+
+static bool read_field(struct bq25180 *dev, enum fields field, uint8_t *p)
+{
+	const uint8_t reg = bq25180_fields[field].reg;
+	uint8_t regs[NR_REGISTERS];
 
-	p->vin_good = val0 & 1U; /* VIN_PGOOD_STAT */
-	p->thermal_regulation_active = (val0 >> 1) & 1U; /* THERMREG_ACTIVE_STAT */
-	p->vindpm_active = (val0 >> 2) & 1U; /* VINDPM_ACTIVE_STAT */
-	p->vdppm_active = (val0 >> 3) & 1U; /* VDPPM_ACTIVE_STAT */
-	p->ilim_active = (val0 >> 4) & 1U; /* ILIM_ACTIVE_STAT */
-	p->charging_status = (val0 >> 5) & 3U; /* CHG_STAT */
-	p->tsmr_open = (val0 >> 7) & 1U; /* TS_OPEN_STAT */
-	p->wake2_raised = val1 & 1U; /* WAKE2_FLAG */
-	p->wake1_raised = (val1 >> 1) & 1U; /* WAKE1_FLAG */
-	p->safety_timer_fault = (val1 >> 2) & 1U; /* SAFETY_TMR_FAULT_FLAG */
-	p->ts_status = (val1 >> 3) & 3U; /* TS_STAT */
-	p->battery_undervoltage_active = (val1 >> 6) & 1U; /* BUVLO_START */
-	p->vin_overvoltage_active = (val1 >> 7) & 1U; /* VIN_OVP_STAT */
+	if (!get_reg(dev, reg, &regs[reg])) {
+		return false;
+	}
+
+	*p = get_field(regs, field);
 
 	return true;
 }
 
-void bq25180_enable_battery_charging(bool enable)
+uint8_t bq25180_encode_battery_regulation_voltage(uint16_t millivoltage)
 {
-	set_reg(ICHG_CTRL, 7, 1, !enable); /* CHG_DIS */
+	return (uint8_t)((millivoltage - MIN_BAT_REG_mV) /
+			BQ25180_VBATREG_STEP_mV);
 }
 
-void bq25180_set_safety_timer(enum bq25180_safety_timer opt)
+uint8_t bq25180_encode_battery_under_voltage(uint16_t millivoltage)
 {
-	/* TODO: support IC_CTRL.2XTMR_EN */
-	set_reg(IC_CTRL, 2, 3, (uint8_t)opt); /* SAFETY_TIMER */
+	/* BUVLO code per 200mV step above 2000mV */
+	static const uint8_t codes[] = { 7, 6, 5, 4, 3, 2, };
+
+	if (millivoltage <= BQ25180_BUVLO_MIN_mV) {
+		return codes[0];
+	}
+
+	return codes[MIN((millivoltage - BQ25180_BUVLO_MIN_mV +
+				BQ25180_BUVLO_STEP_mV - 1U) /
+			BQ25180_BUVLO_STEP_mV, 5U)];
 }
 
-void bq25180_set_watchdog_timer(enum bq25180_watchdog opt)
+uint8_t bq25180_encode_precharge_threshold(uint16_t millivoltage)
 {
-	/* TODO: support SYS_REG.WATCHDOG_15S_ENABLE */
-	set_reg(IC_CTRL, 0, 3, (uint8_t)opt); /* WATCHDOG_SEL */
+	return millivoltage <= BQ25180_VLOWV_LOW_mV;
 }
 
-void bq25180_set_battery_regulation_voltage(uint16_t millivoltage)
+uint8_t bq25180_encode_fastcharge_current(uint16_t milliampere)
 {
-	assert(millivoltage >= MIN_BAT_REG_mV &&
-			millivoltage <= MAX_BAT_REG_mV);
+	uint8_t val = (uint8_t)(milliampere - MIN_IN_CURR_mA);
+
+	if (milliampere > BQ25180_ICHG_FINE_MAX_mA) {
+		/* NOTE: 36mA to 39mA not in the range.
+		 * See the datasheet: Table 8-13. */
+		val = MIN((uint8_t)(milliampere / BQ25180_ICHG_COARSE_STEP_mA +
+					27), 127/*1000mA*/);
+	}
 
-	uint8_t reg = (uint8_t)((millivoltage - MIN_BAT_REG_mV) / 10);
-	write_reg(VBAT_CTRL, reg);
+	return val;
 }
 
-void bq25180_set_battery_discharge_current(
-		enum bq25180_bat_discharge_current opt)
+uint8_t bq25180_encode_termination_current(uint8_t pct)
 {
-	set_reg(CHARGECTRL1, 6, 3, (uint8_t)opt); /* IBAT_OCP */
+	/* ITERM code per percent of the fast charge current */
+	static const uint8_t codes[] = {
+		0, 0, 0, 0, 0, 1, 1, 1, 1, 1,
+		2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+		3,
+	};
+
+	return codes[MIN(pct, 20)];
 }
 
-void bq25180_set_battery_under_voltage(uint16_t millivoltage)
+uint8_t bq25180_encode_input_current(uint16_t milliampere)
 {
-	uint8_t val;
+	/* ILIM code per 100mA step */
+	static const uint8_t codes[] = {
+		0, 1, 2, 3, 4, 5, 5, 6, 6, 6, 6, 7,
+	};
 
-	assert(millivoltage >= MIN_BAT_UNDERVOLTAGE_mV &&
-			millivoltage <= MAX_BAT_UNDERVOLTAGE_mV);
+	return codes[MIN(milliampere / 100, 11)];
+}
 
-	if (millivoltage > 2800) {
-		val = 2;
-	} else if (millivoltage > 2600) {
-		val = 3;
-	} else if (millivoltage > 2400) {
-		val = 4;
-	} else if (millivoltage > 2200) {
-		val = 5;
-	} else if (millivoltage > 2000) {
-		val = 6;
-	} else {
-		val = 7;
+uint16_t bq25180_decode_battery_regulation_voltage(uint8_t code)
+{
+	return (uint16_t)MIN(MIN_BAT_REG_mV + code * BQ25180_VBATREG_STEP_mV,
+			MAX_BAT_REG_mV);
+}
+
+uint16_t bq25180_decode_battery_under_voltage(uint8_t code)
+{
+	static const uint16_t millivoltages[] = {
+		BQ25180_BUVLO_CODES_mV,
+	};
+
+	return millivoltages[code & 7];
+}
+
+uint16_t bq25180_decode_precharge_threshold(uint8_t code)
+{
+	return code? BQ25180_VLOWV_LOW_mV : BQ25180_VLOWV_HIGH_mV;
+}
+
+uint16_t bq25180_decode_fastcharge_current(uint8_t code)
+{
+	if (code <= 30) {
+		return (uint16_t)(code + MIN_IN_CURR_mA);
 	}
 
-	set_reg(CHARGECTRL1, 3, 7, val); /* UVLO */
+	return (uint16_t)((code - 27) * BQ25180_ICHG_COARSE_STEP_mA);
+}
+
+uint8_t bq25180_decode_termination_current(uint8_t code)
+{
+	static const uint8_t pcts[] = { BQ25180_ITERM_CODES_PCT, };
+
+	return pcts[code & 3];
 }
 
-void bq25180_set_precharge_threshold(uint16_t millivoltage)
+uint16_t bq25180_decode_input_current(uint8_t code)
 {
-	uint8_t val = 0;
+	static const uint16_t milliamperes[] = {
+		BQ25180_ILIM_CODES_mA,
+	};
+
+	return milliamperes[code & 7];
+}
+
+/* in the order of enum bq25180_intr */
+static const uint8_t mask_fields[BQ25180_NR_INTERRUPTS] = {
+	FIELD_CHG_STATUS_INT_MASK,
+	FIELD_ILIM_INT_MASK,
+	FIELD_VDPM_INT_MASK,
+	FIELD_TS_INT_MASK,
+	FIELD_TREG_INT_MASK,
+	FIELD_BAT_INT_MASK,
+	FIELD_PG_INT_MASK,
+};
 
-	if (millivoltage <= 2800) {
-		val = 1;
+static void mask_interrupts(uint8_t regs[NR_REGISTERS], uint8_t intr,
+		bool enable)
+{
+	for (int i = 0; i < BQ25180_NR_INTERRUPTS; i++) {
+		if (intr & (1U << i)) {
+			put_field(regs, (enum fields)mask_fields[i], !enable);
+		}
 	}
+}
 
-	set_reg(IC_CTRL, 6, 1, val); /* VLOWV_SEL */
+static void put_ts_config(uint8_t regs[NR_REGISTERS],
+		const struct bq25180_ts_config *ts)
+{
+	put_field(regs, FIELD_TS_HOT, (uint8_t)ts->hot);
+	put_field(regs, FIELD_TS_COLD, (uint8_t)ts->cold);
+	put_field(regs, FIELD_TS_WARM, !ts->warm_enabled);
+	put_field(regs, FIELD_TS_COOL, !ts->cool_enabled);
+	put_field(regs, FIELD_TS_ICHG, (uint8_t)ts->cool_current);
+	put_field(regs, FIELD_TS_VRCG, (uint8_t)ts->warm_voltage);
 }
 
-void bq25180_set_precharge_current(bool double_termination_current)
+static void get_ts_config(const uint8_t regs[NR_REGISTERS],
+		struct bq25180_ts_config *ts)
 {
-	set_reg(CHARGECTRL0, 6, 1, !double_termination_current); /* IPRECHG */
+	*ts = (struct bq25180_ts_config) {
+		.hot = get_field(regs, FIELD_TS_HOT),
+		.cold = get_field(regs, FIELD_TS_COLD),
+		.warm_enabled = !test_field(regs, FIELD_TS_WARM),
+		.cool_enabled = !test_field(regs, FIELD_TS_COOL),
+		.cool_current = get_field(regs, FIELD_TS_ICHG),
+		.warm_voltage = get_field(regs, FIELD_TS_VRCG),
+	};
 }
 
-void bq25180_set_fastcharge_current(uint16_t milliampere)
+static void build_config_image(uint8_t regs[NR_REGISTERS],
+		const struct bq25180_config *cfg)
 {
-	assert(milliampere >= MIN_IN_CURR_mA && milliampere <= MAX_IN_CURR_mA);
+	put_field(regs, FIELD_VBATREG,
+			bq25180_encode_battery_regulation_voltage(
+				cfg->battery_regulation_millivoltage));
 
-	uint8_t val = (uint8_t)(milliampere - MIN_IN_CURR_mA);
+	put_field(regs, FIELD_CHG_DIS, !cfg->charging_enabled);
+	put_field(regs, FIELD_ICHG, bq25180_encode_fastcharge_current(
+				cfg->fastcharge_milliampere));
 
-	if (milliampere > 35) {
-		/* NOTE: 36mA to 39mA not in the range.
-		 * See the datasheet: Table 8-13. */
-		val = MIN((uint8_t)(milliampere / 10 + 27), 127/*1000mA*/);
+	put_field(regs, FIELD_IPRECHG, !cfg->double_precharge_current);
+	put_field(regs, FIELD_ITERM, bq25180_encode_termination_current(
+				cfg->termination_pct));
+	put_field(regs, FIELD_VINDPM, (uint8_t)cfg->vindpm);
+
+	put_field(regs, FIELD_IBAT_OCP, (uint8_t)cfg->discharge_current);
+	put_field(regs, FIELD_BUVLO, bq25180_encode_battery_under_voltage(
+				cfg->battery_undervoltage_millivoltage));
+
+	put_field(regs, FIELD_TS_EN, cfg->thermal_protection_enabled);
+	put_ts_config(regs, &cfg->ts);
+	put_field(regs, FIELD_VLOWV_SEL, bq25180_encode_precharge_threshold(
+				cfg->precharge_threshold_millivoltage));
+	put_field(regs, FIELD_SAFETY_TIMER, (uint8_t)cfg->safety_timer);
+	put_field(regs, FIELD_WATCHDOG_SEL, (uint8_t)cfg->watchdog);
+
+	put_field(regs, FIELD_ILIM,
+			bq25180_encode_input_current(cfg->input_milliampere));
+
+	regs[SHIP_RST] &= (uint8_t)~SHIP_RST_SELF_CLEARING;
+	put_field(regs, FIELD_EN_PUSH, cfg->push_button_enabled);
+
+	put_field(regs, FIELD_SYS_REG_CTRL, (uint8_t)cfg->sys_voltage);
+	put_field(regs, FIELD_SYS_MODE, (uint8_t)cfg->sys_source);
+	put_field(regs, FIELD_VDPPM_DIS, !cfg->dppm_enabled);
+
+	mask_interrupts(regs, BQ25180_INTR_ALL, false);
+	mask_interrupts(regs, cfg->interrupts, true);
+}
+
+void bq25180_decode_config(const uint8_t regs[NR_REGISTERS],
+		struct bq25180_config *cfg)
+{
+	uint8_t interrupts = 0;
+
+	for (int i = 0; i < BQ25180_NR_INTERRUPTS; i++) {
+		if (!test_field(regs, (enum fields)mask_fields[i])) {
+			interrupts = (uint8_t)(interrupts | (1U << i));
+		}
+	}
+
+	*cfg = (struct bq25180_config) {
+		.charging_enabled = !test_field(regs, FIELD_CHG_DIS),
+		.battery_regulation_millivoltage =
+			bq25180_decode_battery_regulation_voltage(
+				get_field(regs, FIELD_VBATREG)),
+		.fastcharge_milliampere = bq25180_decode_fastcharge_current(
+				get_field(regs, FIELD_ICHG)),
+		.termination_pct = bq25180_decode_termination_current(
+				get_field(regs, FIELD_ITERM)),
+		.double_precharge_current = !test_field(regs, FIELD_IPRECHG),
+		.precharge_threshold_millivoltage =
+			bq25180_decode_precharge_threshold(
+				get_field(regs, FIELD_VLOWV_SEL)),
+		.battery_undervoltage_millivoltage =
+			bq25180_decode_battery_under_voltage(
+				get_field(regs, FIELD_BUVLO)),
+		.discharge_current = get_field(regs, FIELD_IBAT_OCP),
+		.input_milliampere = bq25180_decode_input_current(
+				get_field(regs, FIELD_ILIM)),
+		.vindpm = get_field(regs, FIELD_VINDPM),
+		.dppm_enabled = !test_field(regs, FIELD_VDPPM_DIS),
+		.safety_timer = get_field(regs, FIELD_SAFETY_TIMER),
+		.watchdog = get_field(regs, FIELD_WATCHDOG_SEL),
+		.sys_source = get_field(regs, FIELD_SYS_MODE),
+		.sys_voltage = get_field(regs, FIELD_SYS_REG_CTRL),
+		.thermal_protection_enabled = test_field(regs, FIELD_TS_EN),
+		.push_button_enabled = test_field(regs, FIELD_EN_PUSH),
+		.interrupts = interrupts,
+	};
+
+	get_ts_config(regs, &cfg->ts);
+}
+
+static bool read_config_regs(struct bq25180 *dev,
+		uint8_t regs[NR_REGISTERS])
+{
+	if (is_cached(dev, VBAT_CTRL)) {
+		memcpy(regs, dev->shadow.regs, NR_REGISTERS);
+		return true;
+	}
+
+	if (bus_read(dev, VBAT_CTRL, &regs[VBAT_CTRL],
+			NR_REGISTERS - VBAT_CTRL) < 0) {
+		return false;
+	}
+
+	/* Compared with images that keep it cleared */
+	regs[SHIP_RST] &= (uint8_t)~SHIP_RST_SELF_CLEARING;
+
+	return true;
+}
+
+static bool write_changes(struct bq25180 *dev, const uint8_t cur[NR_REGISTERS],
+		const uint8_t image[NR_REGISTERS])
+{
+	for (uint8_t reg = VBAT_CTRL; reg < NR_REGISTERS; reg++) {
+		uint8_t last = reg;
+
+		if (image[reg] == cur[reg]) {
+			continue;
+		}
+
+		/* Rewriting a single unchanged register in between costs less
+		 * than addressing the device again in a new transaction. */
+		for (uint8_t i = (uint8_t)(reg + 1);
+				i < NR_REGISTERS && i - last <= 2; i++) {
+			if (image[i] != cur[i]) {
+				last = i;
+			}
+		}
+
+		if (!write_regs(dev, reg, &image[reg],
+				(size_t)(last - reg + 1))) {
+			return false;
+		}
+
+		reg = last;
+	}
+
+	return true;
+}
+
+static bool update_interrupt_mask(struct bq25180 *dev,
+		uint8_t reg, uint8_t mask, uint8_t enable)
+{
+	uint8_t regs[NR_REGISTERS];
+
+	if (!get_reg(dev, reg, &regs[reg])) {
+		return false;
+	}
+
+	const uint8_t old = regs[reg];
+	mask_interrupts(regs, mask, enable);
+
+	if (regs[reg] == old) {
+		return true;
+	}
+
+	return write_reg(dev, reg, regs[reg]);
+}
+
+static bool set_interrupts(struct bq25180 *dev, uint8_t mask, uint8_t enable)
+{
+	/* All the changes are merged into a single write per register */
+	if ((mask & CHARGECTRL1_INTERRUPTS) &&
+			!update_interrupt_mask(dev, CHARGECTRL1,
+				mask & CHARGECTRL1_INTERRUPTS, enable)) {
+		return false;
+	}
+	if ((mask & MASK_ID_INTERRUPTS) &&
+			!update_interrupt_mask(dev, MASK_ID,
+				mask & MASK_ID_INTERRUPTS, enable)) {
+		return false;
+	}
+
+	return true;
+}
+
+/* The first STAT0 seen is the baseline, not a change */
+static void prime_interrupt(struct bq25180 *dev, uint8_t stat0)
+{
+	if (!dev->irq.primed) {
+		dev->irq.stat0 = stat0;
+		dev->irq.primed = true;
+	}
+}
+
+/* Answering with VIN gone, the device has been through the mode pending and
+ * woke up with the reset defaults */
+static void track_power_mode(struct bq25180 *dev, uint8_t stat0)
+{
+	const uint8_t regs[NR_REGISTERS] = { [STAT0] = stat0, };
+
+	if (dev->pending_mode == BQ25180_POWER_ACTIVE ||
+			test_field(regs, FIELD_VIN_PGOOD_STAT)) {
+		return;
 	}
 
-	set_reg(ICHG_CTRL, 0, 0x7f, val); /* ICHG */
+	dev->pending_mode = BQ25180_POWER_ACTIVE;
+
+	if (dev->shadow.enabled) {
+		seed_shadow(dev, reset_defaults);
+	}
+}
+
+static void track_status(struct bq25180 *dev, uint8_t stat0)
+{
+	prime_interrupt(dev, stat0);
+	track_power_mode(dev, stat0);
 }
 
-void bq25180_set_termination_current(uint8_t pct)
+static uint8_t get_fired_interrupts(const struct bq25180 *dev,
+		uint8_t stat0, uint8_t flag0)
 {
-	uint8_t val = 0;
+	const uint8_t changed = stat0 ^ dev->irq.stat0;
+	uint8_t fired = 0;
 
-	if (pct >= 20) {
-		val = 3;
-	} else if (pct >= 10) {
-		val = 2;
-	} else if (pct >= 5) {
-		val = 1;
+	if (changed & FIELD_MASK(CHG_STAT)) {
+		fired |= BQ25180_INTR_CHARGING_STATUS;
+	}
+	if (flag0 & FIELD_MASK(ILIM_ACTIVE_FLAG)) {
+		fired |= BQ25180_INTR_CURRENT_LIMIT;
+	}
+	if (flag0 & (FIELD_MASK(VDPPM_ACTIVE_FLAG) |
+			FIELD_MASK(VINDPM_ACTIVE_FLAG))) {
+		fired |= BQ25180_INTR_VDPM;
+	}
+	if (flag0 & FIELD_MASK(TS_FAULT)) {
+		fired |= BQ25180_INTR_THERMAL_FAULT;
+	}
+	if (flag0 & FIELD_MASK(THERMREG_ACTIVE_FLAG)) {
+		fired |= BQ25180_INTR_THERMAL_REGULATION;
+	}
+	if (flag0 & (FIELD_MASK(BUVLO_FAULT_FLAG) |
+			FIELD_MASK(BAT_OCP_FAULT))) {
+		fired |= BQ25180_INTR_BATTERY_RANGE;
+	}
+	if ((flag0 & FIELD_MASK(VIN_OVP_FAULT_FLAG)) ||
+			(changed & FIELD_MASK(VIN_PGOOD_STAT))) {
+		fired |= BQ25180_INTR_POWER_ERROR;
 	}
 
-	set_reg(CHARGECTRL0, 4, 3, val); /* ITERM */
+	return fired;
 }
 
-void bq25180_enable_vindpm(enum bq25180_vindpm opt)
+void bq25180_dev_init(struct bq25180 *dev, uint8_t addr,
+		const struct bq25180_bus *bus, void *bus_ctx)
 {
-	set_reg(CHARGECTRL0, 2, 3, (uint8_t)opt); /* VINDPM */
+	assert(dev != NULL);
+	assert(bus != NULL && bus->read != NULL && bus->write != NULL);
+
+	*dev = (struct bq25180) {
+		.bus = bus,
+		.bus_ctx = bus_ctx,
+		.addr = addr,
+	};
 }
 
-void bq25180_enable_dppm(bool enable)
+bool bq25180_dev_reset(struct bq25180 *dev, bool hardware_reset)
 {
-	set_reg(SYS_REG, 0, 1, !enable); /* VDPPM_DIS */
+	bool ok;
+
+	TRACE_BEGIN(dev, RESET);
+
+	if (hardware_reset) {
+		ok = set_field(dev, FIELD_EN_RST_SHIP, 3);
+	} else {
+		ok = set_field(dev, FIELD_REG_RST, 1);
+	}
+
+	if (ok) {
+		dev->pending_mode = BQ25180_POWER_ACTIVE;
+	}
+	if (ok && dev->shadow.enabled) {
+		seed_shadow(dev, reset_defaults);
+	}
+
+	return TRACE_END(dev, RESET, ok);
 }
 
-void bq25180_set_input_current(uint16_t milliampere)
+bool bq25180_dev_enable_cache(struct bq25180 *dev, bool read_device)
 {
-	uint8_t val = 0;
+	uint8_t regs[NR_REGISTERS];
+
+	TRACE_BEGIN(dev, ENABLE_CACHE);
 
-	if (milliampere >= 1100) {
-		val = 7;
-	} else if (milliampere >= 700) {
-		val = 6;
-	} else if (milliampere >= 500) {
-		val = 5;
-	} else if (milliampere >= 400) {
-		val = 4;
-	} else if (milliampere >= 300) {
-		val = 3;
-	} else if (milliampere >= 200) {
-		val = 2;
-	} else if (milliampere >= 100) {
-		val = 1;
+	if (!read_device) {
+		seed_shadow(dev, reset_defaults);
+	} else if (bus_read(dev, VBAT_CTRL,
+			&regs[VBAT_CTRL], NR_REGISTERS - VBAT_CTRL) >= 0) {
+		seed_shadow(dev, regs);
+	} else {
+		return TRACE_END(dev, ENABLE_CACHE, false);
 	}
 
-	set_reg(TMR_ILIM, 0, 7, val); /* ILIM */
+	dev->shadow.enabled = true;
+
+	return TRACE_END(dev, ENABLE_CACHE, true);
 }
 
-void bq25180_set_sys_source(enum bq25180_sys_source source)
+void bq25180_dev_disable_cache(struct bq25180 *dev)
 {
-	set_reg(SYS_REG, 2, 3, (uint8_t)source); /* SYS_MODE */
+	dev->shadow.enabled = false;
+}
+
+void bq25180_decode_event(uint8_t val, struct bq25180_event *p)
+{
+	const uint8_t regs[NR_REGISTERS] = { [FLAG0] = val, };
+
+	memset(p, 0, sizeof(*p));
+
+	p->battery_overcurrent = test_field(regs, FIELD_BAT_OCP_FAULT);
+	p->battery_undervoltage = test_field(regs, FIELD_BUVLO_FAULT_FLAG);
+	p->input_overvoltage = test_field(regs, FIELD_VIN_OVP_FAULT_FLAG);
+	p->thermal_regulation = test_field(regs, FIELD_THERMREG_ACTIVE_FLAG);
+	p->vindpm_fault = test_field(regs, FIELD_VINDPM_ACTIVE_FLAG);
+	p->vdppm_fault = test_field(regs, FIELD_VDPPM_ACTIVE_FLAG);
+	p->ilim_fault = test_field(regs, FIELD_ILIM_ACTIVE_FLAG);
+	p->battery_thermal_fault = test_field(regs, FIELD_TS_FAULT);
 }
 
-void bq25180_set_sys_voltage(enum bq25180_sys_regulation val)
+void bq25180_decode_state(uint8_t val0, uint8_t val1, struct bq25180_state *p)
 {
-	set_reg(SYS_REG, 5, 7, (uint8_t)val); /* SYS_REG_CTRL */
+	const uint8_t regs[NR_REGISTERS] = { [STAT0] = val0, [STAT1] = val1, };
+
+	memset(p, 0, sizeof(*p));
+
+	p->vin_good = test_field(regs, FIELD_VIN_PGOOD_STAT);
+	p->thermal_regulation_active =
+		test_field(regs, FIELD_THERMREG_ACTIVE_STAT);
+	p->vindpm_active = test_field(regs, FIELD_VINDPM_ACTIVE_STAT);
+	p->vdppm_active = test_field(regs, FIELD_VDPPM_ACTIVE_STAT);
+	p->ilim_active = test_field(regs, FIELD_ILIM_ACTIVE_STAT);
+	p->charging_status = get_field(regs, FIELD_CHG_STAT) & 3U;
+	p->tsmr_open = test_field(regs, FIELD_TS_OPEN_STAT);
+	p->wake2_raised = test_field(regs, FIELD_WAKE2_FLAG);
+	p->wake1_raised = test_field(regs, FIELD_WAKE1_FLAG);
+	p->safety_timer_fault = test_field(regs, FIELD_SAFETY_TMR_FAULT_FLAG);
+	p->ts_status = get_field(regs, FIELD_TS_STAT) & 3U;
+	p->battery_undervoltage_active = test_field(regs, FIELD_BUVLO_STAT);
+	p->vin_overvoltage_active = test_field(regs, FIELD_VIN_OVP_STAT);
 }
 
-void bq25180_enable_thermal_protection(bool enable)
+bool bq25180_dev_read_event(struct bq25180 *dev, struct bq25180_event *p)
 {
-	set_reg(IC_CTRL, 7, 1, enable); /* TS_EN */
+	uint8_t val;
+
+	assert(p != NULL);
+
+	TRACE_BEGIN(dev, READ_EVENT);
+
+	if (!read_reg(dev, FLAG0, &val)) {
+		return TRACE_END(dev, READ_EVENT, false);
+	}
+
+	bq25180_decode_event(val, p);
+
+	return TRACE_END(dev, READ_EVENT, true);
 }
 
-void bq25180_enable_push_button(bool enable)
+/* STAT0 onward in a burst. FLAG0 is cleared on read, so only with len 3 */
+static bool read_status(struct bq25180 *dev, uint8_t *regs, size_t len)
 {
-	set_reg(SHIP_RST, 0, 1, enable); /* EN_PUSH */
+	if (bus_read(dev, STAT0, regs, len) < 0) {
+		return false;
+	}
+
+	track_status(dev, regs[STAT0]);
+
+	return true;
 }
 
-void bq25180_enable_interrupt(uint8_t mask)
+bool bq25180_dev_read_state(struct bq25180 *dev, struct bq25180_state *p)
 {
-	set_interrupts(mask, 1);
+	uint8_t regs[STAT1 + 1];
+
+	assert(p != NULL);
+
+	TRACE_BEGIN(dev, READ_STATE);
+
+	if (!read_status(dev, regs, sizeof(regs))) {
+		return TRACE_END(dev, READ_STATE, false);
+	}
+
+	bq25180_decode_state(regs[STAT0], regs[STAT1], p);
+
+	return TRACE_END(dev, READ_STATE, true);
 }
 
-void bq25180_disable_interrupt(uint8_t mask)
+bool bq25180_dev_read_snapshot(struct bq25180 *dev,
+		struct bq25180_state *state, struct bq25180_event *event)
 {
-	set_interrupts(mask, 0);
+	uint8_t regs[FLAG0 + 1];
+	/* FLAG0 is left untouched unless the events are asked for */
+	size_t len = event? sizeof(regs) : FLAG0;
+
+	assert(state != NULL || event != NULL);
+
+	TRACE_BEGIN(dev, READ_SNAPSHOT);
+
+	if (!read_status(dev, regs, len)) {
+		return TRACE_END(dev, READ_SNAPSHOT, false);
+	}
+
+	if (state) {
+		bq25180_decode_state(regs[STAT0], regs[STAT1], state);
+	}
+	if (event) {
+		bq25180_decode_event(regs[FLAG0], event);
+	}
+
+	return TRACE_END(dev, READ_SNAPSHOT, true);
 }
+
+bool bq25180_dev_dump(struct bq25180 *dev, struct bq25180_dump *dump)
+{
+	assert(dump != NULL);
+
+	TRACE_BEGIN(dev, DUMP);
+
+	if (bus_read(dev, STAT0, dump->regs, sizeof(dump->regs)) < 0) {
+		return TRACE_END(dev, DUMP, false);
+	}
+
+	if (dev->shadow.enabled) {
+		seed_shadow(dev, dump->regs);
+	}
+
+	return TRACE_END(dev, DUMP, true);
+}
+
+bool bq25180_dev_enable_battery_charging(struct bq25180 *dev, bool enable)
+{
+	return TRACE(dev, ENABLE_BATTERY_CHARGING,
+			set_field(dev, FIELD_CHG_DIS, !enable));
+}
+
+bool bq25180_dev_set_safety_timer(struct bq25180 *dev,
+		enum bq25180_safety_timer opt)
+{
+	/* TODO: support IC_CTRL.2XTMR_EN */
+	return TRACE(dev, SET_SAFETY_TIMER,
+			set_field(dev, FIELD_SAFETY_TIMER, (uint8_t)opt));
+}
+
+bool bq25180_dev_set_watchdog_timer(struct bq25180 *dev,
+		enum bq25180_watchdog opt)
+{
+	/* TODO: support SYS_REG.WATCHDOG_15S_ENABLE */
+	return TRACE(dev, SET_WATCHDOG_TIMER,
+			set_field(dev, FIELD_WATCHDOG_SEL, (uint8_t)opt));
+}
+
+bool bq25180_dev_set_battery_regulation_voltage(struct bq25180 *dev,
+		uint16_t millivoltage)
+{
+	assert(millivoltage >= MIN_BAT_REG_mV &&
+			millivoltage <= MAX_BAT_REG_mV);
+
+	return TRACE(dev, SET_BATTERY_REGULATION_VOLTAGE,
+			write_reg(dev, VBAT_CTRL,
+				bq25180_encode_battery_regulation_voltage(
+					millivoltage)));
+}
+
+bool bq25180_dev_get_battery_regulation_voltage(struct bq25180 *dev,
+		uint16_t *millivoltage)
+{
+	uint8_t code;
+
+	assert(millivoltage != NULL);
+
+	TRACE_BEGIN(dev, GET_BATTERY_REGULATION_VOLTAGE);
+
+	if (!read_field(dev, FIELD_VBATREG, &code)) {
+		return TRACE_END(dev, GET_BATTERY_REGULATION_VOLTAGE, false);
+	}
+
+	*millivoltage = bq25180_decode_battery_regulation_voltage(code);
+
+	return TRACE_END(dev, GET_BATTERY_REGULATION_VOLTAGE, true);
+}
+
+bool bq25180_dev_set_battery_discharge_current(struct bq25180 *dev,
+		enum bq25180_bat_discharge_current opt)
+{
+	return TRACE(dev, SET_BATTERY_DISCHARGE_CURRENT,
+			set_field(dev, FIELD_IBAT_OCP, (uint8_t)opt));
+}
+
+bool bq25180_dev_set_battery_under_voltage(struct bq25180 *dev,
+		uint16_t millivoltage)
+{
+	assert(millivoltage >= MIN_BAT_UNDERVOLTAGE_mV &&
+			millivoltage <= MAX_BAT_UNDERVOLTAGE_mV);
+
+	return TRACE(dev, SET_BATTERY_UNDER_VOLTAGE,
+			set_field(dev, FIELD_BUVLO,
+				bq25180_encode_battery_under_voltage(
+					millivoltage)));
+}
+
+bool bq25180_dev_set_precharge_threshold(struct bq25180 *dev,
+		uint16_t millivoltage)
+{
+	return TRACE(dev, SET_PRECHARGE_THRESHOLD,
+			set_field(dev, FIELD_VLOWV_SEL,
+				bq25180_encode_precharge_threshold(
+					millivoltage)));
+}
+
+bool bq25180_dev_set_precharge_current(struct bq25180 *dev,
+		bool double_termination_current)
+{
+	return TRACE(dev, SET_PRECHARGE_CURRENT,
+			set_field(dev, FIELD_IPRECHG,
+				!double_termination_current));
+}
+
+bool bq25180_dev_set_fastcharge_current(struct bq25180 *dev,
+		uint16_t milliampere)
+{
+	assert(milliampere >= MIN_IN_CURR_mA && milliampere <= MAX_IN_CURR_mA);
+
+	return TRACE(dev, SET_FASTCHARGE_CURRENT,
+			set_field(dev, FIELD_ICHG,
+				bq25180_encode_fastcharge_current(
+					milliampere)));
+}
+
+bool bq25180_dev_get_fastcharge_current(struct bq25180 *dev,
+		uint16_t *milliampere)
+{
+	uint8_t code;
+
+	assert(milliampere != NULL);
+
+	TRACE_BEGIN(dev, GET_FASTCHARGE_CURRENT);
+
+	if (!read_field(dev, FIELD_ICHG, &code)) {
+		return TRACE_END(dev, GET_FASTCHARGE_CURRENT, false);
+	}
+
+	*milliampere = bq25180_decode_fastcharge_current(code);
+
+	return TRACE_END(dev, GET_FASTCHARGE_CURRENT, true);
+}
+
+bool bq25180_dev_set_termination_current(struct bq25180 *dev, uint8_t pct)
+{
+	return TRACE(dev, SET_TERMINATION_CURRENT,
+			set_field(dev, FIELD_ITERM,
+				bq25180_encode_termination_current(pct)));
+}
+
+bool bq25180_dev_enable_vindpm(struct bq25180 *dev, enum bq25180_vindpm opt)
+{
+	return TRACE(dev, ENABLE_VINDPM,
+			set_field(dev, FIELD_VINDPM, (uint8_t)opt));
+}
+
+bool bq25180_dev_enable_dppm(struct bq25180 *dev, bool enable)
+{
+	return TRACE(dev, ENABLE_DPPM,
+			set_field(dev, FIELD_VDPPM_DIS, !enable));
+}
+
+bool bq25180_dev_set_input_current(struct bq25180 *dev, uint16_t milliampere)
+{
+	return TRACE(dev, SET_INPUT_CURRENT,
+			set_field(dev, FIELD_ILIM,
+				bq25180_encode_input_current(milliampere)));
+}
+
+bool bq25180_dev_get_input_current(struct bq25180 *dev, uint16_t *milliampere)
+{
+	uint8_t code;
+
+	assert(milliampere != NULL);
+
+	TRACE_BEGIN(dev, GET_INPUT_CURRENT);
+
+	if (!read_field(dev, FIELD_ILIM, &code)) {
+		return TRACE_END(dev, GET_INPUT_CURRENT, false);
+	}
+
+	*milliampere = bq25180_decode_input_current(code);
+
+	return TRACE_END(dev, GET_INPUT_CURRENT, true);
+}
+
+bool bq25180_dev_set_sys_source(struct bq25180 *dev,
+		enum bq25180_sys_source source)
+{
+	return TRACE(dev, SET_SYS_SOURCE,
+			set_field(dev, FIELD_SYS_MODE, (uint8_t)source));
+}
+
+bool bq25180_dev_get_sys_source(struct bq25180 *dev,
+		enum bq25180_sys_source *source)
+{
+	uint8_t code;
+
+	assert(source != NULL);
+
+	TRACE_BEGIN(dev, GET_SYS_SOURCE);
+
+	if (!read_field(dev, FIELD_SYS_MODE, &code)) {
+		return TRACE_END(dev, GET_SYS_SOURCE, false);
+	}
+
+	*source = (enum bq25180_sys_source)code;
+
+	return TRACE_END(dev, GET_SYS_SOURCE, true);
+}
+
+bool bq25180_dev_set_sys_voltage(struct bq25180 *dev,
+		enum bq25180_sys_regulation val)
+{
+	return TRACE(dev, SET_SYS_VOLTAGE,
+			set_field(dev, FIELD_SYS_REG_CTRL, (uint8_t)val));
+}
+
+bool bq25180_dev_enable_thermal_protection(struct bq25180 *dev, bool enable)
+{
+	return TRACE(dev, ENABLE_THERMAL_PROTECTION,
+			set_field(dev, FIELD_TS_EN, enable));
+}
+
+bool bq25180_dev_set_ts_control(struct bq25180 *dev,
+		const struct bq25180_ts_config *ts)
+{
+	uint8_t regs[NR_REGISTERS] = { 0, };
+
+	assert(ts != NULL);
+
+	/* Every bit of the register is covered, leaving nothing to keep */
+	put_ts_config(regs, ts);
+
+	return TRACE(dev, SET_TS_CONTROL,
+			write_reg(dev, TS_CONTROL, regs[TS_CONTROL]));
+}
+
+bool bq25180_dev_get_ts_control(struct bq25180 *dev,
+		struct bq25180_ts_config *ts)
+{
+	uint8_t regs[NR_REGISTERS];
+
+	assert(ts != NULL);
+
+	TRACE_BEGIN(dev, GET_TS_CONTROL);
+
+	if (!get_reg(dev, TS_CONTROL, &regs[TS_CONTROL])) {
+		return TRACE_END(dev, GET_TS_CONTROL, false);
+	}
+
+	get_ts_config(regs, ts);
+
+	return TRACE_END(dev, GET_TS_CONTROL, true);
+}
+
+bool bq25180_dev_enable_push_button(struct bq25180 *dev, bool enable)
+{
+	return TRACE(dev, ENABLE_PUSH_BUTTON,
+			set_field(dev, FIELD_EN_PUSH, enable));
+}
+
+bool bq25180_dev_set_wake_config(struct bq25180 *dev,
+		const struct bq25180_wake_config *wake)
+{
+	uint8_t regs[NR_REGISTERS];
+
+	assert(wake != NULL);
+
+	TRACE_BEGIN(dev, SET_WAKE_CONFIG);
+
+	if (!get_reg(dev, SHIP_RST, &regs[SHIP_RST])) {
+		return TRACE_END(dev, SET_WAKE_CONFIG, false);
+	}
+
+	put_field(regs, FIELD_PB_LPRESS_ACTION, (uint8_t)wake->long_press);
+	put_field(regs, FIELD_WAKE1_TMR, (uint8_t)wake->wake1);
+	put_field(regs, FIELD_WAKE2_TMR, (uint8_t)wake->wake2);
+	put_field(regs, FIELD_EN_PUSH, wake->push_button_enabled);
+
+	return TRACE_END(dev, SET_WAKE_CONFIG,
+			write_reg(dev, SHIP_RST, regs[SHIP_RST]));
+}
+
+bool bq25180_dev_get_wake_config(struct bq25180 *dev,
+		struct bq25180_wake_config *wake)
+{
+	uint8_t regs[NR_REGISTERS];
+
+	assert(wake != NULL);
+
+	TRACE_BEGIN(dev, GET_WAKE_CONFIG);
+
+	if (!get_reg(dev, SHIP_RST, &regs[SHIP_RST])) {
+		return TRACE_END(dev, GET_WAKE_CONFIG, false);
+	}
+
+	*wake = (struct bq25180_wake_config) {
+		.push_button_enabled = test_field(regs, FIELD_EN_PUSH),
+		.wake1 = get_field(regs, FIELD_WAKE1_TMR),
+		.wake2 = get_field(regs, FIELD_WAKE2_TMR),
+		.long_press = get_field(regs, FIELD_PB_LPRESS_ACTION),
+	};
+
+	return TRACE_END(dev, GET_WAKE_CONFIG, true);
+}
+
+bool bq25180_dev_enter_power_mode(struct bq25180 *dev,
+		enum bq25180_power_mode mode, bool wait_vin_removal)
+{
+	uint8_t regs[NR_REGISTERS];
+
+	assert(mode == BQ25180_POWER_SHUTDOWN || mode == BQ25180_POWER_SHIP);
+
+	TRACE_BEGIN(dev, ENTER_POWER_MODE);
+
+	if (!read_reg(dev, STAT0, &regs[STAT0])) {
+		return TRACE_END(dev, ENTER_POWER_MODE, false);
+	}
+
+	const bool vin = test_field(regs, FIELD_VIN_PGOOD_STAT);
+
+	if (vin && !wait_vin_removal) {
+		return TRACE_END(dev, ENTER_POWER_MODE, false);
+	}
+
+	/* EN_RST_SHIP takes the same codes as enum bq25180_power_mode */
+	if (!set_field(dev, FIELD_EN_RST_SHIP, (uint8_t)mode)) {
+		return TRACE_END(dev, ENTER_POWER_MODE, false);
+	}
+
+	dev->pending_mode = vin? mode : BQ25180_POWER_ACTIVE;
+
+	/* Gone already, to wake up with the reset defaults */
+	if (!vin && dev->shadow.enabled) {
+		seed_shadow(dev, reset_defaults);
+	}
+
+	return TRACE_END(dev, ENTER_POWER_MODE, true);
+}
+
+enum bq25180_power_mode bq25180_dev_get_pending_power_mode(
+		const struct bq25180 *dev)
+{
+	return dev->pending_mode;
+}
+
+bool bq25180_dev_enable_interrupt(struct bq25180 *dev, uint8_t mask)
+{
+	return TRACE(dev, ENABLE_INTERRUPT,
+			set_interrupts(dev, mask, 1));
+}
+
+bool bq25180_dev_disable_interrupt(struct bq25180 *dev, uint8_t mask)
+{
+	return TRACE(dev, DISABLE_INTERRUPT,
+			set_interrupts(dev, mask, 0));
+}
+
+void bq25180_get_default_config(struct bq25180_config *cfg)
+{
+	assert(cfg != NULL);
+
+	*cfg = (struct bq25180_config) {
+		.charging_enabled = true,
+		.battery_regulation_millivoltage = 4200,
+		.fastcharge_milliampere = 10,
+		.termination_pct = 10,
+		.double_precharge_current = true,
+		.precharge_threshold_millivoltage = 3000,
+		.battery_undervoltage_millivoltage = 3000,
+		.discharge_current = BQ25180_BAT_DISCHAGE_1000mA,
+		.input_milliampere = 500,
+		.vindpm = BQ25180_VINDPM_DISABLE,
+		.dppm_enabled = true,
+		.safety_timer = BQ25180_SAFETY_6H,
+		.watchdog = BQ25180_WDT_DEFAULT,
+		.sys_source = BQ25180_SYS_SRC_VIN_VBAT,
+		.sys_voltage = BQ25180_SYS_REG_V4_5,
+		.thermal_protection_enabled = true,
+		.ts = {
+			.hot = BQ25180_TS_HOT_60C,
+			.cold = BQ25180_TS_COLD_0C,
+			.warm_enabled = true,
+			.cool_enabled = true,
+			.cool_current = BQ25180_TS_ICHG_50PCT,
+			.warm_voltage = BQ25180_TS_VBATREG_MINUS_100mV,
+		},
+		.push_button_enabled = true,
+		.interrupts = BQ25180_INTR_VDPM | BQ25180_INTR_BATTERY_RANGE |
+				BQ25180_INTR_POWER_ERROR,
+	};
+}
+
+bool bq25180_dev_apply_config(struct bq25180 *dev,
+		const struct bq25180_config *cfg)
+{
+	uint8_t cur[NR_REGISTERS];
+	uint8_t image[NR_REGISTERS];
+
+	assert(cfg != NULL);
+	assert(cfg->battery_regulation_millivoltage >= MIN_BAT_REG_mV &&
+			cfg->battery_regulation_millivoltage <= MAX_BAT_REG_mV);
+	assert(cfg->battery_undervoltage_millivoltage >=
+			MIN_BAT_UNDERVOLTAGE_mV &&
+			cfg->battery_undervoltage_millivoltage <=
+			MAX_BAT_UNDERVOLTAGE_mV);
+	assert(cfg->fastcharge_milliampere >= MIN_IN_CURR_mA &&
+			cfg->fastcharge_milliampere <= MAX_IN_CURR_mA);
+
+	TRACE_BEGIN(dev, APPLY_CONFIG);
+
+	if (!read_config_regs(dev, cur)) {
+		return TRACE_END(dev, APPLY_CONFIG, false);
+	}
+
+	memcpy(image, cur, sizeof(image));
+	build_config_image(image, cfg);
+
+	return TRACE_END(dev, APPLY_CONFIG, write_changes(dev, cur, image));
+}
+
+bool bq25180_dev_get_config(struct bq25180 *dev,
+		struct bq25180_config *cfg, bool live)
+{
+	uint8_t regs[NR_REGISTERS] = { 0, };
+
+	assert(cfg != NULL);
+
+	TRACE_BEGIN(dev, GET_CONFIG);
+
+	if (live || !is_cached(dev, VBAT_CTRL)) {
+		if (bus_read(dev, VBAT_CTRL, &regs[VBAT_CTRL],
+				NR_REGISTERS - VBAT_CTRL) < 0) {
+			return TRACE_END(dev, GET_CONFIG, false);
+		}
+		if (dev->shadow.enabled) {
+			seed_shadow(dev, regs);
+		}
+	} else {
+		memcpy(regs, dev->shadow.regs, NR_REGISTERS);
+	}
+
+	bq25180_decode_config(regs, cfg);
+
+	return TRACE_END(dev, GET_CONFIG, true);
+}
+
+bool bq25180_dev_apply_config_image(struct bq25180 *dev,
+		const uint8_t image[BQ25180_CONFIG_IMAGE_LEN])
+{
+	uint8_t cur[NR_REGISTERS];
+	uint8_t regs[NR_REGISTERS];
+
+	assert(image != NULL);
+
+	TRACE_BEGIN(dev, APPLY_CONFIG);
+
+	if (!read_config_regs(dev, cur)) {
+		return TRACE_END(dev, APPLY_CONFIG, false);
+	}
+
+	memcpy(regs, cur, sizeof(regs));
+	memcpy(&regs[VBAT_CTRL], image, BQ25180_CONFIG_IMAGE_LEN);
+	regs[SHIP_RST] &= (uint8_t)~SHIP_RST_SELF_CLEARING;
+
+	return TRACE_END(dev, APPLY_CONFIG, write_changes(dev, cur, regs));
+}
+
+void bq25180_get_config_image(const struct bq25180_config *cfg,
+		uint8_t image[BQ25180_CONFIG_IMAGE_LEN])
+{
+	uint8_t regs[NR_REGISTERS];
+
+	assert(cfg != NULL && image != NULL);
+
+	memcpy(regs, reset_defaults, sizeof(regs));
+	build_config_image(regs, cfg);
+	memcpy(image, &regs[VBAT_CTRL], BQ25180_CONFIG_IMAGE_LEN);
+}
+
+static uint8_t crc8(const uint8_t *data, size_t len)
+{
+	uint8_t crc = 0;
+
+	for (size_t i = 0; i < len; i++) {
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++) {
+			const unsigned int shifted = (unsigned int)crc << 1;
+			crc = (uint8_t)((crc & 0x80U)?
+					shifted ^ 0x07U : shifted);
+		}
+	}
+
+	return crc;
+}
+
+void bq25180_encode_config_blob(const uint8_t image[BQ25180_CONFIG_IMAGE_LEN],
+		uint8_t blob[BQ25180_CONFIG_BLOB_LEN])
+{
+	assert(image != NULL && blob != NULL);
+
+	blob[0] = BQ25180_CONFIG_BLOB_VERSION;
+	memcpy(&blob[1], image, BQ25180_CONFIG_IMAGE_LEN);
+	blob[BQ25180_CONFIG_BLOB_LEN - 1] =
+		crc8(blob, BQ25180_CONFIG_BLOB_LEN - 1);
+}
+
+bool bq25180_decode_config_blob(const uint8_t blob[BQ25180_CONFIG_BLOB_LEN],
+		uint8_t image[BQ25180_CONFIG_IMAGE_LEN])
+{
+	assert(blob != NULL && image != NULL);
+
+	if (blob[0] != BQ25180_CONFIG_BLOB_VERSION ||
+			blob[BQ25180_CONFIG_BLOB_LEN - 1] !=
+			crc8(blob, BQ25180_CONFIG_BLOB_LEN - 1)) {
+		return false;
+	}
+
+	memcpy(image, &blob[1], BQ25180_CONFIG_IMAGE_LEN);
+
+	return true;
+}
+
+bool bq25180_dev_restore_config_image(struct bq25180 *dev,
+		const uint8_t image[BQ25180_CONFIG_IMAGE_LEN], bool *restored)
+{
+	uint8_t regs[NR_REGISTERS];
+	uint8_t first = NR_REGISTERS;
+	uint8_t last = 0;
+	uint8_t val;
+
+	assert(image != NULL);
+
+	if (restored) {
+		*restored = false;
+	}
+
+	memcpy(regs, reset_defaults, sizeof(regs));
+	memcpy(&regs[VBAT_CTRL], image, BQ25180_CONFIG_IMAGE_LEN);
+	regs[SHIP_RST] &= (uint8_t)~SHIP_RST_SELF_CLEARING;
+
+	for (uint8_t reg = VBAT_CTRL; reg < NR_REGISTERS; reg++) {
+		if (regs[reg] != reset_defaults[reg]) {
+			first = first < reg? first : reg;
+			last = reg;
+		}
+	}
+
+	/* A reset leaves nothing to restore */
+	if (first == NR_REGISTERS) {
+		return true;
+	}
+
+	TRACE_BEGIN(dev, RESTORE_CONFIG);
+
+	/* Straight from the device as the shadow does not know of the reset */
+	if (!read_reg(dev, first, &val)) {
+		return TRACE_END(dev, RESTORE_CONFIG, false);
+	}
+	if (val != reset_defaults[first]) {
+		return TRACE_END(dev, RESTORE_CONFIG, true);
+	}
+
+	/* Defaults in between get rewritten in favor of a single transaction */
+	if (!write_regs(dev, first, &regs[first], (size_t)(last - first + 1))) {
+		return TRACE_END(dev, RESTORE_CONFIG, false);
+	}
+
+	if (dev->shadow.enabled) {
+		seed_shadow(dev, regs);
+	}
+	if (restored) {
+		*restored = true;
+	}
+
+	return TRACE_END(dev, RESTORE_CONFIG, true);
+}
+
+static bool probe(struct bq25180 *dev,
+		const uint8_t image[BQ25180_CONFIG_IMAGE_LEN],
+		struct bq25180_probe_report *report, uint8_t *transactions)
+{
+	uint8_t cur[NR_REGISTERS];
+	uint8_t regs[NR_REGISTERS];
+	uint8_t first = NR_REGISTERS;
+	uint8_t last = 0;
+
+	(*transactions)++;
+	if (bus_read(dev, VBAT_CTRL, &cur[VBAT_CTRL],
+			NR_REGISTERS - VBAT_CTRL) < 0) {
+		return false;
+	}
+
+	cur[SHIP_RST] &= (uint8_t)~SHIP_RST_SELF_CLEARING;
+	report->device_id = get_field(cur, FIELD_DEVICE_ID);
+	report->at_reset_defaults = memcmp(&cur[VBAT_CTRL],
+			&reset_defaults[VBAT_CTRL],
+			NR_REGISTERS - VBAT_CTRL) == 0;
+
+	if (report->device_id != BQ25180_DEVICE_ID) {
+		return false;
+	}
+
+	memcpy(regs, cur, sizeof(regs));
+	if (image) {
+		memcpy(&regs[VBAT_CTRL], image, BQ25180_CONFIG_IMAGE_LEN);
+		regs[SHIP_RST] &= (uint8_t)~SHIP_RST_SELF_CLEARING;
+	}
+
+	for (uint8_t reg = VBAT_CTRL; reg < NR_REGISTERS; reg++) {
+		if (regs[reg] != cur[reg]) {
+			first = first < reg? first : reg;
+			last = reg;
+		}
+	}
+
+	/* Unchanged ones in between get rewritten in favor of a single
+	 * transaction */
+	if (first != NR_REGISTERS) {
+		(*transactions)++;
+		if (!write_regs(dev, first, &regs[first],
+				(size_t)(last - first + 1))) {
+			return false;
+		}
+	}
+
+	if (dev->shadow.enabled) {
+		seed_shadow(dev, regs);
+	}
+
+	return true;
+}
+
+bool bq25180_dev_probe(struct bq25180 *dev,
+		const uint8_t image[BQ25180_CONFIG_IMAGE_LEN],
+		struct bq25180_probe_report *report)
+{
+	struct bq25180_probe_report tmp = { 0, };
+	const uint32_t retries = dev->retry.stats.retries;
+	uint8_t transactions = 0;
+
+	TRACE_BEGIN(dev, PROBE);
+
+	const bool ok = probe(dev, image, &tmp, &transactions);
+
+	if (report) {
+		*report = tmp;
+		report->transactions = (uint8_t)(transactions +
+				(dev->retry.stats.retries - retries));
+	}
+
+	return TRACE_END(dev, PROBE, ok);
+}
+
+void bq25180_dev_register_interrupt_callback(struct bq25180 *dev, uint8_t mask,
+		bq25180_intr_callback_t func, void *ctx)
+{
+	for (uint8_t i = 0; i < BQ25180_NR_INTERRUPTS; i++) {
+		if (mask & (1U << i)) {
+			dev->irq.callbacks[i].func = func;
+			dev->irq.callbacks[i].ctx = ctx;
+		}
+	}
+}
+
+void bq25180_dev_notify_interrupt(struct bq25180 *dev)
+{
+	dev->irq.pending = true;
+}
+
+bool bq25180_dev_process_interrupt(struct bq25180 *dev)
+{
+	uint8_t regs[FLAG0 + 1];
+	struct bq25180_state state;
+	struct bq25180_event event;
+
+	if (!dev->irq.pending) {
+		return true;
+	}
+
+	TRACE_BEGIN(dev, PROCESS_INTERRUPT);
+
+	/* Any pulse coming after this point is served in the next run as the
+	 * registers below may be read before the event gets latched. */
+	dev->irq.pending = false;
+
+	if (bus_read(dev, STAT0, regs, sizeof(regs)) < 0) {
+		dev->irq.pending = true;
+		return TRACE_END(dev, PROCESS_INTERRUPT, false);
+	}
+
+	track_status(dev, regs[STAT0]);
+
+	const uint8_t fired =
+		get_fired_interrupts(dev, regs[STAT0], regs[FLAG0]);
+	dev->irq.stat0 = regs[STAT0];
+
+	bq25180_decode_state(regs[STAT0], regs[STAT1], &state);
+	bq25180_decode_event(regs[FLAG0], &event);
+
+	for (uint8_t i = 0; i < BQ25180_NR_INTERRUPTS; i++) {
+		if ((fired & (1U << i)) && dev->irq.callbacks[i].func) {
+			dev->irq.callbacks[i].func((enum bq25180_intr)(1U << i),
+					&state, &event,
+					dev->irq.callbacks[i].ctx);
+		}
+	}
+
+	return TRACE_END(dev, PROCESS_INTERRUPT, true);
+}
+
+void bq25180_dev_set_retry_policy(struct bq25180 *dev,
+		const struct bq25180_retry_policy *policy)
+{
+	dev->retry.policy = policy;
+}
+
+void bq25180_dev_get_retry_stats(const struct bq25180 *dev,
+		struct bq25180_retry_stats *stats)
+{
+	assert(stats != NULL);
+	*stats = dev->retry.stats;
+}
+
+void bq25180_dev_clear_retry_stats(struct bq25180 *dev)
+{
+	memset(&dev->retry.stats, 0, sizeof(dev->retry.stats));
+}
+
+#if defined(BQ25180_TRACE)
+void bq25180_dev_set_trace_hooks(struct bq25180 *dev,
+		const struct bq25180_trace_hooks *hooks)
+{
+	dev->trace.hooks = hooks;
+}
+
+void bq25180_dev_get_trace_counters(const struct bq25180 *dev,
+		struct bq25180_trace_counters *counters)
+{
+	assert(counters != NULL);
+	*counters = dev->trace.counters;
+}
+
+void bq25180_dev_clear_trace_counters(struct bq25180 *dev)
+{
+	memset(&dev->trace.counters, 0, sizeof(dev->trace.counters));
+}
+#endif
@@ -15,7 +15,16 @@ extern "C" {
 #include <stdint.h>
 #include <stddef.h>
 
+#include "bq25180_trace.h"
+
 #define BQ25180_DEVICE_ADDRESS		0x6A /* 7-bit addressing only */
+#define BQ25180_DEVICE_ID		0 /* DEVICE_ID in MASK_ID */
+
+#define BQ25180_NR_REGISTERS		13 /* STAT0 to MASK_ID */
+#define BQ25180_NR_INTERRUPTS		7
+#define BQ25180_CONFIG_IMAGE_LEN	10 /* VBAT_CTRL to MASK_ID */
+#define BQ25180_CONFIG_BLOB_LEN		(BQ25180_CONFIG_IMAGE_LEN + 2)
+#define BQ25180_CONFIG_BLOB_VERSION	1
 
 enum bq25180_sys_source {
 	BQ25180_SYS_SRC_VIN_VBAT, /**< Powered from VIN if present or VBAT */
@@ -49,6 +58,42 @@ enum bq25180_safety_timer {
 	BQ25180_SAFETY_DISABLE, /**< disable safty timer */
 };
 
+/** Upper threshold above which charging is suspended */
+enum bq25180_ts_hot {
+	BQ25180_TS_HOT_60C,
+	BQ25180_TS_HOT_65C,
+	BQ25180_TS_HOT_50C,
+	BQ25180_TS_HOT_45C,
+};
+
+/** Lower threshold below which charging is suspended */
+enum bq25180_ts_cold {
+	BQ25180_TS_COLD_0C,
+	BQ25180_TS_COLD_3C,
+	BQ25180_TS_COLD_5C,
+	BQ25180_TS_COLD_MINUS_3C,
+};
+
+/** Fast charge current in the cool zone */
+enum bq25180_ts_current {
+	BQ25180_TS_ICHG_50PCT, /**< half of the fast charge current */
+	BQ25180_TS_ICHG_20PCT, /**< a fifth of the fast charge current */
+};
+
+/** Battery regulation voltage in the warm zone */
+enum bq25180_ts_voltage {
+	BQ25180_TS_VBATREG_MINUS_100mV,
+	BQ25180_TS_VBATREG_MINUS_200mV,
+};
+
+/** Temperature zone reported in @ref bq25180_state.ts_status */
+enum bq25180_ts_zone {
+	BQ25180_TS_ZONE_NORMAL,
+	BQ25180_TS_ZONE_HOT_OR_COLD, /**< charging suspended */
+	BQ25180_TS_ZONE_COOL, /**< reduced current */
+	BQ25180_TS_ZONE_WARM, /**< reduced voltage */
+};
+
 enum bq25180_watchdog {
 	BQ25180_WDT_DEFAULT, /**< 160s hardware reset */
 	BQ25180_WDT_160_SEC, /**< 160s hardware reset */
@@ -63,6 +108,33 @@ enum bq25180_vindpm {
 	BQ25180_VINDPM_DISABLE,
 };
 
+/** Lowest power states and what wakes the device up from them */
+enum bq25180_power_mode {
+	BQ25180_POWER_ACTIVE, /**< no request */
+	BQ25180_POWER_SHUTDOWN, /**< wakes up on VIN only */
+	BQ25180_POWER_SHIP, /**< wakes up on VIN or the push button */
+};
+
+/** Push button press to wake the device up from shipmode */
+enum bq25180_wake1 {
+	BQ25180_WAKE1_300ms,
+	BQ25180_WAKE1_1000ms,
+};
+
+/** Push button long press to take @ref bq25180_pb_action */
+enum bq25180_wake2 {
+	BQ25180_WAKE2_2000ms,
+	BQ25180_WAKE2_3600ms,
+};
+
+/** What a long press of the push button does */
+enum bq25180_pb_action {
+	BQ25180_PB_NOTHING,
+	BQ25180_PB_HARDWARE_RESET,
+	BQ25180_PB_SHIPMODE,
+	BQ25180_PB_SHUTDOWN,
+};
+
 enum bq25180_intr {
 	BQ25180_INTR_CHARGING_STATUS		= 0x01,
 	BQ25180_INTR_CURRENT_LIMIT		= 0x02,
@@ -109,43 +181,357 @@ struct bq25180_state {
 	uint16_t vin_overvoltage_active     : 1;
 };
 
+/**
+ * @brief Interrupt callback
+ *
+ * @param[in] intr the interrupt fired, one of @ref bq25180_intr
+ * @param[in] state @ref bq25180_state read along with the interrupt
+ * @param[in] event @ref bq25180_event read along with the interrupt
+ * @param[in] ctx user context given on registration
+ */
+typedef void (*bq25180_intr_callback_t)(enum bq25180_intr intr,
+		const struct bq25180_state *state,
+		const struct bq25180_event *event, void *ctx);
+
+struct bq25180_bus {
+	/**
+	 * @brief Read registers
+	 *
+	 * @param[in] ctx bus context given to @ref bq25180_dev_init
+	 * @param[in] addr device address
+	 * @param[in] reg register address to read from
+	 * @param[in] buf buffer to get the value in
+	 * @param[in] bufsize size of @p buf
+	 *
+	 * @return The number of bytes read on success. Otherwise a negative
+	 *         integer error code
+	 */
+	int (*read)(void *ctx, uint8_t addr, uint8_t reg,
+			void *buf, size_t bufsize);
+	/**
+	 * @brief Write registers
+	 *
+	 * @param[in] ctx bus context given to @ref bq25180_dev_init
+	 * @param[in] addr device address
+	 * @param[in] reg register address to write to
+	 * @param[in] data data to be written in @p reg
+	 * @param[in] data_len length of @p data
+	 *
+	 * @return The number of bytes written on success. Otherwise a negative
+	 *         integer error code
+	 */
+	int (*write)(void *ctx, uint8_t addr, uint8_t reg,
+			const void *data, size_t data_len);
+};
+
+/**
+ * @brief Retry policy applied to every bus transaction
+ *
+ * A failed transaction is attempted again up to @ref max_retries times as a
+ * whole, calling @ref backoff in between. All the register accesses of the
+ * driver are idempotent, so repeating one is harmless.
+ */
+struct bq25180_retry_policy {
+	uint8_t max_retries; /**< 0 not to retry at all */
+	/**
+	 * @brief Wait or recover the bus before the next attempt
+	 *
+	 * This is the place to delay, or to clock out a stuck slave and
+	 * reinitialize the controller. Can be NULL.
+	 *
+	 * @param[in] ctx @ref ctx
+	 * @param[in] attempt retry count starting from 1
+	 * @param[in] err negative error code of the last attempt
+	 */
+	void (*backoff)(void *ctx, uint8_t attempt, int err);
+	/**
+	 * @brief Get a monotonic time in any unit
+	 *
+	 * Needed only for @ref budget and the retry time statistics. Can be
+	 * NULL.
+	 */
+	uint32_t (*get_time)(void *ctx);
+	/** retries stop once this much time of @ref get_time has passed since
+	 * the first failure of a transaction. 0 for no limit */
+	uint32_t budget;
+	void *ctx; /**< context to be passed to the callbacks */
+};
+
+struct bq25180_retry_stats {
+	uint32_t retries; /**< transactions attempted again */
+	uint32_t retried_bytes; /**< bytes transferred again */
+	uint32_t retry_time; /**< time spent retrying in get_time unit */
+	uint32_t failures; /**< transactions given up */
+	uint32_t budget_overruns; /**< retries cut short by the budget */
+};
+
+/**
+ * @brief Device handle
+ *
+ * Every instance keeps its own bus and state, so that multiple devices can be
+ * served independently. Members are private to the driver. Initialize it with
+ * @ref bq25180_dev_init.
+ */
+struct bq25180 {
+	const struct bq25180_bus *bus;
+	void *bus_ctx;
+	uint8_t addr;
+
+	/* Only the control registers are shadowed. STAT0, STAT1 and FLAG0
+	 * change behind the host's back, FLAG0 even gets cleared on read. */
+	struct {
+		uint8_t regs[BQ25180_NR_REGISTERS];
+		bool enabled;
+	} shadow;
+
+	struct {
+		volatile bool pending;
+		uint8_t stat0; /* last seen to tell CHG_STAT/PGOOD changes */
+		bool primed; /* stat0 is valid */
+		struct {
+			bq25180_intr_callback_t func;
+			void *ctx;
+		} callbacks[BQ25180_NR_INTERRUPTS];
+	} irq;
+
+	struct {
+		const struct bq25180_retry_policy *policy;
+		struct bq25180_retry_stats stats;
+	} retry;
+
+	/* Requested while VIN was present, entered once it is removed */
+	enum bq25180_power_mode pending_mode;
+
+#if defined(BQ25180_TRACE)
+	struct {
+		const struct bq25180_trace_hooks *hooks;
+		uint32_t op_started;
+		uint32_t bus_started;
+		struct bq25180_trace_counters counters;
+	} trace;
+#endif
+};
+
+/** Thermistor thresholds and what the device does in between */
+struct bq25180_ts_config {
+	enum bq25180_ts_hot hot;
+	enum bq25180_ts_cold cold;
+	bool warm_enabled; /**< reduce the voltage above 45C */
+	bool cool_enabled; /**< reduce the current below 10C */
+	enum bq25180_ts_current cool_current;
+	enum bq25180_ts_voltage warm_voltage;
+};
+
+/** Push button settings, kept in SHIP_RST */
+struct bq25180_wake_config {
+	bool push_button_enabled; /**< on battery only */
+	enum bq25180_wake1 wake1;
+	enum bq25180_wake2 wake2;
+	enum bq25180_pb_action long_press;
+};
+
+struct bq25180_config {
+	bool charging_enabled;
+	uint16_t battery_regulation_millivoltage; /**< 3500mV to 4650mV */
+	uint16_t fastcharge_milliampere; /**< 5mA to 1000mA */
+	uint8_t termination_pct; /**< percentage of the fast charge current */
+	bool double_precharge_current; /**< double of termination current */
+	uint16_t precharge_threshold_millivoltage; /**< 2800mV or 3000mV */
+	uint16_t battery_undervoltage_millivoltage; /**< 2000mV to 3000mV */
+	enum bq25180_bat_discharge_current discharge_current;
+	uint16_t input_milliampere; /**< 50mA to 1100mA */
+	enum bq25180_vindpm vindpm;
+	bool dppm_enabled;
+	enum bq25180_safety_timer safety_timer;
+	enum bq25180_watchdog watchdog;
+	enum bq25180_sys_source sys_source;
+	enum bq25180_sys_regulation sys_voltage;
+	bool thermal_protection_enabled;
+	struct bq25180_ts_config ts; /**< effective with thermal protection */
+	bool push_button_enabled;
+	uint8_t interrupts; /**< enabled interrupts of @ref bq25180_intr */
+};
+
+/** Raw contents of every register from STAT0 to MASK_ID, read at once */
+struct bq25180_dump {
+	uint8_t regs[BQ25180_NR_REGISTERS];
+};
+
+/** @ref bq25180_dump decoded by @ref bq25180_decode_dump */
+struct bq25180_dump_info {
+	struct bq25180_state state;
+	struct bq25180_event event;
+	struct bq25180_config config;
+	uint8_t device_id;
+};
+
+/** What @ref bq25180_dev_probe found and how much it took */
+struct bq25180_probe_report {
+	uint8_t device_id;
+	/** VBAT_CTRL to MASK_ID read as the reset values, as on a cold boot */
+	bool at_reset_defaults;
+	uint8_t transactions; /**< bus transactions made, retries included */
+};
+
+/**
+ * @brief Initialize a device handle
+ *
+ * No bus access is made. Any state kept in @p dev is cleared.
+ *
+ * @param[in] dev device handle
+ * @param[in] addr device address. @ref BQ25180_DEVICE_ADDRESS unless
+ *            translated on the way
+ * @param[in] bus @ref bq25180_bus to reach the device
+ * @param[in] bus_ctx context to be passed to @p bus
+ */
+void bq25180_dev_init(struct bq25180 *dev, uint8_t addr,
+		const struct bq25180_bus *bus, void *bus_ctx);
+
 /**
  * @brief Reset the system
  *
  * The device will reset all of the registers to the defaults. A hardware reset
  * to completely powercycle the system.
  *
+ * @param[in] dev device handle
  * @param[in] hardware_reset hardware reset if true while soft reset if false
  *
+ * @return true on success or false
+ *
  * @note A hardware or software reset will cancel the pending shipmode request.
+ *       See @ref bq25180_dev_enter_power_mode.
+ */
+bool bq25180_dev_reset(struct bq25180 *dev, bool hardware_reset);
+
+/**
+ * @brief Enable the register shadow
+ *
+ * Once enabled, the control registers from VBAT_CTRL to MASK_ID are kept in
+ * the driver and get written without being read back first. The status and
+ * flag registers are never cached.
+ *
+ * @param[in] dev device handle
+ * @param[in] read_device seed the shadow with a single burst read from the
+ *            device if true, or with the reset defaults if false
+ *
+ * @return true on success or false
+ *
+ * @note Seeding with the reset defaults is valid only right after power-on or
+ *       reset. The shadow goes stale when the watchdog timer expires as all
+ *       charger parameters get reset to the defaults behind the driver.
+ *       @ref bq25180_dev_restore_config_image re-seeds it.
+ */
+bool bq25180_dev_enable_cache(struct bq25180 *dev, bool read_device);
+
+/**
+ * @brief Disable the register shadow
+ *
+ * Every register access goes to the device again afterward.
+ *
+ * @param[in] dev device handle
  */
-void bq25180_reset(bool hardware_reset);
+void bq25180_dev_disable_cache(struct bq25180 *dev);
 
 /**
  * @brief Read the device events
  *
+ * @param[in] dev device handle
  * @param[in] p @ref bq25180_event
  *
  * @return true on success or false
  */
-bool bq25180_read_event(struct bq25180_event *p);
+bool bq25180_dev_read_event(struct bq25180 *dev, struct bq25180_event *p);
 
 /**
  * @brief Read the device state
  *
+ * STAT0 and STAT1 are read in one burst. FLAG0 is left untouched.
+ *
+ * @param[in] dev device handle
  * @param[in] p @ref bq25180_state
  *
  * @return true on success or false
  */
-bool bq25180_read_state(struct bq25180_state *p);
+bool bq25180_dev_read_state(struct bq25180 *dev, struct bq25180_state *p);
+
+/**
+ * @brief Read the device state and events in a single bus transaction
+ *
+ * STAT0, STAT1 and FLAG0 are contiguous, so they are read in one burst
+ * instead of @ref bq25180_dev_read_state followed by
+ * @ref bq25180_dev_read_event.
+ *
+ * @param[in] dev device handle
+ * @param[out] state @ref bq25180_state or NULL if not interested
+ * @param[out] event @ref bq25180_event or NULL if not interested
+ *
+ * @return true on success or false
+ *
+ * @note FLAG0 gets cleared by the device when read. It is read, and therefore
+ *       cleared, only when @p event is not NULL. Otherwise only STAT0 and STAT1
+ *       are read in a burst, leaving the pending events untouched.
+ */
+bool bq25180_dev_read_snapshot(struct bq25180 *dev,
+		struct bq25180_state *state, struct bq25180_event *event);
+
+/**
+ * @brief Read every register in a single bus transaction
+ *
+ * STAT0 to MASK_ID are read in one burst, for diagnostics. The register
+ * shadow, if enabled, gets refreshed with what is read.
+ *
+ * @param[in] dev device handle
+ * @param[out] dump @ref bq25180_dump
+ *
+ * @return true on success or false
+ *
+ * @note FLAG0 gets cleared by the device when read, the same as
+ *       @ref bq25180_dev_read_event.
+ */
+bool bq25180_dev_dump(struct bq25180 *dev, struct bq25180_dump *dump);
+
+/**
+ * @brief Decode a register dump
+ *
+ * No bus access is made.
+ *
+ * @param[in] dump @ref bq25180_dump
+ * @param[out] info @ref bq25180_dump_info
+ */
+void bq25180_decode_dump(const struct bq25180_dump *dump,
+		struct bq25180_dump_info *info);
+
+/**
+ * @brief Format a register dump into a single line of text for logs
+ *
+ * The line holds the key settings in units followed by the raw registers in
+ * hex, for example:
+ *
+ *   chg=0 pg=0 flag=00 vreg=4200mV ichg=10mA iterm=10% ilim=500mA
+ *   buvlo=3000mV id=0 regs=000000460...
+ *
+ * without the line break.
+ *
+ * @param[in] dump @ref bq25180_dump
+ * @param[out] buf buffer to put the text in, always null-terminated
+ * @param[in] bufsize size of @p buf
+ *
+ * @return the length of the whole line as snprintf() does. Truncated if not
+ *         less than @p bufsize
+ */
+int bq25180_format_dump(const struct bq25180_dump *dump,
+		char *buf, size_t bufsize);
 
 /**
  * @brief Enable or disable battery charging
  *
+ * @param[in] dev device handle
  * @param[in] enable battery charging to be enabled if true or false to be
  *                   disabled
+ *
+ * @return true on success or false
  */
-void bq25180_enable_battery_charging(bool enable);
+bool bq25180_dev_enable_battery_charging(struct bq25180 *dev, bool enable);
 
 /**
  * @brief Set the safety time
@@ -158,9 +544,13 @@ void bq25180_enable_battery_charging(bool enable);
  *
  * 6 hour by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] opt one of @ref bq25180_safety_timer
+ *
+ * @return true on success or false
  */
-void bq25180_set_safety_timer(enum bq25180_safety_timer opt);
+bool bq25180_dev_set_safety_timer(struct bq25180 *dev,
+		enum bq25180_safety_timer opt);
 
 /**
  * @brief Set the watchdog time
@@ -169,12 +559,17 @@ void bq25180_set_safety_timer(enum bq25180_safety_timer opt);
  * watchdog timer is reset by any transaction by the host using the I2C
  * interface. If the watchdog timer expires without a reset from the I2C
  * interface, all charger parameters registers are reset to the default values.
+ * @ref bq25180_dev_restore_config_image tells that and puts them back.
  *
  * 160 sec by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] opt one of @ref bq25180_watchdog
+ *
+ * @return true on success or false
  */
-void bq25180_set_watchdog_timer(enum bq25180_watchdog opt);
+bool bq25180_dev_set_watchdog_timer(struct bq25180 *dev,
+		enum bq25180_watchdog opt);
 
 /**
  * @brief Set the battery regulation target
@@ -184,18 +579,39 @@ void bq25180_set_watchdog_timer(enum bq25180_watchdog opt);
  *
  * 4200mV by default on reset.
  * 
+ * @param[in] dev device handle
  * @param[in] millivoltage from 3500mV up to 4650mV
+ *
+ * @return true on success or false
  */
-void bq25180_set_battery_regulation_voltage(uint16_t millivoltage);
+bool bq25180_dev_set_battery_regulation_voltage(struct bq25180 *dev,
+		uint16_t millivoltage);
+
+/**
+ * @brief Get the battery regulation voltage
+ *
+ * Served from the register shadow without bus access if enabled, or read
+ * from the device otherwise.
+ *
+ * @param[in] dev device handle
+ * @param[out] millivoltage the battery regulation voltage in millivolts
+ *
+ * @return true on success or false
+ */
+bool bq25180_dev_get_battery_regulation_voltage(struct bq25180 *dev,
+		uint16_t *millivoltage);
 
 /**
  * @brief Set the battery discharge current limit
  *
  * @ref BQ25180_BAT_DISCHAGE_500mA by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] opt one of @ref bq25180_bat_discharge_current
+ *
+ * @return true on success or false
  */
-void bq25180_set_battery_discharge_current(
+bool bq25180_dev_set_battery_discharge_current(struct bq25180 *dev,
 		enum bq25180_bat_discharge_current opt);
 
 /**
@@ -214,18 +630,26 @@ void bq25180_set_battery_discharge_current(
  *
  * 3000mV by default on reset.
  * 
+ * @param[in] dev device handle
  * @param[in] millivoltage from 2000mV up to 3000mV
+ *
+ * @return true on success or false
  */
-void bq25180_set_battery_under_voltage(uint16_t millivoltage);
+bool bq25180_dev_set_battery_under_voltage(struct bq25180 *dev,
+		uint16_t millivoltage);
 
 /**
  * @brief Set the precharge voltage threshold
  *
  * 3000mV by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] millivoltage either of 2800mV or 3000mV only
+ *
+ * @return true on success or false
  */
-void bq25180_set_precharge_threshold(uint16_t millivoltage);
+bool bq25180_dev_set_precharge_threshold(struct bq25180 *dev,
+		uint16_t millivoltage);
 
 /**
  * @brief Set the precharge current 
@@ -233,28 +657,53 @@ void bq25180_set_precharge_threshold(uint16_t millivoltage);
  * The precharge current is the same to the termination current by default on
  * reset.
  *
+ * @param[in] dev device handle
  * @param[in] double_termination_current double of termination current if true
  *            or same to the termination current if false
+ *
+ * @return true on success or false
  */
-void bq25180_set_precharge_current(bool double_termination_current);
+bool bq25180_dev_set_precharge_current(struct bq25180 *dev,
+		bool double_termination_current);
 
 /**
  * @brief Set the maximum charge current level
  *
  * 10mA by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] milliampere from 5mA up to 1000mA
+ *
+ * @return true on success or false
  */
-void bq25180_set_fastcharge_current(uint16_t milliampere);
+bool bq25180_dev_set_fastcharge_current(struct bq25180 *dev,
+		uint16_t milliampere);
+
+/**
+ * @brief Get the maximum charge current level
+ *
+ * Served from the register shadow without bus access if enabled, or read
+ * from the device otherwise.
+ *
+ * @param[in] dev device handle
+ * @param[out] milliampere the fast charge current in milliamperes
+ *
+ * @return true on success or false
+ */
+bool bq25180_dev_get_fastcharge_current(struct bq25180 *dev,
+		uint16_t *milliampere);
 
 /**
  * @brief Set the termination current
  *
  * 10% by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] pct percentage of the maximum charge current level
+ *
+ * @return true on success or false
  */
-void bq25180_set_termination_current(uint8_t pct);
+bool bq25180_dev_set_termination_current(struct bq25180 *dev, uint8_t pct);
 
 /**
  * @brief Enable or disable Input Voltage Based Dynamic Power Management
@@ -264,18 +713,24 @@ void bq25180_set_termination_current(uint8_t pct);
  *
  * This feature is disbled by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] opt @ref bq25180_vindpm
+ *
+ * @return true on success or false
  */
-void bq25180_enable_vindpm(enum bq25180_vindpm opt);
+bool bq25180_dev_enable_vindpm(struct bq25180 *dev, enum bq25180_vindpm opt);
 
 /**
  * @brief Enable of disable Dynamic Power Path Management Mode
  *
  * This feature is enabled by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] enable true to enable, false to disable
+ *
+ * @return true on success or false
  */
-void bq25180_enable_dppm(bool enable);
+bool bq25180_dev_enable_dppm(struct bq25180 *dev, bool enable);
 
 /**
  * @brief Set the maximum input current
@@ -285,9 +740,25 @@ void bq25180_enable_dppm(bool enable);
  *
  * 500mA by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] milliampere from 50mA up to 1100mA
+ *
+ * @return true on success or false
  */
-void bq25180_set_input_current(uint16_t milliampere);
+bool bq25180_dev_set_input_current(struct bq25180 *dev, uint16_t milliampere);
+
+/**
+ * @brief Get the maximum input current
+ *
+ * Served from the register shadow without bus access if enabled, or read
+ * from the device otherwise.
+ *
+ * @param[in] dev device handle
+ * @param[out] milliampere the input current limit in milliamperes
+ *
+ * @return true on success or false
+ */
+bool bq25180_dev_get_input_current(struct bq25180 *dev, uint16_t *milliampere);
 
 /**
  * @brief Set regulated system voltage source
@@ -296,51 +767,393 @@ void bq25180_set_input_current(uint16_t milliampere);
  *
  * @ref BQ25180_SYS_SRC_VIN_VBAT by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] source one of @ref bq25180_sys_source
+ *
+ * @return true on success or false
  */
-void bq25180_set_sys_source(enum bq25180_sys_source source);
+bool bq25180_dev_set_sys_source(struct bq25180 *dev,
+		enum bq25180_sys_source source);
+
+/**
+ * @brief Get regulated system voltage source
+ *
+ * Served from the register shadow without bus access if enabled, or read
+ * from the device otherwise.
+ *
+ * @param[in] dev device handle
+ * @param[out] source one of @ref bq25180_sys_source
+ *
+ * @return true on success or false
+ */
+bool bq25180_dev_get_sys_source(struct bq25180 *dev,
+		enum bq25180_sys_source *source);
 
 /**
  * @brief Set SYS regulation voltgage
  *
  * @ref BQ25180_SYS_REG_V4_4 by default on reset.
  *
+ * @param[in] dev device handle
  * @param[in] val one of @ref bq25180_sys_regulation
+ *
+ * @return true on success or false
  */
-void bq25180_set_sys_voltage(enum bq25180_sys_regulation val);
+bool bq25180_dev_set_sys_voltage(struct bq25180 *dev,
+		enum bq25180_sys_regulation val);
 
 /**
  * @brief Enable or disable thermal protection
  *
+ * @param[in] dev device handle
  * @param[in] enable enable if true or disable if false
+ *
+ * @return true on success or false
+ */
+bool bq25180_dev_enable_thermal_protection(struct bq25180 *dev, bool enable);
+
+/**
+ * @brief Set the thermistor thresholds and the zone behaviors
+ *
+ * TS_CONTROL is written as a whole without being read first.
+ *
+ * @param[in] dev device handle
+ * @param[in] ts @ref bq25180_ts_config
+ *
+ * @return true on success or false
+ *
+ * @note Nothing happens unless the thermal protection is enabled by
+ *       @ref bq25180_dev_enable_thermal_protection.
+ */
+bool bq25180_dev_set_ts_control(struct bq25180 *dev,
+		const struct bq25180_ts_config *ts);
+
+/**
+ * @brief Get the thermistor thresholds and the zone behaviors
+ *
+ * @param[in] dev device handle
+ * @param[out] ts @ref bq25180_ts_config
+ *
+ * @return true on success or false
  */
-void bq25180_enable_thermal_protection(bool enable);
+bool bq25180_dev_get_ts_control(struct bq25180 *dev,
+		struct bq25180_ts_config *ts);
 
 /**
  * @brief Enable or disable push button on battery only
  *
+ * @param[in] dev device handle
  * @param[in] enable enable if true or disable if false
+ *
+ * @return true on success or false
  */
-void bq25180_enable_push_button(bool enable);
+bool bq25180_dev_enable_push_button(struct bq25180 *dev, bool enable);
+
+/**
+ * @brief Set the push button timings and the long press action
+ *
+ * The fields of SHIP_RST other than the reset and shipmode requests are
+ * written at once.
+ *
+ * @ref BQ25180_WAKE1_300ms, @ref BQ25180_WAKE2_2000ms and
+ * @ref BQ25180_PB_SHIPMODE with the push button enabled by default on reset.
+ *
+ * @param[in] dev device handle
+ * @param[in] wake @ref bq25180_wake_config
+ *
+ * @return true on success or false
+ */
+bool bq25180_dev_set_wake_config(struct bq25180 *dev,
+		const struct bq25180_wake_config *wake);
+
+/**
+ * @brief Get the push button timings and the long press action
+ *
+ * @param[in] dev device handle
+ * @param[out] wake @ref bq25180_wake_config
+ *
+ * @return true on success or false
+ */
+bool bq25180_dev_get_wake_config(struct bq25180 *dev,
+		struct bq25180_wake_config *wake);
+
+/**
+ * @brief Enter shipmode or shutdown mode
+ *
+ * Both modes cut the battery off from SYS for the lowest quiescent current,
+ * and the device answers nothing on the bus until it wakes up with every
+ * register back to the reset defaults. Shutdown mode wakes up only on VIN
+ * while shipmode wakes up on the push button as well, held for
+ * @ref bq25180_wake1.
+ *
+ * The device enters the mode only with VIN absent, which is read first. With
+ * VIN present, the request is left pending until VIN is removed if
+ * @p wait_vin_removal, or refused otherwise. A request pending is replaced by
+ * a new one and cancelled by @ref bq25180_dev_reset.
+ *
+ * @param[in] dev device handle
+ * @param[in] mode @ref BQ25180_POWER_SHIP or @ref BQ25180_POWER_SHUTDOWN
+ * @param[in] wait_vin_removal leave the request pending if VIN is present
+ *
+ * @return true if entered or left pending. false if refused or on a bus
+ *         error
+ */
+bool bq25180_dev_enter_power_mode(struct bq25180 *dev,
+		enum bq25180_power_mode mode, bool wait_vin_removal);
+
+/**
+ * @brief Get the request left pending by @ref bq25180_dev_enter_power_mode
+ *
+ * No bus access is made. The request is the one the driver made, which the
+ * device does not report back. It is cleared by a reset or once a status read
+ * or interrupt service finds VIN gone, the device having entered the mode and
+ * woken up since. Woken up by VIN coming back instead, it is not told apart
+ * from VIN never removed and stays pending.
+ *
+ * @param[in] dev device handle
+ *
+ * @return @ref bq25180_power_mode pending or @ref BQ25180_POWER_ACTIVE if none
+ */
+enum bq25180_power_mode bq25180_dev_get_pending_power_mode(
+		const struct bq25180 *dev);
 
 /**
  * @brief Enable interrupts
  *
+ * @param[in] dev device handle
  * @param[in] mask combined interrupt mask @ref bq25180_intr
+ *
+ * @return true on success or false
  */
-void bq25180_enable_interrupt(uint8_t mask);
+bool bq25180_dev_enable_interrupt(struct bq25180 *dev, uint8_t mask);
 
 /**
  * @brief Disable interrupts
  *
+ * @param[in] dev device handle
+ * @param[in] mask combined interrupt mask @ref bq25180_intr
+ *
+ * @return true on success or false
+ */
+bool bq25180_dev_disable_interrupt(struct bq25180 *dev, uint8_t mask);
+
+/**
+ * @brief Get the configuration the device has on reset
+ *
+ * @param[out] cfg @ref bq25180_config
+ */
+void bq25180_get_default_config(struct bq25180_config *cfg);
+
+/**
+ * @brief Apply a whole configuration at once
+ *
+ * The final image of the registers from VBAT_CTRL to MASK_ID is computed
+ * first and compared against the current contents, taken from the register
+ * shadow if enabled or from a single burst read otherwise. Only the changed
+ * registers get written, contiguous ones in a single burst.
+ *
+ * Bits not covered by @ref bq25180_config are kept as they are.
+ *
+ * @param[in] dev device handle
+ * @param[in] cfg @ref bq25180_config
+ *
+ * @return true on success or false
+ */
+bool bq25180_dev_apply_config(struct bq25180 *dev,
+		const struct bq25180_config *cfg);
+
+/**
+ * @brief Get the whole configuration in effect
+ *
+ * The counterpart of @ref bq25180_dev_apply_config, decoded into physical
+ * units and enums. Served from the register shadow without any bus access if
+ * enabled, or from a single burst read of VBAT_CTRL to MASK_ID otherwise.
+ *
+ * @param[in] dev device handle
+ * @param[out] cfg @ref bq25180_config
+ * @param[in] live read the device even with the shadow enabled, refreshing
+ *            the shadow with what is read
+ *
+ * @return true on success or false
+ *
+ * @note The shadow goes stale on a watchdog reset. Read it live to see what
+ *       the device actually runs with.
+ */
+bool bq25180_dev_get_config(struct bq25180 *dev,
+		struct bq25180_config *cfg, bool live);
+
+/**
+ * @brief Apply a prebuilt register image
+ *
+ * This is @ref bq25180_dev_apply_config with the image already computed, for
+ * example at compile time by bq25180.hpp. Only the registers different from
+ * the current contents get written, the same way.
+ *
+ * @param[in] dev device handle
+ * @param[in] image register values from VBAT_CTRL to MASK_ID
+ *
+ * @return true on success or false
+ */
+bool bq25180_dev_apply_config_image(struct bq25180 *dev,
+		const uint8_t image[BQ25180_CONFIG_IMAGE_LEN]);
+
+/**
+ * @brief Build the register image of a configuration
+ *
+ * Unlike @ref bq25180_dev_apply_config, bits not covered by
+ * @ref bq25180_config take their reset values. No bus access is made.
+ *
+ * @param[in] cfg @ref bq25180_config
+ * @param[out] image register values from VBAT_CTRL to MASK_ID
+ */
+void bq25180_get_config_image(const struct bq25180_config *cfg,
+		uint8_t image[BQ25180_CONFIG_IMAGE_LEN]);
+
+/**
+ * @brief Serialize a register image to be stored, in flash for example
+ *
+ * The blob is a version byte, the image and a CRC-8 of them.
+ *
+ * @param[in] image register values from VBAT_CTRL to MASK_ID
+ * @param[out] blob @ref BQ25180_CONFIG_BLOB_LEN bytes
+ */
+void bq25180_encode_config_blob(const uint8_t image[BQ25180_CONFIG_IMAGE_LEN],
+		uint8_t blob[BQ25180_CONFIG_BLOB_LEN]);
+
+/**
+ * @brief Get the register image back from a stored blob
+ *
+ * @param[in] blob @ref BQ25180_CONFIG_BLOB_LEN bytes
+ * @param[out] image register values from VBAT_CTRL to MASK_ID
+ *
+ * @return true on success or false if the blob is corrupted or of another
+ *         version
+ */
+bool bq25180_decode_config_blob(const uint8_t blob[BQ25180_CONFIG_BLOB_LEN],
+		uint8_t image[BQ25180_CONFIG_IMAGE_LEN]);
+
+/**
+ * @brief Restore the intended configuration if the device got reset
+ *
+ * The watchdog expiring, like a power cycle, puts all the registers back to
+ * the reset values behind the host's back. To tell that cheaply, only the
+ * first register the image sets apart from its reset value is read. If it
+ * reads the reset value, the image is written in a single burst from that
+ * register to the last one differing, and the shadow is re-seeded if enabled.
+ *
+ * Meant to be called on every status poll: it costs one single byte read
+ * unless restoring. Keep the image up to date when changing the settings at
+ * run time, or those would be taken for a reset and overwritten.
+ *
+ * @param[in] dev device handle
+ * @param[in] image register values from VBAT_CTRL to MASK_ID
+ * @param[out] restored whether the image got written. Can be NULL
+ *
+ * @return true on success or false
+ *
+ * @note Nothing is read if the image is the reset values.
+ */
+bool bq25180_dev_restore_config_image(struct bq25180 *dev,
+		const uint8_t image[BQ25180_CONFIG_IMAGE_LEN], bool *restored);
+
+/**
+ * @brief Probe the device and bring it up with a configuration
+ *
+ * VBAT_CTRL to MASK_ID are read in a single burst, which tells whether the
+ * device answers, whether DEVICE_ID is @ref BQ25180_DEVICE_ID and whether the
+ * registers are at the reset values. The image is then written in a single
+ * burst from the first register differing to the last one, with no other
+ * read. On a cold boot that is the reset image. The shadow is seeded with
+ * the result if enabled.
+ *
+ * That makes two transactions at most, or one if the device already runs
+ * with the image.
+ *
+ * @param[in] dev device handle
+ * @param[in] image register values from VBAT_CTRL to MASK_ID, or NULL only
+ *            to probe
+ * @param[out] report @ref bq25180_probe_report. Can be NULL
+ *
+ * @return true on success or false. false as well if the device ID does not
+ *         match, with nothing written
+ */
+bool bq25180_dev_probe(struct bq25180 *dev,
+		const uint8_t image[BQ25180_CONFIG_IMAGE_LEN],
+		struct bq25180_probe_report *report);
+
+/**
+ * @brief Register a callback for interrupts
+ *
+ * @param[in] dev device handle
  * @param[in] mask combined interrupt mask @ref bq25180_intr
+ * @param[in] func @ref bq25180_intr_callback_t or NULL to unregister
+ * @param[in] ctx user context to be passed to @p func
  */
-void bq25180_disable_interrupt(uint8_t mask);
+void bq25180_dev_register_interrupt_callback(struct bq25180 *dev,
+		uint8_t mask, bq25180_intr_callback_t func, void *ctx);
 
-/* TODO: Implement bq25180_shutdown_mode(void) */
+/**
+ * @brief Notify the driver of an interrupt
+ *
+ * This only marks an interrupt pending without any bus access, so it is safe
+ * to be called in the INT pin ISR. Pulses notified before the next
+ * @ref bq25180_dev_process_interrupt are coalesced into one.
+ *
+ * @param[in] dev device handle
+ */
+void bq25180_dev_notify_interrupt(struct bq25180 *dev);
+
+/**
+ * @brief Process the pending interrupt
+ *
+ * STAT0, STAT1 and FLAG0 are read in a single burst once per pending
+ * interrupt, and the registered callbacks get called for the interrupts
+ * fired. It does nothing if no interrupt is pending.
+ *
+ * This is meant to be called in a task context, not in the ISR.
+ *
+ * @param[in] dev device handle
+ * @return true on success or false. The interrupt is kept pending on failure
+ *
+ * @note FLAG0 gets cleared by the read. The events are delivered only to the
+ *       callbacks.
+ */
+bool bq25180_dev_process_interrupt(struct bq25180 *dev);
+
+/**
+ * @brief Set the retry policy of bus transactions
+ *
+ * Without a policy, which is the default, a failed transaction is reported
+ * right away. A setter never writes anything when its read fails, so a
+ * failure leaves the register as it was.
+ *
+ * @param[in] dev device handle
+ * @param[in] policy @ref bq25180_retry_policy to be kept valid while in use
+ *            or NULL not to retry
+ */
+void bq25180_dev_set_retry_policy(struct bq25180 *dev,
+		const struct bq25180_retry_policy *policy);
+
+/**
+ * @brief Get the retry statistics
+ *
+ * @param[in] dev device handle
+ * @param[out] stats @ref bq25180_retry_stats
+ */
+void bq25180_dev_get_retry_stats(const struct bq25180 *dev,
+		struct bq25180_retry_stats *stats);
+
+/**
+ * @brief Clear the retry statistics
+ *
+ * @param[in] dev device handle
+ */
+void bq25180_dev_clear_retry_stats(struct bq25180 *dev);
 
 #if defined(__cplusplus)
 }
 #endif
 
+#include "bq25180_compat.h"
+
 #endif /* LIBMCU_BQ25180_H */
@@ -0,0 +1,325 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_HPP
+#define LIBMCU_BQ25180_HPP
+
+#if !defined(__cplusplus) || __cplusplus < 201703L
+#error "bq25180.hpp requires C++17 or later"
+#endif
+
+#include <array>
+#include <cstdint>
+
+#include "bq25180.h"
+#include "bq25180_fields.h"
+
+/*
+ * The namespace is nested as the plain name is taken by struct bq25180.
+ *
+ * Settings in physical units, encoded into register codes by constexpr
+ * functions. In a constant expression, such as a constexpr variable, a value
+ * the device cannot take fails to compile. That covers both out-of-range
+ * values and values between two steps, like 36mA to 39mA of the fast charge
+ * current. At run time the same functions round down and clamp the way the C
+ * driver does.
+ *
+ *   using namespace libmcu::bq25180::literals;
+ *
+ *   constexpr auto image = libmcu::bq25180::config()
+ *           .battery_regulation(4200_mV)
+ *           .fastcharge_current(100_mA)
+ *           .input_current(500_mA)
+ *           .image();
+ *
+ *   bq25180_dev_apply_config_image(&dev, image.data());
+ */
+namespace libmcu::bq25180 {
+
+struct millivolts {
+	std::uint16_t value;
+};
+
+struct milliamps {
+	std::uint16_t value;
+};
+
+struct percent {
+	std::uint8_t value;
+};
+
+namespace literals {
+constexpr millivolts operator""_mV(unsigned long long v) {
+	return millivolts{static_cast<std::uint16_t>(v)};
+}
+constexpr milliamps operator""_mA(unsigned long long v) {
+	return milliamps{static_cast<std::uint16_t>(v)};
+}
+constexpr percent operator""_pct(unsigned long long v) {
+	return percent{static_cast<std::uint8_t>(v)};
+}
+} /* namespace literals */
+
+using image_t = std::array<std::uint8_t, BQ25180_CONFIG_IMAGE_LEN>;
+
+namespace detail {
+
+enum reg : std::uint8_t {
+#define BQ25180_HPP_REGISTER(name, reset)	name,
+	BQ25180_REGISTERS(BQ25180_HPP_REGISTER)
+#undef BQ25180_HPP_REGISTER
+	NR_REGISTERS,
+};
+
+enum field : std::uint8_t {
+#define BQ25180_HPP_FIELD(name, r, s, w)	name,
+	BQ25180_FIELDS(BQ25180_HPP_FIELD)
+#undef BQ25180_HPP_FIELD
+};
+
+struct field_pos {
+	std::uint8_t reg;
+	std::uint8_t shift;
+	std::uint8_t mask; /* in place */
+};
+
+inline constexpr field_pos fields[] = {
+#define BQ25180_HPP_FIELD(name, r, s, w) \
+	{ r, s, static_cast<std::uint8_t>(((1u << (w)) - 1) << (s)) },
+	BQ25180_FIELDS(BQ25180_HPP_FIELD)
+#undef BQ25180_HPP_FIELD
+};
+
+using regs_t = std::array<std::uint8_t, NR_REGISTERS>;
+
+inline constexpr regs_t reset_defaults = {
+#define BQ25180_HPP_REGISTER(name, reset)	reset,
+	BQ25180_REGISTERS(BQ25180_HPP_REGISTER)
+#undef BQ25180_HPP_REGISTER
+};
+
+inline constexpr std::uint16_t ilim_codes[] = { BQ25180_ILIM_CODES_mA };
+inline constexpr std::uint8_t iterm_codes[] = { BQ25180_ITERM_CODES_PCT };
+
+/* The highest code of @p codes not above @p val, and whether exactly @p val */
+template <typename T, std::size_t N>
+constexpr std::uint8_t floor_code(const T (&codes)[N], unsigned int val,
+		bool &exact) {
+	std::uint8_t code = 0;
+
+	exact = false;
+	for (std::size_t c = 0; c < N; c++) {
+		if (val == codes[c]) {
+			exact = true;
+		}
+		if (val >= codes[c]) {
+			code = static_cast<std::uint8_t>(c);
+		}
+	}
+
+	return code;
+}
+
+/* Not constexpr on purpose: reaching it in a constant expression is what
+ * makes an invalid setting a compile error. */
+inline void value_not_supported_by_device() {}
+
+constexpr void require(bool ok) {
+	if (!ok) {
+		value_not_supported_by_device();
+	}
+}
+
+constexpr void put(regs_t &regs, field f, unsigned int val) {
+	const field_pos &p = fields[f];
+	regs[p.reg] = static_cast<std::uint8_t>((regs[p.reg] & ~p.mask) |
+			((val << p.shift) & p.mask));
+}
+
+} /* namespace detail */
+
+constexpr std::uint8_t encode_battery_regulation(millivolts v) {
+	constexpr unsigned int min = BQ25180_VBATREG_MIN_mV;
+	constexpr unsigned int max = BQ25180_VBATREG_MAX_mV;
+
+	detail::require(v.value >= min && v.value <= max &&
+			v.value % BQ25180_VBATREG_STEP_mV == 0);
+	if (v.value < min) {
+		return 0;
+	}
+	return static_cast<std::uint8_t>(((v.value > max? max : v.value) -
+				min) / BQ25180_VBATREG_STEP_mV);
+}
+
+constexpr std::uint8_t encode_fastcharge_current(milliamps i) {
+	constexpr unsigned int min = BQ25180_ICHG_MIN_mA;
+	constexpr unsigned int max = BQ25180_ICHG_MAX_mA;
+	constexpr unsigned int fine_max = BQ25180_ICHG_FINE_MAX_mA;
+	constexpr unsigned int step = BQ25180_ICHG_COARSE_STEP_mA;
+
+	detail::require(i.value >= min && i.value <= max &&
+			(i.value <= fine_max || i.value % step == 0));
+	if (i.value < min) {
+		return 0;
+	}
+	if (i.value <= fine_max) {
+		return static_cast<std::uint8_t>(i.value - min);
+	}
+	return static_cast<std::uint8_t>(
+			(i.value > max? max : i.value) / step + 27);
+}
+
+constexpr std::uint8_t encode_battery_under_voltage(millivolts v) {
+	constexpr unsigned int min = BQ25180_BUVLO_MIN_mV;
+	constexpr unsigned int step = BQ25180_BUVLO_STEP_mV;
+
+	detail::require(v.value >= min && v.value <= BQ25180_BUVLO_MAX_mV &&
+			v.value % step == 0);
+	if (v.value <= min) {
+		return 7;
+	}
+	const unsigned int n = (v.value - min + step - 1) / step;
+	return static_cast<std::uint8_t>(7 - (n > 5? 5 : n));
+}
+
+constexpr std::uint8_t encode_precharge_threshold(millivolts v) {
+	detail::require(v.value == BQ25180_VLOWV_LOW_mV ||
+			v.value == BQ25180_VLOWV_HIGH_mV);
+	return v.value <= BQ25180_VLOWV_LOW_mV;
+}
+
+constexpr std::uint8_t encode_termination_current(percent pct) {
+	bool exact = false;
+	const std::uint8_t code =
+		detail::floor_code(detail::iterm_codes, pct.value, exact);
+
+	detail::require(exact);
+	return code;
+}
+
+constexpr std::uint8_t encode_input_current(milliamps i) {
+	bool exact = false;
+	const std::uint8_t code =
+		detail::floor_code(detail::ilim_codes, i.value, exact);
+
+	detail::require(exact);
+	return code;
+}
+
+/*
+ * Register image of the settings, starting from the reset defaults. Every
+ * setter returns a modified copy so that a whole configuration can be a
+ * single constant expression.
+ */
+class config {
+public:
+	/* The reset defaults match bq25180_get_default_config(), interrupt
+	 * masks included. */
+	constexpr config() : regs(detail::reset_defaults) {}
+
+	constexpr config charging(bool enable) const {
+		return with(detail::CHG_DIS, !enable);
+	}
+	constexpr config battery_regulation(millivolts v) const {
+		return with(detail::VBATREG, encode_battery_regulation(v));
+	}
+	constexpr config fastcharge_current(milliamps i) const {
+		return with(detail::ICHG, encode_fastcharge_current(i));
+	}
+	constexpr config termination_current(percent pct) const {
+		return with(detail::ITERM, encode_termination_current(pct));
+	}
+	constexpr config double_precharge_current(bool enable) const {
+		return with(detail::IPRECHG, !enable);
+	}
+	constexpr config precharge_threshold(millivolts v) const {
+		return with(detail::VLOWV_SEL, encode_precharge_threshold(v));
+	}
+	constexpr config battery_under_voltage(millivolts v) const {
+		return with(detail::BUVLO, encode_battery_under_voltage(v));
+	}
+	constexpr config discharge_current(
+			bq25180_bat_discharge_current opt) const {
+		return with(detail::IBAT_OCP, opt);
+	}
+	constexpr config input_current(milliamps i) const {
+		return with(detail::ILIM, encode_input_current(i));
+	}
+	constexpr config vindpm(bq25180_vindpm opt) const {
+		return with(detail::VINDPM, opt);
+	}
+	constexpr config dppm(bool enable) const {
+		return with(detail::VDPPM_DIS, !enable);
+	}
+	constexpr config safety_timer(bq25180_safety_timer opt) const {
+		return with(detail::SAFETY_TIMER, opt);
+	}
+	constexpr config watchdog(bq25180_watchdog opt) const {
+		return with(detail::WATCHDOG_SEL, opt);
+	}
+	constexpr config sys_source(bq25180_sys_source opt) const {
+		return with(detail::SYS_MODE, opt);
+	}
+	constexpr config sys_voltage(bq25180_sys_regulation opt) const {
+		return with(detail::SYS_REG_CTRL, opt);
+	}
+	constexpr config thermal_protection(bool enable) const {
+		return with(detail::TS_EN, enable);
+	}
+	constexpr config thermistor(const bq25180_ts_config &ts) const {
+		return with(detail::TS_HOT, ts.hot)
+			.with(detail::TS_COLD, ts.cold)
+			.with(detail::TS_WARM, !ts.warm_enabled)
+			.with(detail::TS_COOL, !ts.cool_enabled)
+			.with(detail::TS_ICHG, ts.cool_current)
+			.with(detail::TS_VRCG, ts.warm_voltage);
+	}
+	constexpr config push_button(bool enable) const {
+		return with(detail::EN_PUSH, enable);
+	}
+	/* @p mask is the combined enum bq25180_intr to be enabled */
+	constexpr config interrupts(std::uint8_t mask) const {
+		const auto bit = [mask](unsigned int intr) {
+			return !(mask & intr);
+		};
+		return with(detail::CHG_STATUS_INT_MASK,
+				bit(BQ25180_INTR_CHARGING_STATUS))
+			.with(detail::ILIM_INT_MASK,
+				bit(BQ25180_INTR_CURRENT_LIMIT))
+			.with(detail::VDPM_INT_MASK, bit(BQ25180_INTR_VDPM))
+			.with(detail::TS_INT_MASK,
+				bit(BQ25180_INTR_THERMAL_FAULT))
+			.with(detail::TREG_INT_MASK,
+				bit(BQ25180_INTR_THERMAL_REGULATION))
+			.with(detail::BAT_INT_MASK,
+				bit(BQ25180_INTR_BATTERY_RANGE))
+			.with(detail::PG_INT_MASK,
+				bit(BQ25180_INTR_POWER_ERROR));
+	}
+
+	/* Registers from VBAT_CTRL to MASK_ID, for
+	 * bq25180_dev_apply_config_image() */
+	constexpr image_t image() const {
+		image_t img{};
+		for (std::size_t i = 0; i < img.size(); i++) {
+			img[i] = regs[detail::VBAT_CTRL + i];
+		}
+		return img;
+	}
+
+private:
+	detail::regs_t regs;
+
+	constexpr config with(detail::field f, unsigned int val) const {
+		config c = *this;
+		detail::put(c.regs, f, val);
+		return c;
+	}
+};
+
+} /* namespace libmcu::bq25180 */
+
+#endif /* LIBMCU_BQ25180_HPP */
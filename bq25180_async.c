@@ -0,0 +1,324 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_async.h"
+#include "bq25180_internal.h"
+#include <string.h>
+
+#if !defined(assert)
+#define assert(exp)
+#endif
+
+enum op_type {
+	OP_UPDATE,		/* read, modify and then write a register */
+	OP_WRITE,		/* write a register */
+	OP_READ_STATUS,		/* burst read from STAT0 and decode */
+};
+
+enum op_step {
+	STEP_READ,
+	STEP_WRITE,
+};
+
+static struct bq25180_async_op *get_current(struct bq25180_async *async)
+{
+	return &async->queue[async->head];
+}
+
+static int start_transfer(struct bq25180_async *async,
+		struct bq25180_async_op *op)
+{
+	const struct bq25180_async_bus *bus = async->bus;
+
+	if (op->type == OP_READ_STATUS) {
+		return bus->start_read(async->bus_ctx, async->addr, STAT0,
+				op->buf, op->event? 3 : 2);
+	} else if (op->step == STEP_READ) {
+		return bus->start_read(async->bus_ctx, async->addr, op->reg,
+				op->buf, 1);
+	}
+
+	return bus->start_write(async->bus_ctx, async->addr, op->reg,
+			op->buf, 1);
+}
+
+static void finish(struct bq25180_async *async, int err)
+{
+	struct bq25180_async_op *op = get_current(async);
+	bq25180_async_callback_t cb = op->cb;
+	void *arg = op->arg;
+
+	async->head = (uint8_t)((async->head + 1) % BQ25180_ASYNC_QUEUE_LEN);
+	async->len--;
+
+	if (cb) {
+		cb(async, err, arg);
+	}
+}
+
+static void run(struct bq25180_async *async)
+{
+	/* Reached again from a completion reported inside the start hook or
+	 * from a callback queueing more. The outer loop carries on. */
+	if (async->running) {
+		return;
+	}
+
+	async->running = true;
+
+	while (!async->in_flight && async->len > 0) {
+		/* Set first as the completion may come before start returns */
+		async->in_flight = true;
+
+		const int err = start_transfer(async, get_current(async));
+
+		if (err < 0) {
+			async->in_flight = false;
+			finish(async, err);
+		}
+	}
+
+	async->running = false;
+}
+
+static bool queue(struct bq25180_async *async,
+		const struct bq25180_async_op *op)
+{
+	if (async->len >= BQ25180_ASYNC_QUEUE_LEN) {
+		return false;
+	}
+
+	const uint8_t index = (uint8_t)
+		((async->head + async->len) % BQ25180_ASYNC_QUEUE_LEN);
+	async->queue[index] = *op;
+	async->len++;
+
+	run(async);
+
+	return true;
+}
+
+static bool queue_update(struct bq25180_async *async, enum fields field,
+		uint8_t val, bq25180_async_callback_t cb, void *arg)
+{
+	const struct field *f = &bq25180_fields[field];
+
+	return queue(async, &(const struct bq25180_async_op) {
+		.type = OP_UPDATE,
+		.step = STEP_READ,
+		.reg = f->reg,
+		.mask = f->mask,
+		.val = (uint8_t)((val << f->shift) & f->mask),
+		.cb = cb,
+		.arg = arg,
+	});
+}
+
+void bq25180_async_complete(struct bq25180_async *async, int err)
+{
+	struct bq25180_async_op *op = get_current(async);
+
+	assert(async->in_flight);
+	async->in_flight = false;
+
+	if (err < 0) {
+		finish(async, err);
+	} else if (op->type == OP_UPDATE && op->step == STEP_READ) {
+		op->buf[0] = (uint8_t)((op->buf[0] & ~op->mask) | op->val);
+		op->step = STEP_WRITE;
+	} else {
+		if (op->type == OP_READ_STATUS && op->state) {
+			bq25180_decode_state(op->buf[STAT0], op->buf[STAT1],
+					op->state);
+		}
+		if (op->type == OP_READ_STATUS && op->event) {
+			bq25180_decode_event(op->buf[FLAG0], op->event);
+		}
+
+		finish(async, 0);
+	}
+
+	run(async);
+}
+
+bool bq25180_async_busy(const struct bq25180_async *async)
+{
+	return async->len > 0;
+}
+
+void bq25180_async_init(struct bq25180_async *async, uint8_t addr,
+		const struct bq25180_async_bus *bus, void *bus_ctx)
+{
+	assert(async != NULL);
+	assert(bus != NULL && bus->start_read != NULL &&
+			bus->start_write != NULL);
+
+	memset(async, 0, sizeof(*async));
+
+	async->bus = bus;
+	async->bus_ctx = bus_ctx;
+	async->addr = addr;
+}
+
+bool bq25180_async_read_state(struct bq25180_async *async,
+		struct bq25180_state *state, bq25180_async_callback_t cb,
+		void *arg)
+{
+	assert(state != NULL);
+
+	return bq25180_async_read_snapshot(async, state, NULL, cb, arg);
+}
+
+bool bq25180_async_read_snapshot(struct bq25180_async *async,
+		struct bq25180_state *state, struct bq25180_event *event,
+		bq25180_async_callback_t cb, void *arg)
+{
+	assert(state != NULL || event != NULL);
+
+	return queue(async, &(const struct bq25180_async_op) {
+		.type = OP_READ_STATUS,
+		.state = state,
+		.event = event,
+		.cb = cb,
+		.arg = arg,
+	});
+}
+
+bool bq25180_async_enable_battery_charging(struct bq25180_async *async,
+		bool enable, bq25180_async_callback_t cb, void *arg)
+{
+	return queue_update(async, FIELD_CHG_DIS, !enable, cb, arg);
+}
+
+bool bq25180_async_set_fastcharge_current(struct bq25180_async *async,
+		uint16_t milliampere, bq25180_async_callback_t cb, void *arg)
+{
+	assert(milliampere >= MIN_IN_CURR_mA && milliampere <= MAX_IN_CURR_mA);
+
+	return queue_update(async, FIELD_ICHG,
+			bq25180_encode_fastcharge_current(milliampere),
+			cb, arg);
+}
+
+bool bq25180_async_set_input_current(struct bq25180_async *async,
+		uint16_t milliampere, bq25180_async_callback_t cb, void *arg)
+{
+	return queue_update(async, FIELD_ILIM,
+			bq25180_encode_input_current(milliampere), cb, arg);
+}
+
+bool bq25180_async_set_battery_regulation_voltage(
+		struct bq25180_async *async, uint16_t millivoltage,
+		bq25180_async_callback_t cb, void *arg)
+{
+	assert(millivoltage >= MIN_BAT_REG_mV &&
+			millivoltage <= MAX_BAT_REG_mV);
+
+	return queue(async, &(const struct bq25180_async_op) {
+		.type = OP_WRITE,
+		.step = STEP_WRITE,
+		.reg = VBAT_CTRL,
+		.buf = { bq25180_encode_battery_regulation_voltage(
+				millivoltage), },
+		.cb = cb,
+		.arg = arg,
+	});
+}
+
+bool bq25180_async_set_safety_timer(struct bq25180_async *async,
+		enum bq25180_safety_timer opt, bq25180_async_callback_t cb,
+		void *arg)
+{
+	return queue_update(async, FIELD_SAFETY_TIMER, (uint8_t)opt, cb, arg);
+}
+
+bool bq25180_async_set_watchdog_timer(struct bq25180_async *async,
+		enum bq25180_watchdog opt, bq25180_async_callback_t cb,
+		void *arg)
+{
+	return queue_update(async, FIELD_WATCHDOG_SEL, (uint8_t)opt, cb, arg);
+}
+
+bool bq25180_async_set_battery_discharge_current(
+		struct bq25180_async *async,
+		enum bq25180_bat_discharge_current opt,
+		bq25180_async_callback_t cb, void *arg)
+{
+	return queue_update(async, FIELD_IBAT_OCP, (uint8_t)opt, cb, arg);
+}
+
+bool bq25180_async_set_battery_under_voltage(struct bq25180_async *async,
+		uint16_t millivoltage, bq25180_async_callback_t cb, void *arg)
+{
+	assert(millivoltage >= MIN_BAT_UNDERVOLTAGE_mV &&
+			millivoltage <= MAX_BAT_UNDERVOLTAGE_mV);
+
+	return queue_update(async, FIELD_BUVLO,
+			bq25180_encode_battery_under_voltage(millivoltage),
+			cb, arg);
+}
+
+bool bq25180_async_set_precharge_threshold(struct bq25180_async *async,
+		uint16_t millivoltage, bq25180_async_callback_t cb, void *arg)
+{
+	return queue_update(async, FIELD_VLOWV_SEL,
+			bq25180_encode_precharge_threshold(millivoltage),
+			cb, arg);
+}
+
+bool bq25180_async_set_precharge_current(struct bq25180_async *async,
+		bool double_termination_current, bq25180_async_callback_t cb,
+		void *arg)
+{
+	return queue_update(async, FIELD_IPRECHG,
+			!double_termination_current, cb, arg);
+}
+
+bool bq25180_async_set_termination_current(struct bq25180_async *async,
+		uint8_t pct, bq25180_async_callback_t cb, void *arg)
+{
+	return queue_update(async, FIELD_ITERM,
+			bq25180_encode_termination_current(pct), cb, arg);
+}
+
+bool bq25180_async_enable_vindpm(struct bq25180_async *async,
+		enum bq25180_vindpm opt, bq25180_async_callback_t cb,
+		void *arg)
+{
+	return queue_update(async, FIELD_VINDPM, (uint8_t)opt, cb, arg);
+}
+
+bool bq25180_async_enable_dppm(struct bq25180_async *async, bool enable,
+		bq25180_async_callback_t cb, void *arg)
+{
+	return queue_update(async, FIELD_VDPPM_DIS, !enable, cb, arg);
+}
+
+bool bq25180_async_set_sys_source(struct bq25180_async *async,
+		enum bq25180_sys_source source, bq25180_async_callback_t cb,
+		void *arg)
+{
+	return queue_update(async, FIELD_SYS_MODE, (uint8_t)source, cb, arg);
+}
+
+bool bq25180_async_set_sys_voltage(struct bq25180_async *async,
+		enum bq25180_sys_regulation val, bq25180_async_callback_t cb,
+		void *arg)
+{
+	return queue_update(async, FIELD_SYS_REG_CTRL, (uint8_t)val, cb, arg);
+}
+
+bool bq25180_async_enable_thermal_protection(struct bq25180_async *async,
+		bool enable, bq25180_async_callback_t cb, void *arg)
+{
+	return queue_update(async, FIELD_TS_EN, enable, cb, arg);
+}
+
+bool bq25180_async_enable_push_button(struct bq25180_async *async,
+		bool enable, bq25180_async_callback_t cb, void *arg)
+{
+	return queue_update(async, FIELD_EN_PUSH, enable, cb, arg);
+}
@@ -0,0 +1,343 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_ASYNC_H
+#define LIBMCU_BQ25180_ASYNC_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+#if !defined(BQ25180_ASYNC_QUEUE_LEN)
+#define BQ25180_ASYNC_QUEUE_LEN		4
+#endif
+
+struct bq25180_async;
+
+/**
+ * @brief Completion callback of an asynchronous operation
+ *
+ * @param[in] async @ref bq25180_async the operation was queued on
+ * @param[in] err 0 on success. Otherwise the negative error code of the bus
+ * @param[in] arg user argument given on queueing
+ */
+typedef void (*bq25180_async_callback_t)(struct bq25180_async *async,
+		int err, void *arg);
+
+struct bq25180_async_bus {
+	/**
+	 * @brief Start reading registers
+	 *
+	 * @p buf stays valid until the transfer completes. Completion should
+	 * be reported with @ref bq25180_async_complete.
+	 *
+	 * @return 0 if started. Otherwise a negative integer error code
+	 */
+	int (*start_read)(void *ctx, uint8_t addr, uint8_t reg,
+			void *buf, size_t bufsize);
+	/**
+	 * @brief Start writing registers
+	 *
+	 * Completion should be reported with @ref bq25180_async_complete.
+	 *
+	 * @return 0 if started. Otherwise a negative integer error code
+	 */
+	int (*start_write)(void *ctx, uint8_t addr, uint8_t reg,
+			const void *data, size_t data_len);
+};
+
+struct bq25180_async_op {
+	uint8_t type;
+	uint8_t step;
+	uint8_t reg;
+	uint8_t mask;
+	uint8_t val;
+	uint8_t buf[3];
+	struct bq25180_state *state;
+	struct bq25180_event *event;
+	bq25180_async_callback_t cb;
+	void *arg;
+};
+
+/**
+ * @brief Asynchronous device handle
+ *
+ * Members are private to the driver. Initialize it with
+ * @ref bq25180_async_init.
+ */
+struct bq25180_async {
+	const struct bq25180_async_bus *bus;
+	void *bus_ctx;
+	uint8_t addr;
+
+	struct bq25180_async_op queue[BQ25180_ASYNC_QUEUE_LEN];
+	uint8_t head;
+	uint8_t len;
+	bool in_flight;
+	bool running; /* in run(), not to be entered again */
+};
+
+/**
+ * @brief Initialize an asynchronous device handle
+ *
+ * Operations are queued and run one after another as a small state machine,
+ * driven by the bus completion reported with @ref bq25180_async_complete. A
+ * read-modify-write, for example, goes read, modify and then write, without
+ * blocking the caller.
+ *
+ * @param[in] async @ref bq25180_async
+ * @param[in] addr device address
+ * @param[in] bus @ref bq25180_async_bus to reach the device
+ * @param[in] bus_ctx context to be passed to @p bus
+ *
+ * @note Queueing and @ref bq25180_async_complete must not preempt each other.
+ *       Either call both in the same context or queue with the bus completion
+ *       interrupt masked.
+ */
+void bq25180_async_init(struct bq25180_async *async, uint8_t addr,
+		const struct bq25180_async_bus *bus, void *bus_ctx);
+
+/**
+ * @brief Report the completion of the transfer in progress
+ *
+ * This advances the operation in progress, calling its callback when done and
+ * starting the next one queued. It is meant to be called from the bus
+ * completion handler.
+ *
+ * @param[in] async @ref bq25180_async
+ * @param[in] err 0 on success or a negative integer error code
+ */
+void bq25180_async_complete(struct bq25180_async *async, int err);
+
+/**
+ * @brief Tell if any operation is in progress or queued
+ *
+ * @param[in] async @ref bq25180_async
+ *
+ * @return true if busy or false
+ */
+bool bq25180_async_busy(const struct bq25180_async *async);
+
+/**
+ * @brief Read the device state asynchronously
+ *
+ * STAT0 and STAT1 are read in a burst and decoded into @p state before
+ * @p cb gets called.
+ *
+ * @param[in] async @ref bq25180_async
+ * @param[out] state @ref bq25180_state to be kept valid until @p cb
+ * @param[in] cb @ref bq25180_async_callback_t. Can be NULL
+ * @param[in] arg user argument to be passed to @p cb
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_read_state(struct bq25180_async *async,
+		struct bq25180_state *state, bq25180_async_callback_t cb,
+		void *arg);
+
+/**
+ * @brief Read the device state and events asynchronously
+ *
+ * @see bq25180_dev_read_snapshot
+ *
+ * @param[in] async @ref bq25180_async
+ * @param[out] state @ref bq25180_state to be kept valid until @p cb or NULL
+ * @param[out] event @ref bq25180_event to be kept valid until @p cb or NULL
+ * @param[in] cb @ref bq25180_async_callback_t. Can be NULL
+ * @param[in] arg user argument to be passed to @p cb
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_read_snapshot(struct bq25180_async *async,
+		struct bq25180_state *state, struct bq25180_event *event,
+		bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Enable or disable battery charging asynchronously
+ *
+ * @see bq25180_dev_enable_battery_charging
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_enable_battery_charging(struct bq25180_async *async,
+		bool enable, bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Set the maximum charge current level asynchronously
+ *
+ * @see bq25180_dev_set_fastcharge_current
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_fastcharge_current(struct bq25180_async *async,
+		uint16_t milliampere, bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Set the maximum input current asynchronously
+ *
+ * @see bq25180_dev_set_input_current
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_input_current(struct bq25180_async *async,
+		uint16_t milliampere, bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Set the battery regulation target asynchronously
+ *
+ * @see bq25180_dev_set_battery_regulation_voltage
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_battery_regulation_voltage(
+		struct bq25180_async *async, uint16_t millivoltage,
+		bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Set the safety timer asynchronously
+ *
+ * @see bq25180_dev_set_safety_timer
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_safety_timer(struct bq25180_async *async,
+		enum bq25180_safety_timer opt, bq25180_async_callback_t cb,
+		void *arg);
+
+/**
+ * @brief Set the I2C watchdog timer asynchronously
+ *
+ * @see bq25180_dev_set_watchdog_timer
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_watchdog_timer(struct bq25180_async *async,
+		enum bq25180_watchdog opt, bq25180_async_callback_t cb,
+		void *arg);
+
+/**
+ * @brief Set the battery discharge current limit asynchronously
+ *
+ * @see bq25180_dev_set_battery_discharge_current
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_battery_discharge_current(
+		struct bq25180_async *async,
+		enum bq25180_bat_discharge_current opt,
+		bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Set the battery undervoltage lockout asynchronously
+ *
+ * @see bq25180_dev_set_battery_under_voltage
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_battery_under_voltage(struct bq25180_async *async,
+		uint16_t millivoltage, bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Set the precharge voltage threshold asynchronously
+ *
+ * @see bq25180_dev_set_precharge_threshold
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_precharge_threshold(struct bq25180_async *async,
+		uint16_t millivoltage, bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Set the precharge current asynchronously
+ *
+ * @see bq25180_dev_set_precharge_current
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_precharge_current(struct bq25180_async *async,
+		bool double_termination_current, bq25180_async_callback_t cb,
+		void *arg);
+
+/**
+ * @brief Set the termination current asynchronously
+ *
+ * @see bq25180_dev_set_termination_current
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_termination_current(struct bq25180_async *async,
+		uint8_t pct, bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Set the VINDPM level asynchronously
+ *
+ * @see bq25180_dev_enable_vindpm
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_enable_vindpm(struct bq25180_async *async,
+		enum bq25180_vindpm opt, bq25180_async_callback_t cb,
+		void *arg);
+
+/**
+ * @brief Enable or disable the DPPM asynchronously
+ *
+ * @see bq25180_dev_enable_dppm
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_enable_dppm(struct bq25180_async *async, bool enable,
+		bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Set the SYS power source asynchronously
+ *
+ * @see bq25180_dev_set_sys_source
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_sys_source(struct bq25180_async *async,
+		enum bq25180_sys_source source, bq25180_async_callback_t cb,
+		void *arg);
+
+/**
+ * @brief Set the SYS regulation voltage asynchronously
+ *
+ * @see bq25180_dev_set_sys_voltage
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_set_sys_voltage(struct bq25180_async *async,
+		enum bq25180_sys_regulation val, bq25180_async_callback_t cb,
+		void *arg);
+
+/**
+ * @brief Enable or disable the TS thermal protection asynchronously
+ *
+ * @see bq25180_dev_enable_thermal_protection
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_enable_thermal_protection(struct bq25180_async *async,
+		bool enable, bq25180_async_callback_t cb, void *arg);
+
+/**
+ * @brief Enable or disable the push button asynchronously
+ *
+ * @see bq25180_dev_enable_push_button
+ *
+ * @return true if queued or false when the queue is full
+ */
+bool bq25180_async_enable_push_button(struct bq25180_async *async,
+		bool enable, bq25180_async_callback_t cb, void *arg);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_ASYNC_H */
@@ -0,0 +1,268 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180.h"
+#include "bq25180_overrides.h"
+
+static int read_default(void *ctx, uint8_t addr, uint8_t reg,
+		void *buf, size_t bufsize)
+{
+	(void)ctx;
+	return bq25180_read(addr, reg, buf, bufsize);
+}
+
+static int write_default(void *ctx, uint8_t addr, uint8_t reg,
+		const void *data, size_t data_len)
+{
+	(void)ctx;
+	return bq25180_write(addr, reg, data, data_len);
+}
+
+static const struct bq25180_bus default_bus = {
+	.read = read_default,
+	.write = write_default,
+};
+
+static struct bq25180 default_dev = {
+	.bus = &default_bus,
+	.addr = BQ25180_DEVICE_ADDRESS,
+};
+
+struct bq25180 *bq25180_get_default_device(void)
+{
+	return &default_dev;
+}
+
+bool bq25180_reset(bool hardware_reset)
+{
+	return bq25180_dev_reset(&default_dev, hardware_reset);
+}
+
+bool bq25180_enable_cache(bool read_device)
+{
+	return bq25180_dev_enable_cache(&default_dev, read_device);
+}
+
+void bq25180_disable_cache(void)
+{
+	bq25180_dev_disable_cache(&default_dev);
+}
+
+bool bq25180_read_event(struct bq25180_event *p)
+{
+	return bq25180_dev_read_event(&default_dev, p);
+}
+
+bool bq25180_read_state(struct bq25180_state *p)
+{
+	return bq25180_dev_read_state(&default_dev, p);
+}
+
+bool bq25180_read_snapshot(struct bq25180_state *state,
+		struct bq25180_event *event)
+{
+	return bq25180_dev_read_snapshot(&default_dev, state, event);
+}
+
+bool bq25180_dump(struct bq25180_dump *dump)
+{
+	return bq25180_dev_dump(&default_dev, dump);
+}
+
+bool bq25180_enable_battery_charging(bool enable)
+{
+	return bq25180_dev_enable_battery_charging(&default_dev, enable);
+}
+
+bool bq25180_set_safety_timer(enum bq25180_safety_timer opt)
+{
+	return bq25180_dev_set_safety_timer(&default_dev, opt);
+}
+
+bool bq25180_set_watchdog_timer(enum bq25180_watchdog opt)
+{
+	return bq25180_dev_set_watchdog_timer(&default_dev, opt);
+}
+
+bool bq25180_set_battery_regulation_voltage(uint16_t millivoltage)
+{
+	return bq25180_dev_set_battery_regulation_voltage(&default_dev,
+			millivoltage);
+}
+
+bool bq25180_get_battery_regulation_voltage(uint16_t *millivoltage)
+{
+	return bq25180_dev_get_battery_regulation_voltage(&default_dev,
+			millivoltage);
+}
+
+bool bq25180_set_battery_discharge_current(
+		enum bq25180_bat_discharge_current opt)
+{
+	return bq25180_dev_set_battery_discharge_current(&default_dev, opt);
+}
+
+bool bq25180_set_battery_under_voltage(uint16_t millivoltage)
+{
+	return bq25180_dev_set_battery_under_voltage(&default_dev,
+			millivoltage);
+}
+
+bool bq25180_set_precharge_threshold(uint16_t millivoltage)
+{
+	return bq25180_dev_set_precharge_threshold(&default_dev, millivoltage);
+}
+
+bool bq25180_set_precharge_current(bool double_termination_current)
+{
+	return bq25180_dev_set_precharge_current(&default_dev,
+			double_termination_current);
+}
+
+bool bq25180_set_fastcharge_current(uint16_t milliampere)
+{
+	return bq25180_dev_set_fastcharge_current(&default_dev, milliampere);
+}
+
+bool bq25180_get_fastcharge_current(uint16_t *milliampere)
+{
+	return bq25180_dev_get_fastcharge_current(&default_dev, milliampere);
+}
+
+bool bq25180_set_termination_current(uint8_t pct)
+{
+	return bq25180_dev_set_termination_current(&default_dev, pct);
+}
+
+bool bq25180_enable_vindpm(enum bq25180_vindpm opt)
+{
+	return bq25180_dev_enable_vindpm(&default_dev, opt);
+}
+
+bool bq25180_enable_dppm(bool enable)
+{
+	return bq25180_dev_enable_dppm(&default_dev, enable);
+}
+
+bool bq25180_set_input_current(uint16_t milliampere)
+{
+	return bq25180_dev_set_input_current(&default_dev, milliampere);
+}
+
+bool bq25180_get_input_current(uint16_t *milliampere)
+{
+	return bq25180_dev_get_input_current(&default_dev, milliampere);
+}
+
+bool bq25180_set_sys_source(enum bq25180_sys_source source)
+{
+	return bq25180_dev_set_sys_source(&default_dev, source);
+}
+
+bool bq25180_get_sys_source(enum bq25180_sys_source *source)
+{
+	return bq25180_dev_get_sys_source(&default_dev, source);
+}
+
+bool bq25180_set_sys_voltage(enum bq25180_sys_regulation val)
+{
+	return bq25180_dev_set_sys_voltage(&default_dev, val);
+}
+
+bool bq25180_enable_thermal_protection(bool enable)
+{
+	return bq25180_dev_enable_thermal_protection(&default_dev, enable);
+}
+
+bool bq25180_set_ts_control(const struct bq25180_ts_config *ts)
+{
+	return bq25180_dev_set_ts_control(&default_dev, ts);
+}
+
+bool bq25180_get_ts_control(struct bq25180_ts_config *ts)
+{
+	return bq25180_dev_get_ts_control(&default_dev, ts);
+}
+
+bool bq25180_enable_push_button(bool enable)
+{
+	return bq25180_dev_enable_push_button(&default_dev, enable);
+}
+
+bool bq25180_set_wake_config(const struct bq25180_wake_config *wake)
+{
+	return bq25180_dev_set_wake_config(&default_dev, wake);
+}
+
+bool bq25180_get_wake_config(struct bq25180_wake_config *wake)
+{
+	return bq25180_dev_get_wake_config(&default_dev, wake);
+}
+
+bool bq25180_enter_power_mode(enum bq25180_power_mode mode,
+		bool wait_vin_removal)
+{
+	return bq25180_dev_enter_power_mode(&default_dev, mode,
+			wait_vin_removal);
+}
+
+enum bq25180_power_mode bq25180_get_pending_power_mode(void)
+{
+	return bq25180_dev_get_pending_power_mode(&default_dev);
+}
+
+bool bq25180_enable_interrupt(uint8_t mask)
+{
+	return bq25180_dev_enable_interrupt(&default_dev, mask);
+}
+
+bool bq25180_disable_interrupt(uint8_t mask)
+{
+	return bq25180_dev_disable_interrupt(&default_dev, mask);
+}
+
+bool bq25180_apply_config(const struct bq25180_config *cfg)
+{
+	return bq25180_dev_apply_config(&default_dev, cfg);
+}
+
+bool bq25180_get_config(struct bq25180_config *cfg, bool live)
+{
+	return bq25180_dev_get_config(&default_dev, cfg, live);
+}
+
+bool bq25180_apply_config_image(const uint8_t image[BQ25180_CONFIG_IMAGE_LEN])
+{
+	return bq25180_dev_apply_config_image(&default_dev, image);
+}
+
+bool bq25180_restore_config_image(
+		const uint8_t image[BQ25180_CONFIG_IMAGE_LEN], bool *restored)
+{
+	return bq25180_dev_restore_config_image(&default_dev, image, restored);
+}
+
+bool bq25180_probe(const uint8_t image[BQ25180_CONFIG_IMAGE_LEN],
+		struct bq25180_probe_report *report)
+{
+	return bq25180_dev_probe(&default_dev, image, report);
+}
+
+void bq25180_register_interrupt_callback(uint8_t mask,
+		bq25180_intr_callback_t func, void *ctx)
+{
+	bq25180_dev_register_interrupt_callback(&default_dev, mask, func, ctx);
+}
+
+void bq25180_notify_interrupt(void)
+{
+	bq25180_dev_notify_interrupt(&default_dev);
+}
+
+bool bq25180_process_interrupt(void)
+{
+	return bq25180_dev_process_interrupt(&default_dev);
+}
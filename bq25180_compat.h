@@ -0,0 +1,89 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_COMPAT_H
+#define LIBMCU_BQ25180_COMPAT_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+/*
+ * Single device API kept for compatibility.
+ *
+ * Each function below operates on the default device at
+ * BQ25180_DEVICE_ADDRESS, reached through bq25180_read() and bq25180_write()
+ * in bq25180_overrides.h. See the bq25180_dev_ counterpart in bq25180.h for
+ * the details.
+ */
+
+/**
+ * @brief Get the default device handle
+ *
+ * This lets the single device users reach the APIs taking a device handle.
+ *
+ * @return the handle the functions below operate on
+ */
+struct bq25180 *bq25180_get_default_device(void);
+
+bool bq25180_reset(bool hardware_reset);
+bool bq25180_enable_cache(bool read_device);
+void bq25180_disable_cache(void);
+bool bq25180_read_event(struct bq25180_event *p);
+bool bq25180_read_state(struct bq25180_state *p);
+bool bq25180_read_snapshot(struct bq25180_state *state,
+		struct bq25180_event *event);
+bool bq25180_dump(struct bq25180_dump *dump);
+bool bq25180_enable_battery_charging(bool enable);
+bool bq25180_set_safety_timer(enum bq25180_safety_timer opt);
+bool bq25180_set_watchdog_timer(enum bq25180_watchdog opt);
+bool bq25180_set_battery_regulation_voltage(uint16_t millivoltage);
+bool bq25180_get_battery_regulation_voltage(uint16_t *millivoltage);
+bool bq25180_set_battery_discharge_current(
+		enum bq25180_bat_discharge_current opt);
+bool bq25180_set_battery_under_voltage(uint16_t millivoltage);
+bool bq25180_set_precharge_threshold(uint16_t millivoltage);
+bool bq25180_set_precharge_current(bool double_termination_current);
+bool bq25180_set_fastcharge_current(uint16_t milliampere);
+bool bq25180_get_fastcharge_current(uint16_t *milliampere);
+bool bq25180_set_termination_current(uint8_t pct);
+bool bq25180_enable_vindpm(enum bq25180_vindpm opt);
+bool bq25180_enable_dppm(bool enable);
+bool bq25180_set_input_current(uint16_t milliampere);
+bool bq25180_get_input_current(uint16_t *milliampere);
+bool bq25180_set_sys_source(enum bq25180_sys_source source);
+bool bq25180_get_sys_source(enum bq25180_sys_source *source);
+bool bq25180_set_sys_voltage(enum bq25180_sys_regulation val);
+bool bq25180_enable_thermal_protection(bool enable);
+bool bq25180_set_ts_control(const struct bq25180_ts_config *ts);
+bool bq25180_get_ts_control(struct bq25180_ts_config *ts);
+bool bq25180_enable_push_button(bool enable);
+bool bq25180_set_wake_config(const struct bq25180_wake_config *wake);
+bool bq25180_get_wake_config(struct bq25180_wake_config *wake);
+bool bq25180_enter_power_mode(enum bq25180_power_mode mode,
+		bool wait_vin_removal);
+enum bq25180_power_mode bq25180_get_pending_power_mode(void);
+bool bq25180_enable_interrupt(uint8_t mask);
+bool bq25180_disable_interrupt(uint8_t mask);
+bool bq25180_apply_config(const struct bq25180_config *cfg);
+bool bq25180_get_config(struct bq25180_config *cfg, bool live);
+bool bq25180_apply_config_image(const uint8_t image[BQ25180_CONFIG_IMAGE_LEN]);
+bool bq25180_restore_config_image(
+		const uint8_t image[BQ25180_CONFIG_IMAGE_LEN], bool *restored);
+bool bq25180_probe(const uint8_t image[BQ25180_CONFIG_IMAGE_LEN],
+		struct bq25180_probe_report *report);
+void bq25180_register_interrupt_callback(uint8_t mask,
+		bq25180_intr_callback_t func, void *ctx);
+void bq25180_notify_interrupt(void);
+bool bq25180_process_interrupt(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_COMPAT_H */
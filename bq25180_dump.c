@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180.h"
+#include "bq25180_internal.h"
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(assert)
+#define assert(exp)
+#endif
+
+void bq25180_decode_dump(const struct bq25180_dump *dump,
+		struct bq25180_dump_info *info)
+{
+	const uint8_t *regs;
+
+	assert(dump != NULL && info != NULL);
+
+	regs = dump->regs;
+	memset(info, 0, sizeof(*info));
+
+	bq25180_decode_state(regs[STAT0], regs[STAT1], &info->state);
+	bq25180_decode_event(regs[FLAG0], &info->event);
+	bq25180_decode_config(regs, &info->config);
+	info->device_id = get_field(regs, FIELD_DEVICE_ID);
+}
+
+int bq25180_format_dump(const struct bq25180_dump *dump,
+		char *buf, size_t bufsize)
+{
+	struct bq25180_dump_info info;
+	char hex[BQ25180_NR_REGISTERS * 2 + 1];
+
+	assert(buf != NULL || bufsize == 0);
+
+	bq25180_decode_dump(dump, &info);
+
+	for (int i = 0; i < BQ25180_NR_REGISTERS; i++) {
+		snprintf(&hex[i * 2], 3, "%02x", dump->regs[i]);
+	}
+
+	return snprintf(buf, bufsize, "chg=%u pg=%u flag=%02x "
+			"vreg=%umV ichg=%umA iterm=%u%% ilim=%umA "
+			"buvlo=%umV id=%u regs=%s",
+			info.state.charging_status,
+			info.state.vin_good,
+			dump->regs[FLAG0],
+			info.config.battery_regulation_millivoltage,
+			info.config.fastcharge_milliampere,
+			info.config.termination_pct,
+			info.config.input_milliampere,
+			info.config.battery_undervoltage_millivoltage,
+			info.device_id,
+			hex);
+}
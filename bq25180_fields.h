@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_FIELDS_H
+#define LIBMCU_BQ25180_FIELDS_H
+
+/*
+ * Every register as X(name, reset value), in address order. The reset values
+ * of the status registers read 0 as nothing is latched on power-on.
+ */
+#define BQ25180_REGISTERS(X) \
+	X(STAT0,	0x00) \
+	X(STAT1,	0x00) \
+	X(FLAG0,	0x00) \
+	X(VBAT_CTRL,	0x46) \
+	X(ICHG_CTRL,	0x05) \
+	X(CHARGECTRL0,	0x2c) \
+	X(CHARGECTRL1,	0x56) \
+	X(IC_CTRL,	0x84) \
+	X(TMR_ILIM,	0x4d) \
+	X(SHIP_RST,	0x11) \
+	X(SYS_REG,	0x40) \
+	X(TS_CONTROL,	0x00) \
+	X(MASK_ID,	0xc0)
+
+/*
+ * Ranges and steps of the settings in physical units, encoded the same way by
+ * the C driver and the C++ wrapper.
+ */
+#define BQ25180_VBATREG_MIN_mV		3500U
+#define BQ25180_VBATREG_MAX_mV		4650U
+#define BQ25180_VBATREG_STEP_mV		10U
+
+/* 5mA to 35mA in 1mA steps, then 40mA to 1000mA in 10mA steps */
+#define BQ25180_ICHG_MIN_mA		5U
+#define BQ25180_ICHG_MAX_mA		1000U
+#define BQ25180_ICHG_FINE_MAX_mA	35U
+#define BQ25180_ICHG_COARSE_STEP_mA	10U
+
+#define BQ25180_BUVLO_MIN_mV		2000U
+#define BQ25180_BUVLO_MAX_mV		3000U
+#define BQ25180_BUVLO_STEP_mV		200U
+
+/* VLOWV_SEL set selects the lower one */
+#define BQ25180_VLOWV_LOW_mV		2800U
+#define BQ25180_VLOWV_HIGH_mV		3000U
+
+/* Value of each code, in the order of the codes */
+#define BQ25180_BUVLO_CODES_mV \
+	3000, 3000, 3000, 2800, 2600, 2400, 2200, 2000
+#define BQ25180_ITERM_CODES_PCT \
+	0, 5, 10, 20
+#define BQ25180_ILIM_CODES_mA \
+	50, 100, 200, 300, 400, 500, 700, 1100
+
+/*
+ * Every register field as X(name, register, shift, width), in register order
+ * from the MSB down. Reserved bits are left out. The field accessors, the
+ * decoders and the configuration image are all built on this one list.
+ *
+ * Register names are left for the includer to resolve, so that C and C++
+ * can each expand the list against their own register enumeration.
+ */
+#define BQ25180_FIELDS(X) \
+	X(TS_OPEN_STAT,		STAT0,		7, 1) \
+	X(CHG_STAT,		STAT0,		5, 2) \
+	X(ILIM_ACTIVE_STAT,	STAT0,		4, 1) \
+	X(VDPPM_ACTIVE_STAT,	STAT0,		3, 1) \
+	X(VINDPM_ACTIVE_STAT,	STAT0,		2, 1) \
+	X(THERMREG_ACTIVE_STAT,	STAT0,		1, 1) \
+	X(VIN_PGOOD_STAT,	STAT0,		0, 1) \
+	X(VIN_OVP_STAT,		STAT1,		7, 1) \
+	X(BUVLO_STAT,		STAT1,		6, 1) \
+	X(TS_STAT,		STAT1,		3, 2) \
+	X(SAFETY_TMR_FAULT_FLAG, STAT1,		2, 1) \
+	X(WAKE1_FLAG,		STAT1,		1, 1) \
+	X(WAKE2_FLAG,		STAT1,		0, 1) \
+	X(TS_FAULT,		FLAG0,		7, 1) \
+	X(ILIM_ACTIVE_FLAG,	FLAG0,		6, 1) \
+	X(VDPPM_ACTIVE_FLAG,	FLAG0,		5, 1) \
+	X(VINDPM_ACTIVE_FLAG,	FLAG0,		4, 1) \
+	X(THERMREG_ACTIVE_FLAG,	FLAG0,		3, 1) \
+	X(VIN_OVP_FAULT_FLAG,	FLAG0,		2, 1) \
+	X(BUVLO_FAULT_FLAG,	FLAG0,		1, 1) \
+	X(BAT_OCP_FAULT,	FLAG0,		0, 1) \
+	X(VBATREG,		VBAT_CTRL,	0, 7) \
+	X(CHG_DIS,		ICHG_CTRL,	7, 1) \
+	X(ICHG,			ICHG_CTRL,	0, 7) \
+	X(IPRECHG,		CHARGECTRL0,	6, 1) \
+	X(ITERM,		CHARGECTRL0,	4, 2) \
+	X(VINDPM,		CHARGECTRL0,	2, 2) \
+	X(THERM_REG,		CHARGECTRL0,	0, 2) \
+	X(IBAT_OCP,		CHARGECTRL1,	6, 2) \
+	X(BUVLO,		CHARGECTRL1,	3, 3) \
+	X(CHG_STATUS_INT_MASK,	CHARGECTRL1,	2, 1) \
+	X(ILIM_INT_MASK,	CHARGECTRL1,	1, 1) \
+	X(VDPM_INT_MASK,	CHARGECTRL1,	0, 1) \
+	X(TS_EN,		IC_CTRL,	7, 1) \
+	X(VLOWV_SEL,		IC_CTRL,	6, 1) \
+	X(VRCH,			IC_CTRL,	5, 1) \
+	X(TMR2X_EN,		IC_CTRL,	4, 1) \
+	X(SAFETY_TIMER,		IC_CTRL,	2, 2) \
+	X(WATCHDOG_SEL,		IC_CTRL,	0, 2) \
+	X(MR_LPRESS,		TMR_ILIM,	6, 2) \
+	X(MR_RESET_VIN,		TMR_ILIM,	5, 1) \
+	X(AUTOWAKE,		TMR_ILIM,	3, 2) \
+	X(ILIM,			TMR_ILIM,	0, 3) \
+	X(REG_RST,		SHIP_RST,	7, 1) \
+	X(EN_RST_SHIP,		SHIP_RST,	5, 2) \
+	X(PB_LPRESS_ACTION,	SHIP_RST,	3, 2) \
+	X(WAKE1_TMR,		SHIP_RST,	2, 1) \
+	X(WAKE2_TMR,		SHIP_RST,	1, 1) \
+	X(EN_PUSH,		SHIP_RST,	0, 1) \
+	X(SYS_REG_CTRL,		SYS_REG,	5, 3) \
+	X(SYS_MODE,		SYS_REG,	2, 2) \
+	X(WATCHDOG_15S_ENABLE,	SYS_REG,	1, 1) \
+	X(VDPPM_DIS,		SYS_REG,	0, 1) \
+	X(TS_HOT,		TS_CONTROL,	6, 2) \
+	X(TS_COLD,		TS_CONTROL,	4, 2) \
+	X(TS_WARM,		TS_CONTROL,	3, 1) \
+	X(TS_COOL,		TS_CONTROL,	2, 1) \
+	X(TS_ICHG,		TS_CONTROL,	1, 1) \
+	X(TS_VRCG,		TS_CONTROL,	0, 1) \
+	X(TS_INT_MASK,		MASK_ID,	7, 1) \
+	X(TREG_INT_MASK,	MASK_ID,	6, 1) \
+	X(BAT_INT_MASK,		MASK_ID,	5, 1) \
+	X(PG_INT_MASK,		MASK_ID,	4, 1) \
+	X(DEVICE_ID,		MASK_ID,	0, 4)
+
+#endif /* LIBMCU_BQ25180_FIELDS_H */
@@ -0,0 +1,234 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_governor.h"
+#include "bq25180_internal.h"
+#include <string.h>
+
+#if !defined(assert)
+#define assert(exp)
+#endif
+
+/* Rounded down to what the device can take */
+static uint16_t round_fastcharge(uint32_t milliampere)
+{
+	return bq25180_decode_fastcharge_current(
+			bq25180_encode_fastcharge_current(
+				(uint16_t)(milliampere > 1000? 1000 :
+					milliampere)));
+}
+
+static bool decide(struct bq25180_governor *gov,
+		enum bq25180_governor_decision decision, uint16_t ichg)
+{
+	const uint16_t from = gov->ichg;
+
+	if (!bq25180_dev_set_fastcharge_current(gov->dev, ichg)) {
+		return false;
+	}
+
+	gov->ichg = ichg;
+	gov->regulating_ms = 0;
+	gov->idle_ms = 0;
+	gov->last = decision;
+	gov->stats.fastcharge_milliampere = ichg;
+
+	if (gov->cb) {
+		gov->cb(decision, from, ichg, gov->cb_ctx);
+	}
+
+	return true;
+}
+
+static bool trim(struct bq25180_governor *gov)
+{
+	const struct bq25180_governor_config *cfg = &gov->cfg;
+	const uint16_t tripped = gov->ichg;
+	const bool failed_probe = gov->last == BQ25180_GOVERNOR_PROBE;
+	uint32_t ichg;
+
+	if (gov->last == BQ25180_GOVERNOR_RAISE || failed_probe) {
+		/* Straight back to where it held */
+		ichg = gov->prev_ichg;
+	} else {
+		const uint32_t cut = tripped * cfg->trim_pct / 100U;
+		ichg = tripped - (cut? cut : 1U);
+		ichg = round_fastcharge(ichg < cfg->min_milliampere?
+				cfg->min_milliampere : ichg);
+	}
+
+	if (!decide(gov, BQ25180_GOVERNOR_TRIM, (uint16_t)ichg)) {
+		return false;
+	}
+
+	if (failed_probe) {
+		const uint32_t delay = gov->probe_delay_ms * 2;
+		gov->probe_delay_ms = delay < cfg->max_probe_delay_ms?
+			delay : cfg->max_probe_delay_ms;
+		gov->stats.failed_probes++;
+	}
+
+	gov->ceiling = tripped;
+	gov->stats.trims++;
+
+	return true;
+}
+
+static uint16_t get_raise_target(const struct bq25180_governor *gov)
+{
+	const struct bq25180_governor_config *cfg = &gov->cfg;
+	const uint32_t ichg = (uint32_t)gov->ichg + cfg->raise_milliampere;
+
+	return round_fastcharge(ichg > cfg->max_milliampere?
+			cfg->max_milliampere : ichg);
+}
+
+static bool is_probe(const struct bq25180_governor *gov, uint16_t target)
+{
+	return gov->ceiling && target >= gov->ceiling;
+}
+
+static bool raise(struct bq25180_governor *gov, uint16_t target)
+{
+	const uint16_t prev = gov->ichg;
+	const bool probe = is_probe(gov, target);
+
+	if (!decide(gov, probe? BQ25180_GOVERNOR_PROBE :
+			BQ25180_GOVERNOR_RAISE, target)) {
+		return false;
+	}
+
+	gov->prev_ichg = prev;
+	gov->stats.raises++;
+	if (probe) {
+		gov->stats.probes++;
+	}
+
+	return true;
+}
+
+static void forget_ceiling(struct bq25180_governor *gov)
+{
+	gov->ceiling = 0;
+	gov->probe_delay_ms = gov->cfg.raise_delay_ms;
+}
+
+static bool step(struct bq25180_governor *gov)
+{
+	const struct bq25180_governor_config *cfg = &gov->cfg;
+
+	if (gov->regulating_ms >= cfg->trim_delay_ms) {
+		return gov->ichg > cfg->min_milliampere? trim(gov) : true;
+	}
+
+	if (gov->idle_ms < cfg->raise_delay_ms) {
+		return true;
+	}
+
+	if (gov->last == BQ25180_GOVERNOR_PROBE) {
+		/* The probe held. Conditions got better */
+		forget_ceiling(gov);
+	}
+
+	const uint16_t target = get_raise_target(gov);
+
+	if (target <= gov->ichg || (is_probe(gov, target) &&
+			gov->idle_ms < gov->probe_delay_ms)) {
+		return true;
+	}
+
+	return raise(gov, target);
+}
+
+void bq25180_governor_get_default_config(struct bq25180_governor_config *cfg)
+{
+	assert(cfg != NULL);
+
+	*cfg = (struct bq25180_governor_config) {
+		.max_milliampere = 1000,
+		.min_milliampere = 40,
+		.trim_pct = 10,
+		.raise_milliampere = 20,
+		.trim_delay_ms = 1000,
+		.raise_delay_ms = 30000,
+		.max_probe_delay_ms = 600000,
+	};
+}
+
+void bq25180_governor_init(struct bq25180_governor *gov, struct bq25180 *dev,
+		const struct bq25180_governor_config *cfg,
+		bq25180_governor_callback_t cb, void *cb_ctx)
+{
+	assert(gov != NULL && dev != NULL);
+
+	memset(gov, 0, sizeof(*gov));
+
+	gov->dev = dev;
+	gov->cb = cb;
+	gov->cb_ctx = cb_ctx;
+
+	if (cfg) {
+		gov->cfg = *cfg;
+	} else {
+		bq25180_governor_get_default_config(&gov->cfg);
+	}
+
+	assert(gov->cfg.min_milliampere >= 5 &&
+			gov->cfg.min_milliampere <= gov->cfg.max_milliampere &&
+			gov->cfg.max_milliampere <= 1000);
+	assert(gov->cfg.raise_milliampere >= 10);
+
+	gov->probe_delay_ms = gov->cfg.raise_delay_ms;
+	gov->stats.probe_delay_ms = gov->probe_delay_ms;
+}
+
+bool bq25180_governor_update(struct bq25180_governor *gov,
+		const struct bq25180_state *state, uint32_t now_ms)
+{
+	const struct bq25180_governor_config *cfg = &gov->cfg;
+	bool ok = true;
+
+	if (!gov->started) {
+		if (!decide(gov, BQ25180_GOVERNOR_START,
+				round_fastcharge(cfg->max_milliampere))) {
+			return false;
+		}
+		gov->started = true;
+		gov->timestamp = now_ms;
+		return true;
+	}
+
+	const uint32_t elapsed = now_ms - gov->timestamp;
+	gov->timestamp = now_ms;
+
+	if (state->thermal_regulation_active) {
+		gov->stats.regulation_ms += elapsed;
+		gov->regulating_ms += elapsed;
+		gov->idle_ms = 0;
+	} else {
+		gov->idle_ms += elapsed;
+		gov->regulating_ms = 0;
+	}
+
+	if (state->vin_good) {
+		ok = step(gov);
+	} else {
+		/* Nothing to learn on battery */
+		gov->idle_ms = 0;
+	}
+
+	gov->stats.probe_delay_ms = gov->probe_delay_ms;
+	gov->stats.ceiling_milliampere = gov->ceiling;
+
+	return ok;
+}
+
+void bq25180_governor_get_stats(const struct bq25180_governor *gov,
+		struct bq25180_governor_stats *stats)
+{
+	assert(stats != NULL);
+	*stats = gov->stats;
+}
@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_GOVERNOR_H
+#define LIBMCU_BQ25180_GOVERNOR_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+enum bq25180_governor_decision {
+	BQ25180_GOVERNOR_START, /**< the maximum written on the first update */
+	BQ25180_GOVERNOR_TRIM, /**< cut as thermal regulation kept on */
+	BQ25180_GOVERNOR_RAISE, /**< stepped up as it kept off */
+	BQ25180_GOVERNOR_PROBE, /**< stepped up to where it tripped before */
+};
+
+/**
+ * @brief Decision callback
+ *
+ * @param[in] decision @ref bq25180_governor_decision
+ * @param[in] from_milliampere fast charge current before
+ * @param[in] to_milliampere fast charge current written
+ * @param[in] ctx user context given to @ref bq25180_governor_init
+ */
+typedef void (*bq25180_governor_callback_t)(
+		enum bq25180_governor_decision decision,
+		uint16_t from_milliampere, uint16_t to_milliampere, void *ctx);
+
+struct bq25180_governor_config {
+	uint16_t max_milliampere; /**< fast charge current to aim at */
+	uint16_t min_milliampere; /**< never trimmed below */
+	uint8_t trim_pct; /**< cut per trim in percent of the current */
+	uint16_t raise_milliampere; /**< step per raise, 10mA or more */
+	/** In thermal regulation this long before trimming */
+	uint32_t trim_delay_ms;
+	/** Out of thermal regulation this long before raising */
+	uint32_t raise_delay_ms;
+	/** The wait before a probe is doubled every time the probe fails,
+	 * starting from the raise delay, up to this */
+	uint32_t max_probe_delay_ms;
+};
+
+struct bq25180_governor_stats {
+	uint32_t regulation_ms; /**< time spent in thermal regulation */
+	uint32_t trims;
+	uint32_t raises;
+	uint32_t probes; /**< raises up to the ceiling, included in raises */
+	uint32_t failed_probes;
+	uint32_t probe_delay_ms; /**< the wait before the next probe */
+	uint16_t fastcharge_milliampere; /**< the current in effect */
+	/** The lowest current that ended up in thermal regulation, or 0 */
+	uint16_t ceiling_milliampere;
+};
+
+/**
+ * @brief Fast charge current governor
+ *
+ * Members are private to the driver. Initialize it with
+ * @ref bq25180_governor_init.
+ */
+struct bq25180_governor {
+	struct bq25180 *dev;
+	struct bq25180_governor_config cfg;
+	bq25180_governor_callback_t cb;
+	void *cb_ctx;
+
+	bool started; /* ichg written and timestamp valid */
+	uint16_t ichg;
+	uint16_t prev_ichg; /* before the last raise */
+	uint16_t ceiling; /* 0 if none */
+	uint32_t timestamp;
+	uint32_t regulating_ms; /* for how long it has been on or off */
+	uint32_t idle_ms;
+	uint32_t probe_delay_ms;
+	enum bq25180_governor_decision last;
+	struct bq25180_governor_stats stats;
+};
+
+/**
+ * @brief Get the default configuration
+ *
+ * 1000mA down to 40mA. 10% cut after 1s in thermal regulation, 20mA up after
+ * 30s out of it, probing backed off up to 10min.
+ *
+ * @param[out] cfg @ref bq25180_governor_config
+ */
+void bq25180_governor_get_default_config(struct bq25180_governor_config *cfg);
+
+/**
+ * @brief Initialize a fast charge current governor
+ *
+ * When the die gets hot, the device pulls the charge current back and lets
+ * it go again as it cools down, over and over. The governor trims the fast
+ * charge current it owns to just below where that happens and steps it back
+ * up as conditions improve.
+ *
+ * The current that tripped is remembered as the ceiling. Stepping up to it
+ * again is a probe: a failed probe goes straight back to the current before
+ * it and doubles the wait before the next one, so that it settles instead of
+ * cycling. A probe that holds for the raise delay clears the ceiling.
+ *
+ * Nothing else should set the fast charge current meanwhile. No bus access
+ * is made here.
+ *
+ * @param[in] gov @ref bq25180_governor
+ * @param[in] dev device handle
+ * @param[in] cfg @ref bq25180_governor_config. The defaults if NULL
+ * @param[in] cb @ref bq25180_governor_callback_t. Can be NULL
+ * @param[in] cb_ctx user context to be passed to @p cb
+ */
+void bq25180_governor_init(struct bq25180_governor *gov, struct bq25180 *dev,
+		const struct bq25180_governor_config *cfg,
+		bq25180_governor_callback_t cb, void *cb_ctx);
+
+/**
+ * @brief Account the state just read and trim or raise if due
+ *
+ * The time since the previous update is taken as spent in the state given.
+ * At most one write is made per update.
+ *
+ * @param[in] gov @ref bq25180_governor
+ * @param[in] state @ref bq25180_state read from the device
+ * @param[in] now_ms current time in milliseconds. Wrap-around is fine
+ *
+ * @return true on success or false. A failed write is retried on the next
+ *         call
+ */
+bool bq25180_governor_update(struct bq25180_governor *gov,
+		const struct bq25180_state *state, uint32_t now_ms);
+
+/**
+ * @brief Get the statistics
+ *
+ * @param[in] gov @ref bq25180_governor
+ * @param[out] stats @ref bq25180_governor_stats
+ */
+void bq25180_governor_get_stats(const struct bq25180_governor *gov,
+		struct bq25180_governor_stats *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_GOVERNOR_H */
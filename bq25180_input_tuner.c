@@ -0,0 +1,176 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_input_tuner.h"
+#include "bq25180_internal.h"
+#include <string.h>
+
+#if !defined(assert)
+#define assert(exp)
+#endif
+
+static bool write_ilim(struct bq25180_input_tuner *tuner, uint8_t code)
+{
+	if (!bq25180_dev_set_input_current(tuner->dev,
+			bq25180_decode_input_current(code))) {
+		return false;
+	}
+
+	tuner->ilim = code;
+	return true;
+}
+
+static bool write_vindpm(struct bq25180_input_tuner *tuner, uint8_t vindpm)
+{
+	if (!bq25180_dev_enable_vindpm(tuner->dev,
+			(enum bq25180_vindpm)vindpm)) {
+		return false;
+	}
+
+	tuner->vindpm = vindpm;
+	return true;
+}
+
+static bool start_session(struct bq25180_input_tuner *tuner)
+{
+	const struct bq25180_input_tuner_config *cfg = &tuner->cfg;
+
+	/* The last session is no more once its settings are overwritten */
+	tuner->found = false;
+	tuner->ceiling = bq25180_encode_input_current(cfg->max_milliampere);
+	tuner->up = 0;
+	tuner->down = 0;
+
+	if (!write_vindpm(tuner, (uint8_t)cfg->vindpm) ||
+			!write_ilim(tuner, bq25180_encode_input_current(
+					cfg->start_milliampere))) {
+		return false;
+	}
+
+	tuner->session = true;
+	tuner->found = true;
+	return true;
+}
+
+static bool step_down(struct bq25180_input_tuner *tuner)
+{
+	if (tuner->vindpm > (uint8_t)tuner->cfg.min_vindpm) {
+		if (!write_vindpm(tuner, (uint8_t)(tuner->vindpm - 1))) {
+			return false;
+		}
+	} else if (tuner->ilim > 0) {
+		if (!write_ilim(tuner, (uint8_t)(tuner->ilim - 1))) {
+			return false;
+		}
+		tuner->ceiling = tuner->ilim;
+	} else {
+		return true;
+	}
+
+	tuner->steps++;
+	return true;
+}
+
+void bq25180_input_tuner_get_default_config(
+		struct bq25180_input_tuner_config *cfg)
+{
+	assert(cfg != NULL);
+
+	*cfg = (struct bq25180_input_tuner_config) {
+		.start_milliampere = 500,
+		.max_milliampere = 1100,
+		.vindpm = BQ25180_VINDPM_4700mV,
+		.min_vindpm = BQ25180_VINDPM_4200mV,
+		.up_samples = 3,
+		.down_samples = 1,
+	};
+}
+
+void bq25180_input_tuner_init(struct bq25180_input_tuner *tuner,
+		struct bq25180 *dev,
+		const struct bq25180_input_tuner_config *cfg)
+{
+	assert(tuner != NULL && dev != NULL);
+
+	memset(tuner, 0, sizeof(*tuner));
+
+	tuner->dev = dev;
+
+	if (cfg) {
+		tuner->cfg = *cfg;
+	} else {
+		bq25180_input_tuner_get_default_config(&tuner->cfg);
+	}
+
+	assert(tuner->cfg.vindpm != BQ25180_VINDPM_DISABLE);
+	assert(tuner->cfg.min_vindpm <= tuner->cfg.vindpm);
+	assert(tuner->cfg.start_milliampere <= tuner->cfg.max_milliampere);
+}
+
+bool bq25180_input_tuner_update(struct bq25180_input_tuner *tuner,
+		const struct bq25180_state *state)
+{
+	if (!state->vin_good) {
+		tuner->session = false;
+		return true;
+	}
+
+	if (!tuner->session) {
+		return start_session(tuner);
+	}
+
+	if (state->vindpm_active) {
+		tuner->up = 0;
+		if (++tuner->down < tuner->cfg.down_samples) {
+			return true;
+		}
+		tuner->down = 0;
+		return step_down(tuner);
+	}
+
+	tuner->down = 0;
+
+	if (!(state->ilim_active || state->vdppm_active) ||
+			tuner->ilim >= tuner->ceiling) {
+		tuner->up = 0;
+		return true;
+	}
+
+	if (++tuner->up < tuner->cfg.up_samples) {
+		return true;
+	}
+	tuner->up = 0;
+	if (!write_ilim(tuner, (uint8_t)(tuner->ilim + 1))) {
+		return false;
+	}
+	tuner->steps++;
+
+	return true;
+}
+
+bool bq25180_input_tuner_get_result(const struct bq25180_input_tuner *tuner,
+		struct bq25180_input_tuner_result *result)
+{
+	assert(result != NULL);
+
+	if (!tuner->found) {
+		return false;
+	}
+
+	*result = (struct bq25180_input_tuner_result) {
+		.input_milliampere = bq25180_decode_input_current(tuner->ilim),
+		.vindpm = (enum bq25180_vindpm)tuner->vindpm,
+		.limited = tuner->ceiling < bq25180_encode_input_current(
+				tuner->cfg.max_milliampere),
+	};
+
+	return true;
+}
+
+uint32_t bq25180_input_tuner_steps(const struct bq25180_input_tuner *tuner)
+{
+	return tuner->steps;
+}
@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_INPUT_TUNER_H
+#define LIBMCU_BQ25180_INPUT_TUNER_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+struct bq25180_input_tuner_config {
+	uint16_t start_milliampere; /**< ILIM on plug-in */
+	uint16_t max_milliampere; /**< never goes above */
+	enum bq25180_vindpm vindpm; /**< threshold on plug-in */
+	/** Lowest threshold to go down to, not below what the system needs */
+	enum bq25180_vindpm min_vindpm;
+	/** Consecutive updates limited by ILIM or DPPM before stepping up */
+	uint8_t up_samples;
+	/** Consecutive updates in VINDPM before stepping down */
+	uint8_t down_samples;
+};
+
+struct bq25180_input_tuner_result {
+	uint16_t input_milliampere;
+	enum bq25180_vindpm vindpm;
+	bool limited; /**< the adapter could not take the maximum */
+};
+
+/**
+ * @brief Input current tuner
+ *
+ * Members are private to the driver. Initialize it with
+ * @ref bq25180_input_tuner_init.
+ */
+struct bq25180_input_tuner {
+	struct bq25180 *dev;
+	struct bq25180_input_tuner_config cfg;
+
+	bool session; /* VIN present and the settings written */
+	bool found; /* ilim, ceiling and vindpm hold a result */
+	uint8_t ilim; /* ILIM code */
+	uint8_t ceiling; /* highest ILIM code known to be stable */
+	uint8_t vindpm;
+	uint8_t up;
+	uint8_t down;
+	uint32_t steps;
+};
+
+/**
+ * @brief Get the default configuration
+ *
+ * 500mA and 4.7V to start with, up to 1100mA and down to 4.2V. Three updates
+ * before stepping up and one before stepping down.
+ *
+ * @param[out] cfg @ref bq25180_input_tuner_config
+ */
+void bq25180_input_tuner_get_default_config(
+		struct bq25180_input_tuner_config *cfg);
+
+/**
+ * @brief Initialize an input current tuner
+ *
+ * A weak adapter collapses into VINDPM well below the input current a static
+ * setting asks for. Charging then crawls at the threshold, or oscillates with
+ * adapters folding back. The tuner looks for the highest input current each
+ * adapter takes without falling into VINDPM.
+ *
+ * While limited by ILIM or DPPM, ILIM is stepped up one code at a time. As
+ * soon as VINDPM kicks in, the threshold is lowered first for more headroom.
+ * At the lowest threshold, ILIM is stepped back down and that becomes the
+ * ceiling for the rest of the session, so that it settles instead of going
+ * back and forth. A session lasts until VIN is removed.
+ *
+ * No bus access is made here.
+ *
+ * @param[in] tuner @ref bq25180_input_tuner
+ * @param[in] dev device handle
+ * @param[in] cfg @ref bq25180_input_tuner_config. The defaults if NULL
+ */
+void bq25180_input_tuner_init(struct bq25180_input_tuner *tuner,
+		struct bq25180 *dev,
+		const struct bq25180_input_tuner_config *cfg);
+
+/**
+ * @brief Step the input settings on the state just read
+ *
+ * The start settings are written when VIN shows up. Afterward at most one
+ * register is written per update.
+ *
+ * @param[in] tuner @ref bq25180_input_tuner
+ * @param[in] state @ref bq25180_state read from the device
+ *
+ * @return true on success or false. A failed update is retried on the next
+ *         call
+ */
+bool bq25180_input_tuner_update(struct bq25180_input_tuner *tuner,
+		const struct bq25180_state *state);
+
+/**
+ * @brief Get what the tuner has found so far
+ *
+ * Once VIN is removed, the result of the session just ended is kept until
+ * the next one starts.
+ *
+ * @param[in] tuner @ref bq25180_input_tuner
+ * @param[out] result @ref bq25180_input_tuner_result
+ *
+ * @return true on success or false if no session has started yet
+ */
+bool bq25180_input_tuner_get_result(const struct bq25180_input_tuner *tuner,
+		struct bq25180_input_tuner_result *result);
+
+/**
+ * @brief Get the number of steps taken
+ *
+ * @param[in] tuner @ref bq25180_input_tuner
+ *
+ * @return the number of steps since initialized, start settings excluded
+ */
+uint32_t bq25180_input_tuner_steps(const struct bq25180_input_tuner *tuner);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_INPUT_TUNER_H */
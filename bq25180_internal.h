@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_INTERNAL_H
+#define LIBMCU_BQ25180_INTERNAL_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+#include "bq25180_fields.h"
+
+#define MIN_BAT_REG_mV		BQ25180_VBATREG_MIN_mV
+#define MAX_BAT_REG_mV		BQ25180_VBATREG_MAX_mV
+
+#define MIN_BAT_UNDERVOLTAGE_mV	BQ25180_BUVLO_MIN_mV
+#define MAX_BAT_UNDERVOLTAGE_mV	BQ25180_BUVLO_MAX_mV
+
+#define MIN_IN_CURR_mA		BQ25180_ICHG_MIN_mA
+#define MAX_IN_CURR_mA		BQ25180_ICHG_MAX_mA
+
+enum registers {
+#define REGISTER_ENUM(name, reset)	name,
+	BQ25180_REGISTERS(REGISTER_ENUM)
+#undef REGISTER_ENUM
+	NR_REGISTERS,
+};
+
+enum fields {
+#define FIELD_ENUM(name, reg, shift, width)	FIELD_##name,
+	BQ25180_FIELDS(FIELD_ENUM)
+#undef FIELD_ENUM
+	NR_FIELDS,
+};
+
+struct field {
+	uint8_t reg;
+	uint8_t shift;
+	uint8_t mask; /* in place */
+};
+
+extern const struct field bq25180_fields[NR_FIELDS];
+
+#define FIELD_MASK(name)	(bq25180_fields[FIELD_##name].mask)
+
+static inline uint8_t get_field(const uint8_t regs[NR_REGISTERS],
+		enum fields field)
+{
+	const struct field *f = &bq25180_fields[field];
+	return (uint8_t)((regs[f->reg] & f->mask) >> f->shift);
+}
+
+static inline bool test_field(const uint8_t regs[NR_REGISTERS],
+		enum fields field)
+{
+	const struct field *f = &bq25180_fields[field];
+	return (regs[f->reg] & f->mask) != 0;
+}
+
+static inline void put_field(uint8_t regs[NR_REGISTERS],
+		enum fields field, uint8_t val)
+{
+	const struct field *f = &bq25180_fields[field];
+	regs[f->reg] = (uint8_t)((regs[f->reg] & ~f->mask) |
+			((val << f->shift) & f->mask));
+}
+
+uint8_t bq25180_encode_battery_regulation_voltage(uint16_t millivoltage);
+uint8_t bq25180_encode_battery_under_voltage(uint16_t millivoltage);
+uint8_t bq25180_encode_precharge_threshold(uint16_t millivoltage);
+uint8_t bq25180_encode_fastcharge_current(uint16_t milliampere);
+uint8_t bq25180_encode_termination_current(uint8_t pct);
+uint8_t bq25180_encode_input_current(uint16_t milliampere);
+
+uint16_t bq25180_decode_battery_regulation_voltage(uint8_t code);
+uint16_t bq25180_decode_battery_under_voltage(uint8_t code);
+uint16_t bq25180_decode_precharge_threshold(uint8_t code);
+uint16_t bq25180_decode_fastcharge_current(uint8_t code);
+uint8_t bq25180_decode_termination_current(uint8_t code);
+uint16_t bq25180_decode_input_current(uint8_t code);
+
+void bq25180_decode_event(uint8_t val, struct bq25180_event *p);
+void bq25180_decode_config(const uint8_t regs[NR_REGISTERS],
+		struct bq25180_config *cfg);
+void bq25180_decode_state(uint8_t val0, uint8_t val1, struct bq25180_state *p);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_INTERNAL_H */
@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_poll.h"
+#include <string.h>
+
+#if !defined(assert)
+#define assert(exp)
+#endif
+
+static bool is_due(uint32_t now, uint32_t deadline)
+{
+	return (int32_t)(now - deadline) >= 0;
+}
+
+static uint16_t get_changes(const struct bq25180_state *prev,
+		const struct bq25180_state *cur)
+{
+	uint16_t changed = 0;
+
+	if (cur->vin_good != prev->vin_good) {
+		changed |= BQ25180_CHANGE_VIN_GOOD;
+	}
+	if (cur->thermal_regulation_active != prev->thermal_regulation_active) {
+		changed |= BQ25180_CHANGE_THERMAL_REGULATION;
+	}
+	if (cur->vindpm_active != prev->vindpm_active) {
+		changed |= BQ25180_CHANGE_VINDPM;
+	}
+	if (cur->vdppm_active != prev->vdppm_active) {
+		changed |= BQ25180_CHANGE_VDPPM;
+	}
+	if (cur->ilim_active != prev->ilim_active) {
+		changed |= BQ25180_CHANGE_ILIM;
+	}
+	if (cur->charging_status != prev->charging_status) {
+		changed |= BQ25180_CHANGE_CHARGING_STATUS;
+	}
+	if (cur->tsmr_open != prev->tsmr_open) {
+		changed |= BQ25180_CHANGE_TSMR_OPEN;
+	}
+	if (cur->wake2_raised != prev->wake2_raised) {
+		changed |= BQ25180_CHANGE_WAKE2;
+	}
+	if (cur->wake1_raised != prev->wake1_raised) {
+		changed |= BQ25180_CHANGE_WAKE1;
+	}
+	if (cur->safety_timer_fault != prev->safety_timer_fault) {
+		changed |= BQ25180_CHANGE_SAFETY_TIMER;
+	}
+	if (cur->ts_status != prev->ts_status) {
+		changed |= BQ25180_CHANGE_TS_STATUS;
+	}
+	if (cur->battery_undervoltage_active !=
+			prev->battery_undervoltage_active) {
+		changed |= BQ25180_CHANGE_BATTERY_UNDERVOLTAGE;
+	}
+	if (cur->vin_overvoltage_active != prev->vin_overvoltage_active) {
+		changed |= BQ25180_CHANGE_VIN_OVERVOLTAGE;
+	}
+
+	return changed;
+}
+
+static bool has_event(const struct bq25180_event *event)
+{
+	static const struct bq25180_event none;
+	return memcmp(event, &none, sizeof(none)) != 0;
+}
+
+static uint32_t get_interval(const struct bq25180_poll_config *cfg,
+		const struct bq25180_state *state, uint16_t changed,
+		bool event)
+{
+	if (!state->vin_good) {
+		return cfg->slow_interval_ms;
+	}
+
+	if ((changed & BQ25180_CHANGE_CHARGING_STATUS) || event ||
+			state->vindpm_active || state->vdppm_active ||
+			state->ilim_active ||
+			state->thermal_regulation_active) {
+		return cfg->fast_interval_ms;
+	}
+
+	return cfg->normal_interval_ms;
+}
+
+void bq25180_poll_get_default_config(struct bq25180_poll_config *cfg)
+{
+	assert(cfg != NULL);
+
+	*cfg = (struct bq25180_poll_config) {
+		.fast_interval_ms = 100,
+		.normal_interval_ms = 1000,
+		.slow_interval_ms = 10000,
+		.read_events = false,
+	};
+}
+
+void bq25180_poll_init(struct bq25180_poll *poll, struct bq25180 *dev,
+		const struct bq25180_poll_config *cfg,
+		bq25180_poll_callback_t cb, void *cb_ctx)
+{
+	assert(poll != NULL && dev != NULL);
+
+	memset(poll, 0, sizeof(*poll));
+
+	poll->dev = dev;
+	poll->cb = cb;
+	poll->cb_ctx = cb_ctx;
+
+	if (cfg) {
+		poll->cfg = *cfg;
+	} else {
+		bq25180_poll_get_default_config(&poll->cfg);
+	}
+
+	poll->interval_ms = poll->cfg.fast_interval_ms;
+}
+
+bool bq25180_poll_run(struct bq25180_poll *poll, uint32_t now_ms)
+{
+	struct bq25180_state state;
+	struct bq25180_event event;
+	bool pending = false;
+	uint16_t changed;
+
+	if (poll->scheduled && !is_due(now_ms, poll->deadline)) {
+		return true;
+	}
+
+	poll->scheduled = true;
+
+	if (!bq25180_dev_read_snapshot(poll->dev, &state,
+			poll->cfg.read_events? &event : NULL)) {
+		poll->deadline = now_ms + poll->cfg.fast_interval_ms;
+		return false;
+	}
+
+	if (poll->cfg.read_events) {
+		pending = has_event(&event);
+	}
+
+	/* Everything is news on the first poll but nothing to adapt to */
+	changed = poll->primed? get_changes(&poll->prev, &state) : 0;
+	poll->interval_ms = get_interval(&poll->cfg, &state, changed, pending);
+	poll->deadline = now_ms + poll->interval_ms;
+
+	if (!poll->primed) {
+		changed = BQ25180_CHANGE_ALL;
+		poll->primed = true;
+	}
+
+	poll->prev = state;
+
+	if ((changed || pending) && poll->cb) {
+		poll->cb(&state, changed, pending? &event : NULL,
+				poll->cb_ctx);
+	}
+
+	return true;
+}
+
+uint32_t bq25180_poll_next_deadline(const struct bq25180_poll *poll)
+{
+	return poll->deadline;
+}
+
+uint32_t bq25180_poll_time_to_deadline(const struct bq25180_poll *poll,
+		uint32_t now_ms)
+{
+	if (!poll->scheduled || is_due(now_ms, poll->deadline)) {
+		return 0;
+	}
+
+	return poll->deadline - now_ms;
+}
+
+void bq25180_poll_kick(struct bq25180_poll *poll, uint32_t now_ms)
+{
+	poll->deadline = now_ms;
+}
@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_POLL_H
+#define LIBMCU_BQ25180_POLL_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+/** Members of @ref bq25180_state that changed since the previous poll */
+enum bq25180_change {
+	BQ25180_CHANGE_VIN_GOOD			= 0x0001,
+	BQ25180_CHANGE_THERMAL_REGULATION	= 0x0002,
+	BQ25180_CHANGE_VINDPM			= 0x0004,
+	BQ25180_CHANGE_VDPPM			= 0x0008,
+	BQ25180_CHANGE_ILIM			= 0x0010,
+	BQ25180_CHANGE_CHARGING_STATUS		= 0x0020,
+	BQ25180_CHANGE_TSMR_OPEN		= 0x0040,
+	BQ25180_CHANGE_WAKE2			= 0x0080,
+	BQ25180_CHANGE_WAKE1			= 0x0100,
+	BQ25180_CHANGE_SAFETY_TIMER		= 0x0200,
+	BQ25180_CHANGE_TS_STATUS		= 0x0400,
+	BQ25180_CHANGE_BATTERY_UNDERVOLTAGE	= 0x0800,
+	BQ25180_CHANGE_VIN_OVERVOLTAGE		= 0x1000,
+	BQ25180_CHANGE_ALL			= 0x1fff,
+};
+
+/**
+ * @brief Change callback
+ *
+ * Called only when something changed or, with events read, when any event is
+ * pending.
+ *
+ * @param[in] state @ref bq25180_state just read
+ * @param[in] changed combined @ref bq25180_change. All of them on the first
+ *            poll
+ * @param[in] event @ref bq25180_event if read and any is set, or NULL
+ * @param[in] ctx user context given to @ref bq25180_poll_init
+ */
+typedef void (*bq25180_poll_callback_t)(const struct bq25180_state *state,
+		uint16_t changed, const struct bq25180_event *event,
+		void *ctx);
+
+struct bq25180_poll_config {
+	/** While VIN is present and the charger is busy: the charging status
+	 * changing, or any of DPM, ILIM or thermal regulation active */
+	uint32_t fast_interval_ms;
+	/** While VIN is present and nothing is going on */
+	uint32_t normal_interval_ms;
+	/** On battery only */
+	uint32_t slow_interval_ms;
+	/** Read FLAG0 too, which the device clears on read */
+	bool read_events;
+};
+
+/**
+ * @brief Poll engine
+ *
+ * Members are private to the driver. Initialize it with
+ * @ref bq25180_poll_init.
+ */
+struct bq25180_poll {
+	struct bq25180 *dev;
+	struct bq25180_poll_config cfg;
+	bq25180_poll_callback_t cb;
+	void *cb_ctx;
+
+	struct bq25180_state prev;
+	bool primed; /* prev is valid */
+	bool scheduled; /* deadline is valid */
+	uint32_t interval_ms;
+	uint32_t deadline;
+};
+
+/**
+ * @brief Get the default poll intervals
+ *
+ * 100ms fast, 1s normal and 10s slow, without reading the events.
+ *
+ * @param[out] cfg @ref bq25180_poll_config
+ */
+void bq25180_poll_get_default_config(struct bq25180_poll_config *cfg);
+
+/**
+ * @brief Initialize a poll engine
+ *
+ * For boards without the interrupt line wired. The device state is read only
+ * when the deadline is reached, compared to the previous one and reported
+ * only if changed. The interval between polls follows what the charger is
+ * doing. No bus access is made here and the first poll is due at once.
+ *
+ * @param[in] poll @ref bq25180_poll
+ * @param[in] dev device handle to poll
+ * @param[in] cfg @ref bq25180_poll_config. The defaults if NULL
+ * @param[in] cb @ref bq25180_poll_callback_t. Can be NULL
+ * @param[in] cb_ctx user context to be passed to @p cb
+ */
+void bq25180_poll_init(struct bq25180_poll *poll, struct bq25180 *dev,
+		const struct bq25180_poll_config *cfg,
+		bq25180_poll_callback_t cb, void *cb_ctx);
+
+/**
+ * @brief Poll the device if due
+ *
+ * Nothing is done before the deadline.
+ *
+ * @param[in] poll @ref bq25180_poll
+ * @param[in] now_ms current time in milliseconds. Wrap-around is fine
+ *
+ * @return false if the device could not be read, or true. A failed poll is
+ *         retried after the fast interval
+ */
+bool bq25180_poll_run(struct bq25180_poll *poll, uint32_t now_ms);
+
+/**
+ * @brief Get the time the next poll is due
+ *
+ * @param[in] poll @ref bq25180_poll
+ *
+ * @return the deadline in the time base of @ref bq25180_poll_run
+ */
+uint32_t bq25180_poll_next_deadline(const struct bq25180_poll *poll);
+
+/**
+ * @brief Get how long the host can sleep before the next poll
+ *
+ * @param[in] poll @ref bq25180_poll
+ * @param[in] now_ms current time in milliseconds
+ *
+ * @return milliseconds until the deadline or 0 if already due
+ */
+uint32_t bq25180_poll_time_to_deadline(const struct bq25180_poll *poll,
+		uint32_t now_ms);
+
+/**
+ * @brief Make the next poll due at once
+ *
+ * For when something is known to have changed, like a cable plugged in.
+ *
+ * @param[in] poll @ref bq25180_poll
+ * @param[in] now_ms current time in milliseconds
+ */
+void bq25180_poll_kick(struct bq25180_poll *poll, uint32_t now_ms);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_POLL_H */
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_ring.h"
+
+#if !defined(assert)
+#define assert(exp)
+#endif
+
+/* Orders the record copy against the index update. Define it for compilers
+ * other than GCC and Clang. A compiler barrier is enough on a single core. */
+#if !defined(BQ25180_RING_BARRIER)
+#if defined(__GNUC__)
+#define BQ25180_RING_BARRIER()		__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define BQ25180_RING_BARRIER()
+#endif
+#endif
+
+typedef char ring_len_must_be_power_of_two
+	[(BQ25180_RING_LEN & (BQ25180_RING_LEN - 1)) == 0? 1 : -1];
+
+#define RING_INDEX(i)			((i) & (BQ25180_RING_LEN - 1))
+
+void bq25180_ring_init(struct bq25180_ring *ring)
+{
+	assert(ring != NULL);
+
+	ring->head = 0;
+	ring->tail = 0;
+	ring->overflows = 0;
+}
+
+bool bq25180_ring_push(struct bq25180_ring *ring,
+		const struct bq25180_ring_record *record)
+{
+	const uint32_t head = ring->head;
+
+	if (head - ring->tail >= BQ25180_RING_LEN) {
+		ring->overflows++;
+		return false;
+	}
+
+	/* The slot is not visible to the consumer until head moves */
+	BQ25180_RING_BARRIER();
+	ring->records[RING_INDEX(head)] = *record;
+	BQ25180_RING_BARRIER();
+	ring->head = head + 1;
+
+	return true;
+}
+
+bool bq25180_ring_pop(struct bq25180_ring *ring,
+		struct bq25180_ring_record *record)
+{
+	const uint32_t tail = ring->tail;
+
+	if (ring->head == tail) {
+		return false;
+	}
+
+	/* The slot is not reused by the producer until tail moves */
+	BQ25180_RING_BARRIER();
+	*record = ring->records[RING_INDEX(tail)];
+	BQ25180_RING_BARRIER();
+	ring->tail = tail + 1;
+
+	return true;
+}
+
+uint32_t bq25180_ring_count(const struct bq25180_ring *ring)
+{
+	return ring->head - ring->tail;
+}
+
+uint32_t bq25180_ring_overflows(const struct bq25180_ring *ring)
+{
+	return ring->overflows;
+}
+
+bool bq25180_ring_capture(struct bq25180_ring *ring, struct bq25180 *dev,
+		uint32_t timestamp)
+{
+	struct bq25180_ring_record record = { .timestamp = timestamp, };
+
+	/* Reading FLAG0 clears it. With no room, leave the events latched in
+	 * the device for a later capture rather than losing them here. */
+	if (ring->head - ring->tail >= BQ25180_RING_LEN) {
+		ring->overflows++;
+		return false;
+	}
+
+	if (!bq25180_dev_read_snapshot(dev, &record.state, &record.event)) {
+		return false;
+	}
+
+	return bq25180_ring_push(ring, &record);
+}
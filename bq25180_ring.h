@@ -0,0 +1,118 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_RING_H
+#define LIBMCU_BQ25180_RING_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+/* Must be a power of two */
+#if !defined(BQ25180_RING_LEN)
+#define BQ25180_RING_LEN		8
+#endif
+
+struct bq25180_ring_record {
+	uint32_t timestamp; /**< in the time base given on capture */
+	struct bq25180_state state;
+	struct bq25180_event event;
+};
+
+/**
+ * @brief Event history between the INT side and the application
+ *
+ * FLAG0 gets cleared on read, so whoever reads it first takes the events away
+ * from everyone else. Let only the INT side read it and push what it got here
+ * for the application to drain later.
+ *
+ * Only one context may push and only one may pop at a time. Neither takes a
+ * lock nor disables interrupts. Members are private to the driver. Initialize
+ * it with @ref bq25180_ring_init.
+ */
+struct bq25180_ring {
+	struct bq25180_ring_record records[BQ25180_RING_LEN];
+	/* Free-running. Each is written only by its own side */
+	volatile uint32_t head; /* producer */
+	volatile uint32_t tail; /* consumer */
+	volatile uint32_t overflows; /* producer */
+};
+
+/**
+ * @brief Initialize a ring
+ *
+ * @param[in] ring @ref bq25180_ring
+ */
+void bq25180_ring_init(struct bq25180_ring *ring);
+
+/**
+ * @brief Push a record. Producer side only
+ *
+ * A record that does not fit is dropped and counted, keeping the older ones.
+ *
+ * @param[in] ring @ref bq25180_ring
+ * @param[in] record @ref bq25180_ring_record to be copied in
+ *
+ * @return true on success or false if the ring is full
+ */
+bool bq25180_ring_push(struct bq25180_ring *ring,
+		const struct bq25180_ring_record *record);
+
+/**
+ * @brief Pop the oldest record. Consumer side only
+ *
+ * @param[in] ring @ref bq25180_ring
+ * @param[out] record @ref bq25180_ring_record
+ *
+ * @return true on success or false if the ring is empty
+ */
+bool bq25180_ring_pop(struct bq25180_ring *ring,
+		struct bq25180_ring_record *record);
+
+/**
+ * @brief Get the number of records to be popped
+ *
+ * @param[in] ring @ref bq25180_ring
+ *
+ * @return the number of records
+ */
+uint32_t bq25180_ring_count(const struct bq25180_ring *ring);
+
+/**
+ * @brief Get the number of records dropped as the ring was full
+ *
+ * @param[in] ring @ref bq25180_ring
+ *
+ * @return the number of records dropped since initialized
+ */
+uint32_t bq25180_ring_overflows(const struct bq25180_ring *ring);
+
+/**
+ * @brief Read the state and events and push them. Producer side only
+ *
+ * STAT0, STAT1 and FLAG0 are read in one burst with
+ * @ref bq25180_dev_read_snapshot. Meant for the INT handler, or the task it
+ * wakes up, so that no event gets lost between polls. Nothing is read while
+ * the ring is full, leaving the events latched in the device until the next
+ * capture finds room.
+ *
+ * @param[in] ring @ref bq25180_ring
+ * @param[in] dev device handle
+ * @param[in] timestamp time of the interrupt in any time base
+ *
+ * @return true on success or false if the device could not be read or the
+ *         ring is full
+ */
+bool bq25180_ring_capture(struct bq25180_ring *ring, struct bq25180 *dev,
+		uint32_t timestamp);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_RING_H */
@@ -0,0 +1,209 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_sched.h"
+#include <string.h>
+
+#if !defined(assert)
+#define assert(exp)
+#endif
+
+static uint32_t get_now(const struct bq25180_sched *sched)
+{
+	return sched->get_time? sched->get_time(sched->time_ctx) : 0;
+}
+
+static void account_transfer(const struct bq25180_sched_port *port)
+{
+	struct bq25180_sched *sched = port->sched;
+
+	if (sched->running) {
+		sched->queues[sched->running->prio].stats.transfers++;
+	} else {
+		sched->unscheduled++;
+	}
+}
+
+static int sched_read(void *ctx, uint8_t addr, uint8_t reg,
+		void *buf, size_t bufsize)
+{
+	const struct bq25180_sched_port *port =
+		(const struct bq25180_sched_port *)ctx;
+
+	account_transfer(port);
+
+	return port->bus->read(port->bus_ctx, addr, reg, buf, bufsize);
+}
+
+static int sched_write(void *ctx, uint8_t addr, uint8_t reg,
+		const void *data, size_t data_len)
+{
+	const struct bq25180_sched_port *port =
+		(const struct bq25180_sched_port *)ctx;
+
+	account_transfer(port);
+
+	return port->bus->write(port->bus_ctx, addr, reg, data, data_len);
+}
+
+const struct bq25180_bus bq25180_sched_bus = {
+	.read = sched_read,
+	.write = sched_write,
+};
+
+static struct bq25180_sched_job *dequeue(struct bq25180_sched *sched)
+{
+	for (int prio = 0; prio < BQ25180_SCHED_NR_PRIO; prio++) {
+		struct bq25180_sched_job *job = sched->queues[prio].head;
+
+		if (job == NULL) {
+			continue;
+		}
+
+		sched->queues[prio].head = job->next;
+		if (job->next == NULL) {
+			sched->queues[prio].tail = NULL;
+		}
+		sched->queues[prio].stats.pending--;
+
+		job->next = NULL;
+		job->queued = false;
+
+		return job;
+	}
+
+	return NULL;
+}
+
+void bq25180_sched_init(struct bq25180_sched *sched,
+		uint32_t (*get_time)(void *ctx), void *time_ctx)
+{
+	assert(sched != NULL);
+
+	memset(sched, 0, sizeof(*sched));
+
+	sched->get_time = get_time;
+	sched->time_ctx = time_ctx;
+}
+
+bool bq25180_sched_submit(struct bq25180_sched *sched,
+		struct bq25180_sched_job *job, enum bq25180_sched_prio prio)
+{
+	assert(job != NULL && job->op != NULL);
+	assert(prio < BQ25180_SCHED_NR_PRIO);
+
+	if (job->queued) {
+		return false;
+	}
+
+	struct bq25180_sched_stats *stats = &sched->queues[prio].stats;
+
+	job->queued = true;
+	job->prio = (uint8_t)prio;
+	job->queued_at = get_now(sched);
+	job->next = NULL;
+
+	if (sched->queues[prio].tail) {
+		sched->queues[prio].tail->next = job;
+	} else {
+		sched->queues[prio].head = job;
+	}
+	sched->queues[prio].tail = job;
+
+	if (++stats->pending > stats->max_pending) {
+		stats->max_pending = stats->pending;
+	}
+
+	return true;
+}
+
+bool bq25180_sched_run_next(struct bq25180_sched *sched)
+{
+	/* A job running another would break the atomicity of the outer */
+	assert(sched->running == NULL);
+
+	struct bq25180_sched_job *job = dequeue(sched);
+
+	if (job == NULL) {
+		return false;
+	}
+
+	struct bq25180_sched_stats *stats = &sched->queues[job->prio].stats;
+	const uint32_t started = get_now(sched);
+	const uint32_t wait = started - job->queued_at;
+
+	stats->total_wait += wait;
+	if (wait > stats->max_wait) {
+		stats->max_wait = wait;
+	}
+
+	sched->running = job;
+	job->ok = job->op(job->dev, job->ctx);
+	sched->running = NULL;
+
+	stats->busy += get_now(sched) - started;
+
+	if (job->ok) {
+		stats->completed++;
+	} else {
+		stats->failed++;
+	}
+
+	if (job->done) {
+		job->done(job);
+	}
+
+	return true;
+}
+
+size_t bq25180_sched_run(struct bq25180_sched *sched)
+{
+	size_t count = 0;
+
+	while (bq25180_sched_run_next(sched)) {
+		count++;
+	}
+
+	return count;
+}
+
+size_t bq25180_sched_pending(const struct bq25180_sched *sched)
+{
+	size_t count = 0;
+
+	for (int prio = 0; prio < BQ25180_SCHED_NR_PRIO; prio++) {
+		count += sched->queues[prio].stats.pending;
+	}
+
+	return count;
+}
+
+void bq25180_sched_get_stats(const struct bq25180_sched *sched,
+		enum bq25180_sched_prio prio,
+		struct bq25180_sched_stats *stats)
+{
+	assert(stats != NULL && prio < BQ25180_SCHED_NR_PRIO);
+	*stats = sched->queues[prio].stats;
+}
+
+uint32_t bq25180_sched_get_unscheduled(const struct bq25180_sched *sched)
+{
+	return sched->unscheduled;
+}
+
+void bq25180_sched_clear_stats(struct bq25180_sched *sched)
+{
+	for (int prio = 0; prio < BQ25180_SCHED_NR_PRIO; prio++) {
+		struct bq25180_sched_stats *stats = &sched->queues[prio].stats;
+		const uint16_t pending = stats->pending;
+
+		memset(stats, 0, sizeof(*stats));
+		stats->pending = pending;
+		stats->max_pending = pending;
+	}
+
+	sched->unscheduled = 0;
+}
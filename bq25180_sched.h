@@ -0,0 +1,211 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_SCHED_H
+#define LIBMCU_BQ25180_SCHED_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+/** Highest first */
+enum bq25180_sched_prio {
+	BQ25180_SCHED_PRIO_STATUS, /**< status reads and interrupt service */
+	BQ25180_SCHED_PRIO_CONFIG, /**< configuration changes */
+	BQ25180_SCHED_PRIO_BACKGROUND, /**< register scrubbing and the like */
+	BQ25180_SCHED_NR_PRIO,
+};
+
+struct bq25180_sched_job;
+
+/**
+ * @brief An operation to be run by the scheduler
+ *
+ * Everything it does on the bus is one unit: no other job runs before it
+ * returns. A read-modify-write is never split.
+ *
+ * @param[in] dev device handle given in @ref bq25180_sched_job. May be NULL
+ *            for other devices on the bus, reached through @p ctx
+ * @param[in] ctx user context given in @ref bq25180_sched_job
+ *
+ * @return true on success or false
+ */
+typedef bool (*bq25180_sched_op_t)(struct bq25180 *dev, void *ctx);
+
+/**
+ * @brief Completion callback
+ *
+ * @param[in] job @ref bq25180_sched_job just run, with @ref ok filled in. It
+ *            can be submitted again from here
+ */
+typedef void (*bq25180_sched_callback_t)(struct bq25180_sched_job *job);
+
+struct bq25180_sched_job {
+	struct bq25180 *dev;
+	bq25180_sched_op_t op;
+	void *ctx;
+	bq25180_sched_callback_t done; /**< Can be NULL */
+	bool ok; /**< the result, filled in once run */
+
+	/* private */
+	bool queued;
+	uint8_t prio;
+	uint32_t queued_at;
+	struct bq25180_sched_job *next;
+};
+
+struct bq25180_sched_stats {
+	uint32_t completed; /**< jobs succeeded */
+	uint32_t failed; /**< jobs failed */
+	uint32_t transfers; /**< bus transactions made by the jobs */
+	uint32_t total_wait; /**< time from submission to start, summed */
+	uint32_t max_wait; /**< the longest time from submission to start */
+	uint32_t busy; /**< time the jobs held the bus */
+	uint16_t pending; /**< jobs queued now */
+	uint16_t max_pending; /**< the most jobs queued at once */
+};
+
+/**
+ * @brief Transaction scheduler of a shared bus
+ *
+ * Members are private to the driver. Initialize it with
+ * @ref bq25180_sched_init.
+ */
+struct bq25180_sched {
+	struct {
+		struct bq25180_sched_job *head;
+		struct bq25180_sched_job *tail;
+		struct bq25180_sched_stats stats;
+	} queues[BQ25180_SCHED_NR_PRIO];
+
+	uint32_t (*get_time)(void *ctx);
+	void *time_ctx;
+
+	struct bq25180_sched_job *running;
+	uint32_t unscheduled; /* transfers made outside of any job */
+};
+
+/**
+ * @brief A device on the scheduled bus
+ *
+ * Give it to @ref bq25180_dev_init as the bus context along with
+ * @ref bq25180_sched_bus. It must outlive the device handle.
+ */
+struct bq25180_sched_port {
+	struct bq25180_sched *sched;
+	const struct bq25180_bus *bus; /**< the bus to reach the device */
+	void *bus_ctx; /**< context to be passed to @ref bus */
+};
+
+/**
+ * @brief The bus of the devices under a scheduler
+ *
+ * The context is @ref bq25180_sched_port. Transfers are passed down as they
+ * are and accounted to the priority of the job running.
+ */
+extern const struct bq25180_bus bq25180_sched_bus;
+
+/**
+ * @brief Initialize a scheduler
+ *
+ * No bus access is made. Jobs are only run by @ref bq25180_sched_run_next and
+ * @ref bq25180_sched_run, highest priority first and in the order submitted
+ * within a priority. A job submitted while another is running waits for it
+ * to finish, but goes ahead of every job of a lower priority.
+ *
+ * @param[in] sched @ref bq25180_sched
+ * @param[in] get_time monotonic time in any unit, for the latency
+ *            statistics. Can be NULL
+ * @param[in] time_ctx context to be passed to @p get_time
+ *
+ * @note Submitting and running must not preempt each other. Either call both
+ *       in the same context or submit with the runner locked out.
+ */
+void bq25180_sched_init(struct bq25180_sched *sched,
+		uint32_t (*get_time)(void *ctx), void *time_ctx);
+
+/**
+ * @brief Queue a job
+ *
+ * @param[in] sched @ref bq25180_sched
+ * @param[in] job @ref bq25180_sched_job to be kept valid until run
+ * @param[in] prio @ref bq25180_sched_prio
+ *
+ * @return true if queued or false when @p job is queued already
+ */
+bool bq25180_sched_submit(struct bq25180_sched *sched,
+		struct bq25180_sched_job *job, enum bq25180_sched_prio prio);
+
+/**
+ * @brief Run the job of the highest priority queued
+ *
+ * @param[in] sched @ref bq25180_sched
+ *
+ * @return true if a job was run or false when nothing is queued
+ */
+bool bq25180_sched_run_next(struct bq25180_sched *sched);
+
+/**
+ * @brief Run jobs until nothing is queued
+ *
+ * Jobs submitted in the meantime, from a job or its callback, are run too.
+ *
+ * @param[in] sched @ref bq25180_sched
+ *
+ * @return the number of jobs run
+ */
+size_t bq25180_sched_run(struct bq25180_sched *sched);
+
+/**
+ * @brief Get the number of jobs queued
+ *
+ * @param[in] sched @ref bq25180_sched
+ *
+ * @return the number of jobs queued in every priority
+ */
+size_t bq25180_sched_pending(const struct bq25180_sched *sched);
+
+/**
+ * @brief Get the statistics of a priority
+ *
+ * The mean queueing latency is @ref total_wait divided by the sum of
+ * @ref completed and @ref failed.
+ *
+ * @param[in] sched @ref bq25180_sched
+ * @param[in] prio @ref bq25180_sched_prio
+ * @param[out] stats @ref bq25180_sched_stats
+ */
+void bq25180_sched_get_stats(const struct bq25180_sched *sched,
+		enum bq25180_sched_prio prio,
+		struct bq25180_sched_stats *stats);
+
+/**
+ * @brief Get the number of transfers made outside of any job
+ *
+ * Those bypassed the scheduler, like a device handle on
+ * @ref bq25180_sched_bus used directly. Anything but 0 means the ordering
+ * and atomicity promised are not kept.
+ *
+ * @param[in] sched @ref bq25180_sched
+ *
+ * @return the number of transfers
+ */
+uint32_t bq25180_sched_get_unscheduled(const struct bq25180_sched *sched);
+
+/**
+ * @brief Clear the statistics but the jobs queued
+ *
+ * @param[in] sched @ref bq25180_sched
+ */
+void bq25180_sched_clear_stats(struct bq25180_sched *sched);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_SCHED_H */
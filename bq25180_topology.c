@@ -0,0 +1,187 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_topology.h"
+#include <string.h>
+
+#if !defined(assert)
+#define assert(exp)
+#endif
+
+static bool is_selected(const struct bq25180_topology *topo,
+		const struct bq25180_topology_node *node)
+{
+	return topo->known && topo->mux_addr == node->mux_addr &&
+		topo->channel == node->channel;
+}
+
+static bool write_mux(struct bq25180_topology *topo,
+		uint8_t mux_addr, uint8_t mask)
+{
+	topo->stats.selects++;
+
+	/* The control register is the only one, addressed by no pointer */
+	if (topo->bus->write(topo->bus_ctx, mux_addr, mask, NULL, 0) < 0) {
+		topo->stats.failures++;
+		topo->known = false;
+		return false;
+	}
+
+	return true;
+}
+
+static bool select_node(const struct bq25180_topology_node *node)
+{
+	struct bq25180_topology *topo = node->topo;
+
+	assert(node->channel < BQ25180_MUX_NR_CHANNELS);
+
+	if (is_selected(topo, node)) {
+		return true;
+	}
+
+	/* Two chargers at the same address must not be reachable at once. A
+	 * mux refusing the deselect may still pass its channel, so it is kept
+	 * to be deselected again until it answers or is forgotten. */
+	if (topo->mux_addr && topo->mux_addr != node->mux_addr) {
+		if (!write_mux(topo, topo->mux_addr, 0)) {
+			return false;
+		}
+		topo->mux_addr = 0;
+	}
+
+	/* A write refused leaves what is selected unknown until the next */
+	if (!write_mux(topo, node->mux_addr, (uint8_t)(1U << node->channel))) {
+		return false;
+	}
+
+	topo->known = true;
+	topo->mux_addr = node->mux_addr;
+	topo->channel = node->channel;
+
+	return true;
+}
+
+static int topo_read(void *ctx, uint8_t addr, uint8_t reg,
+		void *buf, size_t bufsize)
+{
+	const struct bq25180_topology_node *node =
+		(const struct bq25180_topology_node *)ctx;
+	struct bq25180_topology *topo = node->topo;
+
+	if (!select_node(node)) {
+		return -1;
+	}
+
+	topo->stats.transfers++;
+
+	return topo->bus->read(topo->bus_ctx, addr, reg, buf, bufsize);
+}
+
+static int topo_write(void *ctx, uint8_t addr, uint8_t reg,
+		const void *data, size_t data_len)
+{
+	const struct bq25180_topology_node *node =
+		(const struct bq25180_topology_node *)ctx;
+	struct bq25180_topology *topo = node->topo;
+
+	if (!select_node(node)) {
+		return -1;
+	}
+
+	topo->stats.transfers++;
+
+	return topo->bus->write(topo->bus_ctx, addr, reg, data, data_len);
+}
+
+const struct bq25180_bus bq25180_topology_bus = {
+	.read = topo_read,
+	.write = topo_write,
+};
+
+void bq25180_topology_init(struct bq25180_topology *topo,
+		const struct bq25180_bus *bus, void *bus_ctx)
+{
+	assert(topo != NULL && bus != NULL);
+
+	memset(topo, 0, sizeof(*topo));
+
+	topo->bus = bus;
+	topo->bus_ctx = bus_ctx;
+}
+
+void bq25180_topology_invalidate(struct bq25180_topology *topo)
+{
+	topo->known = false;
+}
+
+void bq25180_topology_forget_mux(struct bq25180_topology *topo)
+{
+	topo->mux_addr = 0;
+	topo->known = false;
+}
+
+static size_t run_channel(struct bq25180_topology_job *jobs, size_t nr_jobs,
+		const struct bq25180_topology_node *node)
+{
+	size_t succeeded = 0;
+
+	for (size_t i = 0; i < nr_jobs; i++) {
+		struct bq25180_topology_job *job = &jobs[i];
+
+		if (job->done || job->node->mux_addr != node->mux_addr ||
+				job->node->channel != node->channel) {
+			continue;
+		}
+
+		job->ok = job->op(job->dev, job->ctx);
+		job->done = true;
+
+		if (job->ok) {
+			succeeded++;
+		}
+	}
+
+	return succeeded;
+}
+
+size_t bq25180_topology_run(struct bq25180_topology *topo,
+		struct bq25180_topology_job *jobs, size_t nr_jobs)
+{
+	size_t succeeded = 0;
+
+	assert(jobs != NULL || nr_jobs == 0);
+
+	for (size_t i = 0; i < nr_jobs; i++) {
+		assert(jobs[i].node->topo == topo);
+		jobs[i].done = false;
+		jobs[i].ok = false;
+	}
+
+	if (topo->known && topo->mux_addr) {
+		const struct bq25180_topology_node cur = {
+			.topo = topo,
+			.mux_addr = topo->mux_addr,
+			.channel = topo->channel,
+		};
+		succeeded += run_channel(jobs, nr_jobs, &cur);
+	}
+
+	for (size_t i = 0; i < nr_jobs; i++) {
+		if (!jobs[i].done) {
+			succeeded += run_channel(jobs, nr_jobs, jobs[i].node);
+		}
+	}
+
+	return succeeded;
+}
+
+void bq25180_topology_get_stats(const struct bq25180_topology *topo,
+		struct bq25180_topology_stats *stats)
+{
+	assert(stats != NULL);
+	*stats = topo->stats;
+}
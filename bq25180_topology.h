@@ -0,0 +1,152 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_TOPOLOGY_H
+#define LIBMCU_BQ25180_TOPOLOGY_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+#define BQ25180_MUX_NR_CHANNELS		8
+
+struct bq25180_topology_stats {
+	uint32_t transfers; /**< charger transactions passed down */
+	uint32_t selects; /**< writes to a mux control register */
+	uint32_t failures; /**< mux writes failed */
+};
+
+/**
+ * @brief Chargers behind TCA9548-style I2C multiplexers on a single bus
+ *
+ * Every charger answers at @ref BQ25180_DEVICE_ADDRESS, so only one of them
+ * may be reachable at a time. The channel last selected is remembered, and a
+ * mux gets written only when a charger on another channel is addressed. When
+ * moving to another mux, the previous one is deselected first.
+ *
+ * Members are private to the driver. Initialize it with
+ * @ref bq25180_topology_init.
+ */
+struct bq25180_topology {
+	const struct bq25180_bus *bus;
+	void *bus_ctx;
+
+	/* The only mux that may have a channel selected, or 0 if none */
+	uint8_t mux_addr;
+	uint8_t channel;
+	bool known; /* channel is what mux_addr has selected */
+
+	struct bq25180_topology_stats stats;
+};
+
+/**
+ * @brief Where a charger sits
+ *
+ * Give it to @ref bq25180_dev_init as the bus context along with
+ * @ref bq25180_topology_bus. It must outlive the device handle.
+ */
+struct bq25180_topology_node {
+	struct bq25180_topology *topo;
+	uint8_t mux_addr; /**< 7-bit address of the mux */
+	uint8_t channel; /**< 0 to 7 */
+};
+
+/**
+ * @brief An operation on a charger, to be run by @ref bq25180_topology_run
+ *
+ * @param[in] dev device handle of the charger
+ * @param[in] ctx user context given in @ref bq25180_topology_job
+ *
+ * @return true on success or false
+ */
+typedef bool (*bq25180_topology_op_t)(struct bq25180 *dev, void *ctx);
+
+struct bq25180_topology_job {
+	struct bq25180 *dev;
+	const struct bq25180_topology_node *node; /**< where @ref dev sits */
+	bq25180_topology_op_t op;
+	void *ctx;
+	bool ok; /**< the result, filled in by @ref bq25180_topology_run */
+	bool done; /* private */
+};
+
+/**
+ * @brief The bus of the chargers behind the muxes
+ *
+ * The context is @ref bq25180_topology_node.
+ */
+extern const struct bq25180_bus bq25180_topology_bus;
+
+/**
+ * @brief Initialize a topology
+ *
+ * No bus access is made. No mux is taken to have any channel selected, as
+ * after their power-on.
+ *
+ * The control register of a mux is written through @p bus as a write with
+ * the channel mask given as the register address and no data.
+ *
+ * @param[in] topo @ref bq25180_topology
+ * @param[in] bus @ref bq25180_bus the muxes sit on
+ * @param[in] bus_ctx context to be passed to @p bus
+ */
+void bq25180_topology_init(struct bq25180_topology *topo,
+		const struct bq25180_bus *bus, void *bus_ctx);
+
+/**
+ * @brief Forget the mux selection
+ *
+ * For when anything else may have written the mux last selected. The next
+ * transfer selects its channel again.
+ *
+ * @param[in] topo @ref bq25180_topology
+ */
+void bq25180_topology_invalidate(struct bq25180_topology *topo);
+
+/**
+ * @brief Give up on deselecting the mux last selected
+ *
+ * A mux refusing to be deselected is retried before any other mux gets
+ * selected, so every charger behind the others stays unreachable until it
+ * answers. Call this once it is known to pass nothing, like after it was
+ * powered off or reset. No bus access is made.
+ *
+ * @param[in] topo @ref bq25180_topology
+ */
+void bq25180_topology_forget_mux(struct bq25180_topology *topo);
+
+/**
+ * @brief Run a batch of operations with as few channel switches as possible
+ *
+ * The jobs on the channel selected are run first. Then the rest, grouped by
+ * channel in the order the channels first appear in @p jobs. The jobs of a
+ * channel keep their order. A failing job does not stop the others.
+ *
+ * @param[in] topo @ref bq25180_topology every node belongs to
+ * @param[in,out] jobs @ref bq25180_topology_job
+ * @param[in] nr_jobs number of @p jobs
+ *
+ * @return the number of jobs succeeded
+ */
+size_t bq25180_topology_run(struct bq25180_topology *topo,
+		struct bq25180_topology_job *jobs, size_t nr_jobs);
+
+/**
+ * @brief Get the statistics
+ *
+ * @param[in] topo @ref bq25180_topology
+ * @param[out] stats @ref bq25180_topology_stats
+ */
+void bq25180_topology_get_stats(const struct bq25180_topology *topo,
+		struct bq25180_topology_stats *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_TOPOLOGY_H */
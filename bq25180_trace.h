@@ -0,0 +1,143 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_TRACE_H
+#define LIBMCU_BQ25180_TRACE_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * Instrumentation compiled in only with BQ25180_TRACE defined. Without it
+ * nothing below exists and the driver carries no code or data for it.
+ */
+#if defined(BQ25180_TRACE)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct bq25180;
+
+enum bq25180_op {
+	BQ25180_OP_RESET,
+	BQ25180_OP_ENABLE_CACHE,
+	BQ25180_OP_READ_EVENT,
+	BQ25180_OP_READ_STATE,
+	BQ25180_OP_READ_SNAPSHOT,
+	BQ25180_OP_ENABLE_BATTERY_CHARGING,
+	BQ25180_OP_SET_SAFETY_TIMER,
+	BQ25180_OP_SET_WATCHDOG_TIMER,
+	BQ25180_OP_SET_BATTERY_REGULATION_VOLTAGE,
+	BQ25180_OP_SET_BATTERY_DISCHARGE_CURRENT,
+	BQ25180_OP_SET_BATTERY_UNDER_VOLTAGE,
+	BQ25180_OP_SET_PRECHARGE_THRESHOLD,
+	BQ25180_OP_SET_PRECHARGE_CURRENT,
+	BQ25180_OP_SET_FASTCHARGE_CURRENT,
+	BQ25180_OP_SET_TERMINATION_CURRENT,
+	BQ25180_OP_ENABLE_VINDPM,
+	BQ25180_OP_ENABLE_DPPM,
+	BQ25180_OP_SET_INPUT_CURRENT,
+	BQ25180_OP_SET_SYS_SOURCE,
+	BQ25180_OP_SET_SYS_VOLTAGE,
+	BQ25180_OP_ENABLE_THERMAL_PROTECTION,
+	BQ25180_OP_ENABLE_PUSH_BUTTON,
+	BQ25180_OP_ENABLE_INTERRUPT,
+	BQ25180_OP_DISABLE_INTERRUPT,
+	BQ25180_OP_APPLY_CONFIG,
+	BQ25180_OP_PROCESS_INTERRUPT,
+	BQ25180_OP_DUMP,
+	BQ25180_OP_RESTORE_CONFIG,
+	BQ25180_OP_SET_TS_CONTROL,
+	BQ25180_OP_GET_TS_CONTROL,
+	BQ25180_OP_GET_BATTERY_REGULATION_VOLTAGE,
+	BQ25180_OP_GET_FASTCHARGE_CURRENT,
+	BQ25180_OP_GET_INPUT_CURRENT,
+	BQ25180_OP_GET_SYS_SOURCE,
+	BQ25180_OP_GET_CONFIG,
+	BQ25180_OP_SET_WAKE_CONFIG,
+	BQ25180_OP_GET_WAKE_CONFIG,
+	BQ25180_OP_ENTER_POWER_MODE,
+	BQ25180_OP_PROBE,
+	BQ25180_OP_MAX,
+};
+
+/**
+ * @brief Trace hooks
+ *
+ * Every member can be NULL. @p timestamp is what @ref get_time returns, or 0
+ * without it.
+ */
+struct bq25180_trace_hooks {
+	/** Called on entering a public operation */
+	void (*op_begin)(void *ctx, enum bq25180_op op, uint32_t timestamp);
+	/** Called on leaving a public operation with its result */
+	void (*op_end)(void *ctx, enum bq25180_op op, bool ok,
+			uint32_t timestamp);
+	/** Called before every bus transaction, retries included */
+	void (*bus_begin)(void *ctx, bool write, uint8_t reg, size_t len,
+			uint32_t timestamp);
+	/** Called after every bus transaction with what the bus returned */
+	void (*bus_end)(void *ctx, bool write, uint8_t reg, size_t len,
+			int result, uint32_t timestamp);
+	/** Monotonic time in any unit, for the timestamps and the counters */
+	uint32_t (*get_time)(void *ctx);
+	void *ctx; /**< context to be passed to the hooks */
+};
+
+struct bq25180_trace_counters {
+	struct {
+		uint32_t calls;
+		uint32_t failures;
+		uint32_t time; /**< cumulative in the unit of get_time */
+	} ops[BQ25180_OP_MAX];
+
+	struct {
+		uint32_t reads;
+		uint32_t writes;
+		uint32_t read_bytes;
+		uint32_t written_bytes;
+		uint32_t errors;
+		uint32_t time; /**< cumulative in the unit of get_time */
+	} bus;
+};
+
+/**
+ * @brief Set the trace hooks
+ *
+ * The counters are kept regardless of the hooks.
+ *
+ * @param[in] dev device handle
+ * @param[in] hooks @ref bq25180_trace_hooks to be kept valid while in use or
+ *            NULL
+ */
+void bq25180_dev_set_trace_hooks(struct bq25180 *dev,
+		const struct bq25180_trace_hooks *hooks);
+
+/**
+ * @brief Get the cumulative counters
+ *
+ * @param[in] dev device handle
+ * @param[out] counters @ref bq25180_trace_counters
+ */
+void bq25180_dev_get_trace_counters(const struct bq25180 *dev,
+		struct bq25180_trace_counters *counters);
+
+/**
+ * @brief Clear the cumulative counters
+ *
+ * @param[in] dev device handle
+ */
+void bq25180_dev_clear_trace_counters(struct bq25180 *dev);
+
+#endif /* BQ25180_TRACE */
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_TRACE_H */
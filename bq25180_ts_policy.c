@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_ts_policy.h"
+#include "bq25180_fields.h"
+#include <string.h>
+
+#if !defined(assert)
+#define assert(exp)
+#endif
+
+static uint16_t min_u16(uint32_t a, uint16_t b)
+{
+	return (uint16_t)(a < b? a : b);
+}
+
+static void get_programmed(const struct bq25180_ts_policy_config *cfg,
+		uint8_t zone, uint16_t *ichg, uint16_t *vbatreg)
+{
+	const struct bq25180_ts_target *normal = &cfg->normal;
+
+	*ichg = normal->fastcharge_milliampere;
+	*vbatreg = normal->battery_regulation_millivoltage;
+
+	if (zone == BQ25180_TS_ZONE_COOL) {
+		const uint32_t scale = !cfg->ts.cool_enabled? 1 :
+			cfg->ts.cool_current == BQ25180_TS_ICHG_20PCT? 5 : 2;
+		*ichg = min_u16(cfg->cool.fastcharge_milliampere * scale,
+				*ichg);
+		*vbatreg = min_u16(cfg->cool.battery_regulation_millivoltage,
+				*vbatreg);
+	} else if (zone == BQ25180_TS_ZONE_WARM) {
+		const uint32_t offset = !cfg->ts.warm_enabled? 0 :
+			cfg->ts.warm_voltage ==
+			BQ25180_TS_VBATREG_MINUS_200mV? 200 : 100;
+		*ichg = min_u16(cfg->warm.fastcharge_milliampere, *ichg);
+		*vbatreg = min_u16(cfg->warm.battery_regulation_millivoltage +
+				offset, *vbatreg);
+	}
+}
+
+bool bq25180_ts_policy_init(struct bq25180_ts_policy *policy,
+		struct bq25180 *dev,
+		const struct bq25180_ts_policy_config *cfg)
+{
+	assert(policy != NULL && dev != NULL && cfg != NULL);
+	assert(cfg->normal.fastcharge_milliampere >= BQ25180_ICHG_MIN_mA &&
+			cfg->normal.fastcharge_milliampere <= BQ25180_ICHG_MAX_mA);
+
+	memset(policy, 0, sizeof(*policy));
+
+	policy->dev = dev;
+	policy->cfg = *cfg;
+
+	return bq25180_dev_set_ts_control(dev, &cfg->ts);
+}
+
+bool bq25180_ts_policy_update(struct bq25180_ts_policy *policy,
+		const struct bq25180_state *state)
+{
+	const uint8_t zone = (uint8_t)state->ts_status;
+	uint16_t ichg;
+	uint16_t vbatreg;
+
+	if (zone == BQ25180_TS_ZONE_HOT_OR_COLD ||
+			(policy->applied && zone == policy->zone)) {
+		return true;
+	}
+
+	get_programmed(&policy->cfg, zone, &ichg, &vbatreg);
+
+	if (!policy->applied || ichg != policy->ichg) {
+		if (!bq25180_dev_set_fastcharge_current(policy->dev, ichg)) {
+			return false;
+		}
+		policy->ichg = ichg;
+	}
+	if (!policy->applied || vbatreg != policy->vbatreg) {
+		if (!bq25180_dev_set_battery_regulation_voltage(policy->dev,
+				vbatreg)) {
+			return false;
+		}
+		policy->vbatreg = vbatreg;
+	}
+
+	if (policy->applied) {
+		policy->zone_changes++;
+	}
+
+	policy->applied = true;
+	policy->zone = zone;
+
+	return true;
+}
+
+uint32_t bq25180_ts_policy_zone_changes(const struct bq25180_ts_policy *policy)
+{
+	return policy->zone_changes;
+}
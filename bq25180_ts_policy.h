@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_TS_POLICY_H
+#define LIBMCU_BQ25180_TS_POLICY_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+/** What to charge with in a temperature zone */
+struct bq25180_ts_target {
+	uint16_t fastcharge_milliampere; /**< 5mA to 1000mA */
+	uint16_t battery_regulation_millivoltage; /**< 3500mV to 4650mV */
+};
+
+struct bq25180_ts_policy_config {
+	/** Thresholds written on init. Thermal protection has to be enabled
+	 * separately */
+	struct bq25180_ts_config ts;
+	struct bq25180_ts_target normal;
+	/** Effective in the cool zone, the device reduction accounted for */
+	struct bq25180_ts_target cool;
+	/** Effective in the warm zone, the device reduction accounted for */
+	struct bq25180_ts_target warm;
+};
+
+/**
+ * @brief Temperature zone policy
+ *
+ * Members are private to the driver. Initialize it with
+ * @ref bq25180_ts_policy_init.
+ */
+struct bq25180_ts_policy {
+	struct bq25180 *dev;
+	struct bq25180_ts_policy_config cfg;
+
+	bool applied; /* zone, ichg and vbatreg are valid */
+	uint8_t zone;
+	uint16_t ichg; /* programmed, not effective */
+	uint16_t vbatreg;
+	uint32_t zone_changes;
+};
+
+/**
+ * @brief Initialize a temperature zone policy
+ *
+ * On its own the device either charges at the full rate or cuts it to a
+ * fixed fraction in the cool and warm zones. The policy programs the fast
+ * charge current and the battery regulation voltage of each zone instead, so
+ * that the effective rate is the highest the zone allows.
+ *
+ * What gets programmed never goes above the normal zone target, so that the
+ * battery warming up or cooling down back to normal before the next update
+ * is never charged above it.
+ *
+ * @param[in] policy @ref bq25180_ts_policy
+ * @param[in] dev device handle
+ * @param[in] cfg @ref bq25180_ts_policy_config
+ *
+ * @return true on success or false if TS_CONTROL could not be written
+ */
+bool bq25180_ts_policy_init(struct bq25180_ts_policy *policy,
+		struct bq25180 *dev,
+		const struct bq25180_ts_policy_config *cfg);
+
+/**
+ * @brief Follow the zone of the state just read
+ *
+ * Nothing is written unless the zone changed since the last update. In the
+ * hot or cold zone the device suspends charging by itself and nothing is
+ * written either.
+ *
+ * @param[in] policy @ref bq25180_ts_policy
+ * @param[in] state @ref bq25180_state read from the device
+ *
+ * @return true on success or false. A failed update is retried on the next
+ *         call
+ */
+bool bq25180_ts_policy_update(struct bq25180_ts_policy *policy,
+		const struct bq25180_state *state);
+
+/**
+ * @brief Get the number of zone changes applied
+ *
+ * @param[in] policy @ref bq25180_ts_policy
+ *
+ * @return the number of zone changes since initialized
+ */
+uint32_t bq25180_ts_policy_zone_changes(const struct bq25180_ts_policy *policy);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_TS_POLICY_H */
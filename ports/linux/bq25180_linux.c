@@ -0,0 +1,201 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define _POSIX_C_SOURCE		200809L
+
+#include "bq25180_linux.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+static int sys_open(const char *path, int flags)
+{
+	return open(path, flags);
+}
+
+static int sys_ioctl(int fd, unsigned long request, void *arg)
+{
+	return ioctl(fd, request, arg);
+}
+
+static const struct bq25180_linux_sys default_sys = {
+	.open = sys_open,
+	.close = close,
+	.ioctl = sys_ioctl,
+};
+
+static int transfer(struct bq25180_linux *port,
+		struct i2c_msg *msgs, uint8_t nr_msgs)
+{
+	struct i2c_rdwr_ioctl_data data = {
+		.msgs = msgs,
+		.nmsgs = nr_msgs,
+	};
+
+	if (port->sys->ioctl(port->fd, I2C_RDWR, &data) < 0) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+static void clear_batch(struct bq25180_linux *port)
+{
+	port->batch.nr_msgs = 0;
+	port->batch.len = 0;
+}
+
+/* Kept on failure, the writes having been reported done already. They go
+ * again with the next transfer, like the retry of the one that failed. */
+static int flush_batch(struct bq25180_linux *port)
+{
+	int err = 0;
+
+	if (port->batch.nr_msgs) {
+		err = transfer(port, port->batch.msgs, port->batch.nr_msgs);
+	}
+
+	if (err == 0) {
+		clear_batch(port);
+	}
+
+	return err;
+}
+
+static int read_regs(void *ctx, uint8_t addr, uint8_t reg,
+		void *buf, size_t bufsize)
+{
+	struct bq25180_linux *port = (struct bq25180_linux *)ctx;
+	struct i2c_msg msgs[BQ25180_LINUX_BATCH_LEN + 2];
+	uint8_t nr_msgs = port->batch.nr_msgs;
+
+	/* The writes queued go ahead of the read in the same ioctl */
+	memcpy(msgs, port->batch.msgs, sizeof(msgs[0]) * nr_msgs);
+
+	msgs[nr_msgs++] = (struct i2c_msg) {
+		.addr = addr,
+		.len = 1,
+		.buf = &reg,
+	};
+	msgs[nr_msgs++] = (struct i2c_msg) {
+		.addr = addr,
+		.flags = I2C_M_RD,
+		.len = (uint16_t)bufsize,
+		.buf = (uint8_t *)buf,
+	};
+
+	const int err = transfer(port, msgs, nr_msgs);
+
+	if (err < 0) {
+		return err;
+	}
+
+	clear_batch(port);
+
+	return (int)bufsize;
+}
+
+static int write_regs(void *ctx, uint8_t addr, uint8_t reg,
+		const void *data, size_t data_len)
+{
+	struct bq25180_linux *port = (struct bq25180_linux *)ctx;
+	uint8_t tmp[1 + BQ25180_NR_REGISTERS];
+	uint8_t *p = tmp;
+	int err;
+
+	if (data_len > BQ25180_NR_REGISTERS) {
+		return -EINVAL;
+	}
+
+	if (port->batch.active) {
+		if (port->batch.nr_msgs >= BQ25180_LINUX_BATCH_LEN &&
+				(err = flush_batch(port)) < 0) {
+			return err;
+		}
+
+		p = &port->batch.buf[port->batch.len];
+		port->batch.len = (uint16_t)(port->batch.len + 1 + data_len);
+	} else if ((err = flush_batch(port)) < 0) {
+		/* Left over from a failed batch, to keep the order of writes */
+		return err;
+	}
+
+	p[0] = reg;
+	/* A mux select comes with no data, and NULL even for no bytes is
+	 * undefined to memcpy() */
+	if (data_len) {
+		memcpy(&p[1], data, data_len);
+	}
+
+	struct i2c_msg msg = {
+		.addr = addr,
+		.len = (uint16_t)(1 + data_len),
+		.buf = p,
+	};
+
+	if (port->batch.active) {
+		port->batch.msgs[port->batch.nr_msgs++] = msg;
+		return (int)data_len;
+	}
+
+	err = transfer(port, &msg, 1);
+
+	return err < 0? err : (int)data_len;
+}
+
+const struct bq25180_bus bq25180_linux_bus = {
+	.read = read_regs,
+	.write = write_regs,
+};
+
+int bq25180_linux_open(struct bq25180_linux *port, const char *path,
+		const struct bq25180_linux_sys *sys)
+{
+	unsigned long funcs;
+
+	memset(port, 0, sizeof(*port));
+	port->sys = sys? sys : &default_sys;
+
+	if ((port->fd = port->sys->open(path, O_RDWR)) < 0) {
+		return -errno;
+	}
+
+	/* SMBus only adapters like i2c-stub can't do the combined transfer */
+	if (port->sys->ioctl(port->fd, I2C_FUNCS, &funcs) < 0 ||
+			!(funcs & I2C_FUNC_I2C)) {
+		port->sys->close(port->fd);
+		port->fd = -1;
+		return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
+void bq25180_linux_close(struct bq25180_linux *port)
+{
+	if (port->fd >= 0) {
+		port->sys->close(port->fd);
+		port->fd = -1;
+	}
+
+	clear_batch(port);
+	port->batch.active = false;
+}
+
+void bq25180_linux_begin_batch(struct bq25180_linux *port)
+{
+	port->batch.active = true;
+}
+
+int bq25180_linux_end_batch(struct bq25180_linux *port)
+{
+	port->batch.active = false;
+	return flush_batch(port);
+}
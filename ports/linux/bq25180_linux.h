@@ -0,0 +1,115 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_LINUX_H
+#define LIBMCU_BQ25180_LINUX_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <linux/i2c.h>
+#include "bq25180.h"
+
+#if !defined(BQ25180_LINUX_BATCH_LEN)
+#define BQ25180_LINUX_BATCH_LEN		8
+#endif
+
+/**
+ * @brief System calls the backend goes through
+ *
+ * Meant to be replaced with a fake file descriptor layer in tests.
+ */
+struct bq25180_linux_sys {
+	int (*open)(const char *path, int flags);
+	int (*close)(int fd);
+	int (*ioctl)(int fd, unsigned long request, void *arg);
+};
+
+/**
+ * @brief Linux i2c-dev backend
+ *
+ * Members are private to the backend. Open it with @ref bq25180_linux_open
+ * and pass it as the bus context of @ref bq25180_dev_init along with
+ * @ref bq25180_linux_bus.
+ */
+struct bq25180_linux {
+	int fd;
+	const struct bq25180_linux_sys *sys;
+
+	struct {
+		bool active;
+		uint8_t nr_msgs;
+		uint16_t len;
+		struct i2c_msg msgs[BQ25180_LINUX_BATCH_LEN];
+		uint8_t buf[BQ25180_LINUX_BATCH_LEN
+			* (1 + BQ25180_NR_REGISTERS)];
+	} batch;
+};
+
+/**
+ * @brief Bus operations on an i2c-dev adapter
+ *
+ * A register read goes in a single I2C_RDWR ioctl of a write message of the
+ * register address followed by a repeated start read message, and a burst
+ * write in a single message. No per-byte system call is made.
+ */
+extern const struct bq25180_bus bq25180_linux_bus;
+
+/**
+ * @brief Open an i2c-dev adapter
+ *
+ * @param[in] port @ref bq25180_linux
+ * @param[in] path device node such as "/dev/i2c-1"
+ * @param[in] sys @ref bq25180_linux_sys or NULL for the real system calls
+ *
+ * @return 0 on success. Otherwise a negative errno
+ */
+int bq25180_linux_open(struct bq25180_linux *port, const char *path,
+		const struct bq25180_linux_sys *sys);
+
+/**
+ * @brief Close the adapter
+ *
+ * Writes still batched are discarded.
+ *
+ * @param[in] port @ref bq25180_linux
+ */
+void bq25180_linux_close(struct bq25180_linux *port);
+
+/**
+ * @brief Start batching writes
+ *
+ * From then on writes are queued instead of being issued one by one. The
+ * queue goes out in a single I2C_RDWR ioctl together with the next read, when
+ * it gets full, or on @ref bq25180_linux_end_batch, whichever comes first.
+ *
+ * @param[in] port @ref bq25180_linux
+ *
+ * @note A queued write is reported successful to the driver. Its actual
+ *       result comes from the read that flushes it or from
+ *       @ref bq25180_linux_end_batch. On failure the queue is kept and goes
+ *       out again with the next transaction, so a read retried carries the
+ *       writes along with it.
+ */
+void bq25180_linux_begin_batch(struct bq25180_linux *port);
+
+/**
+ * @brief Flush the queued writes and stop batching
+ *
+ * On failure the writes are kept for the next transaction or the next call.
+ *
+ * @param[in] port @ref bq25180_linux
+ *
+ * @return 0 on success. Otherwise a negative errno
+ */
+int bq25180_linux_end_batch(struct bq25180_linux *port);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_LINUX_H */
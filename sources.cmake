@@ -1,4 +1,7 @@
 # SPDX-License-Identifier: MIT
 
-set(BQ25180_SRCS bq25180.c)
+set(BQ25180_SRCS bq25180.c bq25180_compat.c bq25180_async.c bq25180_dump.c
+	bq25180_poll.c bq25180_ring.c bq25180_ts_policy.c
+	bq25180_input_tuner.c bq25180_governor.c bq25180_topology.c
+	bq25180_sched.c)
 set(BQ25180_INCS ${CMAKE_CURRENT_LIST_DIR})
@@ -1,4 +1,14 @@
 # SPDX-License-Identifier: MIT
 
 BQ25180_SRCS += $(BQ25180_ROOT)/bq25180.c
+BQ25180_SRCS += $(BQ25180_ROOT)/bq25180_compat.c
+BQ25180_SRCS += $(BQ25180_ROOT)/bq25180_async.c
+BQ25180_SRCS += $(BQ25180_ROOT)/bq25180_dump.c
+BQ25180_SRCS += $(BQ25180_ROOT)/bq25180_poll.c
+BQ25180_SRCS += $(BQ25180_ROOT)/bq25180_ring.c
+BQ25180_SRCS += $(BQ25180_ROOT)/bq25180_ts_policy.c
+BQ25180_SRCS += $(BQ25180_ROOT)/bq25180_input_tuner.c
+BQ25180_SRCS += $(BQ25180_ROOT)/bq25180_governor.c
+BQ25180_SRCS += $(BQ25180_ROOT)/bq25180_topology.c
+BQ25180_SRCS += $(BQ25180_ROOT)/bq25180_sched.c
 BQ25180_INCS := $(BQ25180_ROOT)
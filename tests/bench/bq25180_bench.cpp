@@ -0,0 +1,443 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bq25180.hpp"
+#include "bq25180_sim.h"
+
+#if !defined(BQ25180_BENCH_BASELINE)
+#define BQ25180_BENCH_BASELINE		"bench/baseline.txt"
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+/* Bus time is modelled on the bit count of standard I2C framing. A write is
+ * START, address, register, data and STOP. A read adds a repeated START and
+ * the address once more. Every byte takes 9 clocks with the ACK. */
+#define WRITE_OVERHEAD_BITS		(1 + 9 + 9 + 1)
+#define READ_OVERHEAD_BITS		(WRITE_OVERHEAD_BITS + 1 + 9)
+
+struct cost {
+	uint32_t reads;
+	uint32_t writes;
+	uint32_t bytes;
+};
+
+struct bench {
+	const char *name;
+	void (*run)(struct bq25180 *dev, struct bq25180_sim *sim);
+};
+
+static uint32_t get_bits(const struct bq25180_sim_stats *stats) {
+	return stats->reads * READ_OVERHEAD_BITS +
+		stats->writes * WRITE_OVERHEAD_BITS +
+		(stats->read_bytes + stats->written_bytes) * 9;
+}
+
+static uint32_t get_us(uint32_t bits, uint32_t hz) {
+	return (uint32_t)((uint64_t)bits * 1000000U / hz);
+}
+
+static void run_reset(struct bq25180 *dev, struct bq25180_sim *sim) {
+	bq25180_dev_reset(dev, false);
+}
+static void run_enable_cache(struct bq25180 *dev, struct bq25180_sim *sim) {
+	bq25180_dev_enable_cache(dev, true);
+}
+static void run_read_event(struct bq25180 *dev, struct bq25180_sim *sim) {
+	struct bq25180_event event;
+	bq25180_dev_read_event(dev, &event);
+}
+static void run_read_state(struct bq25180 *dev, struct bq25180_sim *sim) {
+	struct bq25180_state state;
+	bq25180_dev_read_state(dev, &state);
+}
+static void run_read_snapshot(struct bq25180 *dev, struct bq25180_sim *sim) {
+	struct bq25180_state state;
+	struct bq25180_event event;
+	bq25180_dev_read_snapshot(dev, &state, &event);
+}
+static void run_dump(struct bq25180 *dev, struct bq25180_sim *sim) {
+	struct bq25180_dump dump;
+	bq25180_dev_dump(dev, &dump);
+}
+
+static void run_enable_battery_charging(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_enable_battery_charging(dev, false);
+}
+static void run_set_safety_timer(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_set_safety_timer(dev, BQ25180_SAFETY_3H);
+}
+static void run_set_watchdog_timer(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_set_watchdog_timer(dev, BQ25180_WDT_40_SEC);
+}
+static void run_set_battery_regulation_voltage(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_set_battery_regulation_voltage(dev, 4350);
+}
+static void run_set_battery_discharge_current(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_set_battery_discharge_current(dev,
+			BQ25180_BAT_DISCHAGE_500mA);
+}
+static void run_set_battery_under_voltage(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_set_battery_under_voltage(dev, 2600);
+}
+static void run_set_precharge_threshold(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_set_precharge_threshold(dev, 2800);
+}
+static void run_set_precharge_current(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_set_precharge_current(dev, false);
+}
+static void run_set_fastcharge_current(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_set_fastcharge_current(dev, 300);
+}
+static void run_set_termination_current(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_set_termination_current(dev, 5);
+}
+static void run_enable_vindpm(struct bq25180 *dev, struct bq25180_sim *sim) {
+	bq25180_dev_enable_vindpm(dev, BQ25180_VINDPM_4500mV);
+}
+static void run_enable_dppm(struct bq25180 *dev, struct bq25180_sim *sim) {
+	bq25180_dev_enable_dppm(dev, false);
+}
+static void run_set_input_current(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_set_input_current(dev, 500);
+}
+static void run_set_sys_source(struct bq25180 *dev, struct bq25180_sim *sim) {
+	bq25180_dev_set_sys_source(dev, BQ25180_SYS_SRC_VBAT);
+}
+static void run_set_sys_voltage(struct bq25180 *dev, struct bq25180_sim *sim) {
+	bq25180_dev_set_sys_voltage(dev, BQ25180_SYS_REG_V4_8);
+}
+static void run_enable_thermal_protection(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_enable_thermal_protection(dev, false);
+}
+static void run_enable_push_button(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_enable_push_button(dev, false);
+}
+static void run_set_ts_control(struct bq25180 *dev, struct bq25180_sim *sim) {
+	const struct bq25180_ts_config ts = {
+		.hot = BQ25180_TS_HOT_50C,
+		.cold = BQ25180_TS_COLD_3C,
+		.warm_enabled = true,
+		.cool_enabled = true,
+		.cool_current = BQ25180_TS_ICHG_20PCT,
+		.warm_voltage = BQ25180_TS_VBATREG_MINUS_200mV,
+	};
+	bq25180_dev_set_ts_control(dev, &ts);
+}
+static void run_enter_power_mode(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	/* Left pending until VIN is removed */
+	bq25180_sim_set_source(sim, 5000, 0);
+	bq25180_dev_enter_power_mode(dev, BQ25180_POWER_SHIP, true);
+}
+static void run_set_wake_config(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	const struct bq25180_wake_config wake = {
+		.push_button_enabled = true,
+		.wake1 = BQ25180_WAKE1_1000ms,
+		.wake2 = BQ25180_WAKE2_3600ms,
+		.long_press = BQ25180_PB_SHIPMODE,
+	};
+	bq25180_dev_set_wake_config(dev, &wake);
+}
+static void run_get_wake_config(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	struct bq25180_wake_config wake;
+	bq25180_dev_get_wake_config(dev, &wake);
+}
+static void run_enable_interrupt(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_enable_interrupt(dev, BQ25180_INTR_ALL);
+}
+static void run_disable_interrupt(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_disable_interrupt(dev, BQ25180_INTR_ALL);
+}
+
+static void get_custom_config(struct bq25180_config *cfg) {
+	bq25180_get_default_config(cfg);
+	cfg->battery_regulation_millivoltage = 4350;
+	cfg->fastcharge_milliampere = 300;
+	cfg->input_milliampere = 500;
+	cfg->vindpm = BQ25180_VINDPM_4500mV;
+	cfg->watchdog = BQ25180_WDT_DISABLE;
+	cfg->interrupts = BQ25180_INTR_ALL;
+}
+
+static void run_apply_config(struct bq25180 *dev, struct bq25180_sim *sim) {
+	struct bq25180_config cfg;
+	get_custom_config(&cfg);
+	bq25180_dev_apply_config(dev, &cfg);
+}
+
+static void run_apply_config_image(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	using namespace libmcu::bq25180::literals;
+	/* the same as get_custom_config() */
+	constexpr auto image = libmcu::bq25180::config()
+		.battery_regulation(4350_mV)
+		.fastcharge_current(300_mA)
+		.input_current(500_mA)
+		.vindpm(BQ25180_VINDPM_4500mV)
+		.watchdog(BQ25180_WDT_DISABLE)
+		.interrupts(BQ25180_INTR_ALL)
+		.image();
+	bq25180_dev_apply_config_image(dev, image.data());
+}
+
+static void run_restore_config_image(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	struct bq25180_config cfg;
+	uint8_t image[BQ25180_CONFIG_IMAGE_LEN];
+	get_custom_config(&cfg);
+	bq25180_get_config_image(&cfg, image);
+	/* Found at the reset values as after the watchdog expiry */
+	bq25180_dev_restore_config_image(dev, image, NULL);
+}
+
+static void run_get_config_live(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	struct bq25180_config cfg;
+	bq25180_dev_get_config(dev, &cfg, true);
+}
+
+static void run_probe(struct bq25180 *dev, struct bq25180_sim *sim) {
+	struct bq25180_config cfg;
+	uint8_t image[BQ25180_CONFIG_IMAGE_LEN];
+	get_custom_config(&cfg);
+	bq25180_get_config_image(&cfg, image);
+	bq25180_dev_probe(dev, image, NULL);
+}
+
+static void run_process_interrupt(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_dev_notify_interrupt(dev);
+	bq25180_dev_process_interrupt(dev);
+}
+
+static void run_cold_boot(struct bq25180 *dev, struct bq25180_sim *sim) {
+	struct bq25180_config cfg;
+	get_custom_config(&cfg);
+
+	bq25180_dev_enable_cache(dev, true);
+	bq25180_dev_apply_config(dev, &cfg);
+}
+
+static void run_status_poll_1hz(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	struct bq25180_state state;
+
+	for (int i = 0; i < 60; i++) {
+		bq25180_sim_step(sim, 1000);
+		bq25180_dev_read_snapshot(dev, &state, NULL);
+	}
+}
+
+static void notify(void *ctx) {
+	bq25180_dev_notify_interrupt((struct bq25180 *)ctx);
+}
+
+static void run_interrupt_service(struct bq25180 *dev,
+		struct bq25180_sim *sim) {
+	bq25180_sim_set_interrupt_handler(sim, notify, dev);
+
+	/* Plug in, hit ILIM, unplug and plug in again */
+	bq25180_sim_set_source(sim, 5000, 0);
+	bq25180_dev_process_interrupt(dev);
+	bq25180_sim_set_sys_load(sim, 800);
+	bq25180_dev_process_interrupt(dev);
+	bq25180_sim_set_source(sim, 0, 0);
+	bq25180_dev_process_interrupt(dev);
+	bq25180_sim_set_source(sim, 5000, 0);
+	bq25180_dev_process_interrupt(dev);
+}
+
+static const struct bench benches[] = {
+	{ "reset",				run_reset },
+	{ "enable_cache",			run_enable_cache },
+	{ "read_event",				run_read_event },
+	{ "read_state",				run_read_state },
+	{ "read_snapshot",			run_read_snapshot },
+	{ "dump",				run_dump },
+	{ "enable_battery_charging",		run_enable_battery_charging },
+	{ "set_safety_timer",			run_set_safety_timer },
+	{ "set_watchdog_timer",			run_set_watchdog_timer },
+	{ "set_battery_regulation_voltage",
+		run_set_battery_regulation_voltage },
+	{ "set_battery_discharge_current",
+		run_set_battery_discharge_current },
+	{ "set_battery_under_voltage",		run_set_battery_under_voltage },
+	{ "set_precharge_threshold",		run_set_precharge_threshold },
+	{ "set_precharge_current",		run_set_precharge_current },
+	{ "set_fastcharge_current",		run_set_fastcharge_current },
+	{ "set_termination_current",		run_set_termination_current },
+	{ "enable_vindpm",			run_enable_vindpm },
+	{ "enable_dppm",			run_enable_dppm },
+	{ "set_input_current",			run_set_input_current },
+	{ "set_sys_source",			run_set_sys_source },
+	{ "set_sys_voltage",			run_set_sys_voltage },
+	{ "enable_thermal_protection",		run_enable_thermal_protection },
+	{ "enable_push_button",			run_enable_push_button },
+	{ "set_ts_control",			run_set_ts_control },
+	{ "enter_power_mode",			run_enter_power_mode },
+	{ "set_wake_config",			run_set_wake_config },
+	{ "get_wake_config",			run_get_wake_config },
+	{ "enable_interrupt",			run_enable_interrupt },
+	{ "disable_interrupt",			run_disable_interrupt },
+	{ "apply_config",			run_apply_config },
+	{ "apply_config_image",			run_apply_config_image },
+	{ "restore_config_image",		run_restore_config_image },
+	{ "get_config_live",			run_get_config_live },
+	{ "probe",				run_probe },
+	{ "process_interrupt",			run_process_interrupt },
+	{ "scenario_cold_boot",			run_cold_boot },
+	{ "scenario_status_poll_1hz",		run_status_poll_1hz },
+	{ "scenario_interrupt_service",		run_interrupt_service },
+};
+
+#define NR_BENCHES	(sizeof(benches) / sizeof(benches[0]))
+
+static bool load_baseline(const char *name, struct cost *cost) {
+	FILE *f = fopen(BQ25180_BENCH_BASELINE, "r");
+	char line[128];
+	char key[64];
+	bool found = false;
+
+	if (f == NULL) {
+		return false;
+	}
+
+	while (!found && fgets(line, sizeof(line), f)) {
+		if (line[0] == '#') {
+			continue;
+		}
+		if (sscanf(line, "%63s %u %u %u", key, &cost->reads,
+				&cost->writes, &cost->bytes) == 4 &&
+				strcmp(key, name) == 0) {
+			found = true;
+		}
+	}
+
+	fclose(f);
+
+	return found;
+}
+
+static void save_baseline(const struct cost *costs) {
+	FILE *f = fopen(BQ25180_BENCH_BASELINE, "w");
+
+	if (f == NULL) {
+		FAIL("cannot write the baseline");
+	}
+
+	fprintf(f, "# name reads writes bytes\n");
+	for (size_t i = 0; i < NR_BENCHES; i++) {
+		fprintf(f, "%s %u %u %u\n", benches[i].name, costs[i].reads,
+				costs[i].writes, costs[i].bytes);
+	}
+
+	fclose(f);
+}
+
+TEST_GROUP(BQ25180Bench) {
+	struct bq25180_sim sim;
+	struct bq25180 dev;
+
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	struct cost measure(const struct bench *bench, uint32_t *bits) {
+		struct bq25180_sim_stats stats;
+
+		bq25180_sim_init(&sim, BQ25180_DEVICE_ADDRESS);
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_sim_bus, &sim);
+
+		(*bench->run)(&dev, &sim);
+
+		bq25180_sim_get_stats(&sim, &stats);
+		*bits = get_bits(&stats);
+
+		return (struct cost) {
+			.reads = stats.reads,
+			.writes = stats.writes,
+			.bytes = stats.read_bytes + stats.written_bytes,
+		};
+	}
+};
+
+TEST(BQ25180Bench, ShouldNotAddBusTraffic) {
+	struct cost costs[NR_BENCHES];
+	int regressions = 0;
+
+	printf("\n%-32s %6s %6s %6s %9s %9s\n", "operation",
+			"reads", "writes", "bytes", "100kHz us", "400kHz us");
+
+	for (size_t i = 0; i < NR_BENCHES; i++) {
+		struct cost baseline;
+		uint32_t bits;
+
+		costs[i] = measure(&benches[i], &bits);
+
+		printf("%-32s %6u %6u %6u %9u %9u\n", benches[i].name,
+				costs[i].reads, costs[i].writes, costs[i].bytes,
+				get_us(bits, 100000), get_us(bits, 400000));
+
+		if (!load_baseline(benches[i].name, &baseline)) {
+			printf("  no baseline for %s\n", benches[i].name);
+			regressions++;
+		} else if (costs[i].reads + costs[i].writes >
+				baseline.reads + baseline.writes ||
+				costs[i].bytes > baseline.bytes) {
+			printf("  regressed from %u transactions and %u bytes\n",
+					baseline.reads + baseline.writes,
+					baseline.bytes);
+			regressions++;
+		}
+	}
+
+	if (getenv("BQ25180_BENCH_UPDATE")) {
+		save_baseline(costs);
+		return;
+	}
+
+	LONGS_EQUAL(0, regressions);
+}
@@ -2,7 +2,10 @@
 
 COMPONENT_NAME = bq25180
 
-SRC_FILES = ../bq25180.c
+SRC_FILES = \
+	../bq25180.c \
+	../bq25180_compat.c \
+	../bq25180_dump.c \
 
 TEST_SRC_FILES = \
 	src/bq25180_test.cpp \
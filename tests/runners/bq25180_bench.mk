@@ -0,0 +1,22 @@
+# SPDX-License-Identifier: MIT
+
+COMPONENT_NAME = bq25180_bench
+
+SRC_FILES = \
+	../bq25180.c \
+	sim/bq25180_sim.c \
+
+TEST_SRC_FILES = \
+	bench/bq25180_bench.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	../ \
+	sim \
+	$(CPPUTEST_HOME)/include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -Dassert=fake_assert
+CPPUTEST_CXXFLAGS = -std=c++17
+
+include runner.mk
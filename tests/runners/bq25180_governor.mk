@@ -0,0 +1,22 @@
+# SPDX-License-Identifier: MIT
+
+COMPONENT_NAME = bq25180_governor
+
+SRC_FILES = \
+	../bq25180.c \
+	../bq25180_governor.c \
+	sim/bq25180_sim.c \
+
+TEST_SRC_FILES = \
+	src/bq25180_governor_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	../ \
+	sim \
+	$(CPPUTEST_HOME)/include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -Dassert=fake_assert
+
+include runner.mk
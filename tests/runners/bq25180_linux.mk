@@ -0,0 +1,21 @@
+# SPDX-License-Identifier: MIT
+
+COMPONENT_NAME = bq25180_linux
+
+SRC_FILES = \
+	../bq25180.c \
+	../ports/linux/bq25180_linux.c \
+
+TEST_SRC_FILES = \
+	src/bq25180_linux_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	../ \
+	../ports/linux \
+	$(CPPUTEST_HOME)/include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -Dassert=fake_assert
+
+include runner.mk
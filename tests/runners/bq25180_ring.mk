@@ -0,0 +1,23 @@
+# SPDX-License-Identifier: MIT
+
+COMPONENT_NAME = bq25180_ring
+
+SRC_FILES = \
+	../bq25180.c \
+	../bq25180_ring.c \
+	sim/bq25180_sim.c \
+
+TEST_SRC_FILES = \
+	src/bq25180_ring_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	../ \
+	sim \
+	$(CPPUTEST_HOME)/include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -Dassert=fake_assert
+LD_LIBRARIES = -lpthread
+
+include runner.mk
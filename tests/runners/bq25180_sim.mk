@@ -0,0 +1,24 @@
+# SPDX-License-Identifier: MIT
+
+COMPONENT_NAME = bq25180_sim
+
+SRC_FILES = \
+	../bq25180.c \
+	../bq25180_compat.c \
+	../bq25180_dump.c \
+	sim/bq25180_sim.c \
+	sim/bq25180_sim_overrides.c \
+
+TEST_SRC_FILES = \
+	src/bq25180_sim_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	../ \
+	sim \
+	$(CPPUTEST_HOME)/include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -Dassert=fake_assert
+
+include runner.mk
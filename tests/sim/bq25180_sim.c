@@ -0,0 +1,665 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_sim.h"
+#include "bq25180_internal.h"
+
+#include <errno.h>
+#include <string.h>
+
+#define VIN_OVP_mV			5500U
+#define VIN_UVLO_mV			3400U
+#define VIN_SLEEP_mV			80U /* VIN - VBAT to be powered */
+#define VRCH_mV				100U /* recharge below VBATREG */
+#define TREG_CELSIUS			125
+#define TSHUT_CELSIUS			150
+#define TAPER_TAU_MS			600000U /* CV current time constant */
+
+#define SHIP_RST_REG_RST		0x80U /* the only bit clearing itself */
+#define DEFAULT_BATTERY_mV		3700U
+#define DEFAULT_CAPACITY_mAh		100U
+#define DEFAULT_AMBIENT_CELSIUS		25
+#define DEFAULT_CELSIUS_PER_WATT	100U
+
+static const uint8_t reset_defaults[NR_REGISTERS] = {
+	[VBAT_CTRL]	= 0x46,
+	[ICHG_CTRL]	= 0x05,
+	[CHARGECTRL0]	= 0x2c,
+	[CHARGECTRL1]	= 0x56,
+	[IC_CTRL]	= 0x84,
+	[TMR_ILIM]	= 0x4d,
+	[SHIP_RST]	= 0x11,
+	[SYS_REG]	= 0x40,
+	[TS_CONTROL]	= 0x00,
+	[MASK_ID]	= 0xc0, /* DEVICE_ID 0 */
+};
+
+/* Bits the host can change. The status registers and the ID are read-only */
+static const uint8_t writable[NR_REGISTERS] = {
+	[VBAT_CTRL]	= 0x7f,
+	[ICHG_CTRL]	= 0xff,
+	[CHARGECTRL0]	= 0x7f,
+	[CHARGECTRL1]	= 0xff,
+	[IC_CTRL]	= 0xff,
+	[TMR_ILIM]	= 0xff,
+	[SHIP_RST]	= 0xff,
+	[SYS_REG]	= 0xef,
+	[TS_CONTROL]	= 0xff,
+	[MASK_ID]	= 0xf0,
+};
+
+static const uint16_t ilim_mA[] = { 50, 100, 200, 300, 400, 500, 700, 1100 };
+static const uint16_t vindpm_mV[] = { 4200, 4500, 4700, 0 };
+static const uint16_t buvlo_mV[] = {
+	3000, 3000, 3000, 2800, 2600, 2400, 2200, 2000,
+};
+static const uint16_t ocp_mA[] = { 500, 1000, 1500, 0 };
+static const uint8_t iterm_pct[] = { 0, 5, 10, 20 };
+static const uint32_t watchdog_ms[] = { 160000, 160000, 40000, 0 };
+static const uint32_t safety_ms[] = { 10800000, 21600000, 43200000, 0 };
+
+static uint16_t get_battery_mV(const struct bq25180_sim *sim)
+{
+	return (uint16_t)(sim->model.battery_microvoltage / 1000U);
+}
+
+/* TS_STAT 2 is the cool zone and 3 the warm zone, each can be disabled in
+ * TS_CONTROL */
+static bool is_ts_zone(const struct bq25180_sim *sim,
+		uint8_t zone, uint8_t disable_bit)
+{
+	return (sim->regs[IC_CTRL] & 0x80U) && sim->env.ts_status == zone &&
+		!(sim->regs[TS_CONTROL] & disable_bit);
+}
+
+static uint16_t get_fastcharge_mA(const struct bq25180_sim *sim)
+{
+	const uint8_t code = sim->regs[ICHG_CTRL] & 0x7fU;
+	const uint16_t mA = (uint16_t)(code <= 30?
+			code + 5U : (code - 27U) * 10U);
+
+	if (is_ts_zone(sim, 2, 0x04U)) { /* TS_COOL */
+		const uint32_t pct = (sim->regs[TS_CONTROL] & 0x02U)? 20 : 50;
+		return (uint16_t)(mA * pct / 100U);
+	}
+
+	return mA;
+}
+
+static uint16_t get_termination_mA(const struct bq25180_sim *sim)
+{
+	const uint8_t pct = iterm_pct[(sim->regs[CHARGECTRL0] >> 4) & 3U];
+	return (uint16_t)(get_fastcharge_mA(sim) * pct / 100U);
+}
+
+static uint16_t get_precharge_mA(const struct bq25180_sim *sim)
+{
+	const uint16_t iterm = get_termination_mA(sim);
+	/* IPRECHG cleared for double the termination current */
+	const uint16_t iprechg = (sim->regs[CHARGECTRL0] & 0x40U)?
+			iterm : (uint16_t)(iterm * 2U);
+
+	return iprechg? iprechg : 1U;
+}
+
+static uint16_t get_regulation_mV(const struct bq25180_sim *sim)
+{
+	const uint16_t mV = (uint16_t)(3500U +
+			(sim->regs[VBAT_CTRL] & 0x7fU) * 10U);
+
+	if (is_ts_zone(sim, 3, 0x08U)) { /* TS_WARM */
+		return (uint16_t)(mV -
+				((sim->regs[TS_CONTROL] & 0x01U)? 200U : 100U));
+	}
+
+	return mV;
+}
+
+static uint16_t get_lowv_mV(const struct bq25180_sim *sim)
+{
+	return (sim->regs[IC_CTRL] & 0x40U)? 2800U : 3000U;
+}
+
+static void reset_control_registers(struct bq25180_sim *sim)
+{
+	memcpy(&sim->regs[VBAT_CTRL], &reset_defaults[VBAT_CTRL],
+			NR_REGISTERS - VBAT_CTRL);
+	sim->model.done = false;
+	sim->model.safety_expired = false;
+	sim->model.charge_ms = 0;
+	sim->model.watchdog_ms = 0;
+}
+
+static void power_on(struct bq25180_sim *sim)
+{
+	memset(sim->regs, 0, sizeof(sim->regs));
+	reset_control_registers(sim);
+	sim->mode = BQ25180_SIM_ACTIVE;
+	sim->pending_mode = 0;
+}
+
+static void raise_interrupt(struct bq25180_sim *sim)
+{
+	sim->stats.interrupts++;
+
+	if (sim->on_interrupt) {
+		(*sim->on_interrupt)(sim->interrupt_ctx);
+	}
+}
+
+static void check_interrupts(struct bq25180_sim *sim,
+		uint8_t stat0, uint8_t stat1, uint8_t flag0)
+{
+	const uint8_t chgctrl1 = sim->regs[CHARGECTRL1];
+	const uint8_t mask_id = sim->regs[MASK_ID];
+	const uint8_t changed0 = stat0 ^ sim->regs[STAT0];
+	const uint8_t changed1 = stat1 ^ sim->regs[STAT1];
+	const uint8_t raised = (uint8_t)(~flag0 & sim->regs[FLAG0]);
+	bool fire = false;
+
+	if ((changed0 & 0x60U) && !(chgctrl1 & 0x04U)) { /* CHG_STAT */
+		fire = true;
+	}
+	if ((raised & 0x40U) && !(chgctrl1 & 0x02U)) { /* ILIM */
+		fire = true;
+	}
+	if ((raised & 0x30U) && !(chgctrl1 & 0x01U)) { /* VINDPM, VDPPM */
+		fire = true;
+	}
+	if (((raised & 0x80U) || (changed1 & 0x18U)) &&
+			!(mask_id & 0x80U)) { /* TS */
+		fire = true;
+	}
+	if ((raised & 0x08U) && !(mask_id & 0x40U)) { /* TREG */
+		fire = true;
+	}
+	if ((raised & 0x03U) && !(mask_id & 0x20U)) { /* BUVLO, BAT_OCP */
+		fire = true;
+	}
+	if (((raised & 0x04U) || (changed0 & 0x01U)) &&
+			!(mask_id & 0x10U)) { /* VIN_OVP, VIN_PGOOD */
+		fire = true;
+	}
+
+	if (fire) {
+		raise_interrupt(sim);
+	}
+}
+
+static uint16_t get_charge_target_mA(struct bq25180_sim *sim,
+		bool charging, uint16_t vbat, uint16_t vreg)
+{
+	if (!charging) {
+		return 0;
+	}
+	if (vbat < get_lowv_mV(sim)) {
+		return get_precharge_mA(sim);
+	}
+	if (vbat < vreg) {
+		sim->model.taper_microampere = get_fastcharge_mA(sim) * 1000U;
+	}
+
+	return (uint16_t)(sim->model.taper_microampere / 1000U);
+}
+
+static uint8_t get_charge_status(const struct bq25180_sim *sim,
+		bool charging, uint16_t vbat, uint16_t vreg)
+{
+	if (sim->model.done) {
+		return 3;
+	} else if (!charging) {
+		return 0;
+	} else if (vbat >= vreg) {
+		return 2;
+	}
+
+	return 1;
+}
+
+static void integrate_battery(struct bq25180_sim *sim, uint32_t elapsed_ms,
+		uint16_t vreg, uint32_t discharge_mA)
+{
+	/* 1200mV over the whole capacity: uV = mA * ms / (3 * mAh) */
+	const uint64_t div = 3U * sim->env.battery_capacity_mah;
+	const uint64_t charge_uV = (uint64_t)sim->model.charge_milliampere *
+		elapsed_ms / div;
+	const uint64_t discharge_uV = (uint64_t)discharge_mA * elapsed_ms / div;
+	uint64_t uV = sim->model.battery_microvoltage + charge_uV;
+
+	uV = uV > discharge_uV? uV - discharge_uV : 0;
+
+	if (sim->model.charge_milliampere && uV >= vreg * 1000U) {
+		uV = vreg * 1000U;
+	}
+
+	sim->model.battery_microvoltage = (uint32_t)uV;
+}
+
+static void taper(struct bq25180_sim *sim, uint32_t elapsed_ms)
+{
+	/* Constant voltage: the current decays exponentially */
+	const uint64_t decay = (uint64_t)sim->model.taper_microampere *
+		elapsed_ms / TAPER_TAU_MS;
+
+	sim->model.taper_microampere = decay >= sim->model.taper_microampere?
+		0 : (uint32_t)(sim->model.taper_microampere - decay);
+}
+
+static void update(struct bq25180_sim *sim, uint32_t elapsed_ms)
+{
+	const uint8_t stat0 = sim->regs[STAT0];
+	const uint8_t stat1 = sim->regs[STAT1];
+	const uint8_t flag0 = sim->regs[FLAG0];
+	const uint16_t src = sim->env.source_millivoltage;
+	const uint16_t r = sim->env.source_milliohm;
+	const uint16_t load = sim->env.sys_load_milliampere;
+	const uint16_t vbat = get_battery_mV(sim);
+	const uint16_t vreg = get_regulation_mV(sim);
+	const bool ovp = src > VIN_OVP_mV;
+	const bool pgood = !ovp && src >= VIN_UVLO_mV &&
+			src > vbat + VIN_SLEEP_mV;
+	const bool buvlo = vbat < buvlo_mV[(sim->regs[CHARGECTRL1] >> 3) & 7U];
+	const bool ts_suspended = sim->env.ts_status == 1;
+
+	if (!pgood) {
+		sim->model.done = false;
+		sim->model.safety_expired = false;
+		sim->model.charge_ms = 0;
+	} else if (sim->model.done && vbat + VRCH_mV < vreg) {
+		sim->model.done = false;
+	}
+
+	const bool charging = pgood && !sim->model.done &&
+			!sim->model.safety_expired && !ts_suspended &&
+			!(sim->regs[ICHG_CTRL] & 0x80U); /* CHG_DIS */
+	const uint16_t target = get_charge_target_mA(sim,
+			charging, vbat, vreg);
+
+	/* Input side: ILIM first, then VINDPM pulling the current back until
+	 * the input stays at the threshold */
+	const uint32_t demand = pgood? (uint32_t)load + target : 0;
+	const uint16_t vindpm = vindpm_mV[(sim->regs[CHARGECTRL0] >> 2) & 3U];
+	uint32_t iin_max = ilim_mA[sim->regs[TMR_ILIM] & 7U];
+	bool ilim_active = demand > iin_max;
+	bool vindpm_active = false;
+
+	if (pgood && vindpm && r) {
+		const uint32_t dpm_max = src > vindpm?
+				(uint32_t)(src - vindpm) * 1000U / r : 0;
+		if (demand > dpm_max && dpm_max < iin_max) {
+			iin_max = dpm_max;
+			vindpm_active = true;
+			ilim_active = false;
+		}
+	}
+
+	const uint32_t iin = demand < iin_max? demand : iin_max;
+	const uint32_t vin = pgood? src - iin * r / 1000U : src;
+	uint32_t ichg = iin > load? iin - load : 0;
+
+	/* Die temperature follows the power dissipated by the charger. Thermal
+	 * regulation pulls the current back to hold the die at TREG */
+	const int32_t ambient = sim->env.ambient_celsius;
+	const uint32_t drop = vin > vbat? vin - vbat : 0;
+	const uint32_t theta = sim->env.celsius_per_watt;
+	bool treg = false;
+
+	if (ambient >= TSHUT_CELSIUS) {
+		ichg = 0;
+	} else if (ambient >= TREG_CELSIUS) {
+		ichg = 0;
+		treg = true;
+	} else if (drop && theta) {
+		const uint32_t headroom = (uint32_t)(TREG_CELSIUS - ambient);
+		const uint32_t ichg_max = (uint32_t)((uint64_t)headroom *
+				1000000U / (theta * drop));
+		if (ichg > ichg_max) {
+			ichg = ichg_max;
+			treg = true;
+		}
+	}
+
+	const int32_t die = ambient +
+		(int32_t)((uint64_t)drop * ichg * theta / 1000000U);
+
+	/* The battery supplements SYS beyond what the input gives */
+	const uint32_t supplement = load > iin? load - iin : 0;
+	const uint16_t ocp = ocp_mA[(sim->regs[CHARGECTRL1] >> 6) & 3U];
+	const bool bat_ocp = ocp && supplement > ocp;
+
+	sim->model.input_millivoltage = (uint16_t)vin;
+	sim->model.input_milliampere = (uint16_t)(iin > load?
+			load + ichg : iin);
+	sim->model.charge_milliampere = (uint16_t)ichg;
+	sim->model.die_celsius = (int16_t)die;
+
+	if (charging) {
+		const uint8_t code = (sim->regs[IC_CTRL] >> 2) & 3U;
+		const uint32_t limit = safety_ms[code];
+		sim->model.charge_ms += elapsed_ms;
+		if (limit && sim->model.charge_ms >= limit) {
+			sim->model.safety_expired = true;
+		}
+	}
+
+	if (charging && vbat >= vreg) {
+		const uint16_t iterm = get_termination_mA(sim);
+
+		taper(sim, elapsed_ms);
+
+		if (iterm && sim->model.taper_microampere <= iterm * 1000U) {
+			sim->model.done = true;
+			sim->model.charge_milliampere = 0;
+		}
+	}
+
+	integrate_battery(sim, elapsed_ms, vreg, bat_ocp? 0 : supplement);
+
+	sim->regs[STAT0] = (uint8_t)(
+		pgood |
+		(treg << 1) |
+		(vindpm_active << 2) |
+		(ilim_active << 4) |
+		(get_charge_status(sim, charging, vbat, vreg) << 5));
+	sim->regs[STAT1] = (uint8_t)(
+		(sim->model.safety_expired << 2) |
+		((sim->env.ts_status & 3U) << 3) |
+		(buvlo << 6) |
+		(ovp << 7));
+	sim->regs[FLAG0] |= (uint8_t)(
+		bat_ocp |
+		(buvlo << 1) |
+		(ovp << 2) |
+		(treg << 3) |
+		(vindpm_active << 4) |
+		(ilim_active << 6) |
+		((sim->env.ts_status != 0) << 7));
+
+	check_interrupts(sim, stat0, stat1, flag0);
+}
+
+static void kick_watchdog(struct bq25180_sim *sim)
+{
+	sim->model.watchdog_ms = 0;
+}
+
+static void run_watchdog(struct bq25180_sim *sim, uint32_t elapsed_ms)
+{
+	const uint32_t period = watchdog_ms[sim->regs[IC_CTRL] & 3U];
+
+	if (!period) {
+		return;
+	}
+
+	sim->model.watchdog_ms += elapsed_ms;
+
+	if (sim->model.watchdog_ms >= period) {
+		reset_control_registers(sim);
+		sim->stats.watchdog_expiries++;
+		sim->stats.register_resets++;
+	}
+}
+
+static void enter_pending_mode(struct bq25180_sim *sim)
+{
+	if (!sim->pending_mode || sim->env.source_millivoltage) {
+		return;
+	}
+
+	/* EN_RST_SHIP: 1 for shutdown and 2 for shipmode */
+	sim->mode = sim->pending_mode == 1?
+			BQ25180_SIM_SHUTDOWN : BQ25180_SIM_SHIP;
+	sim->pending_mode = 0;
+	memset(sim->regs, 0, sizeof(sim->regs));
+}
+
+static void write_ship_rst(struct bq25180_sim *sim, uint8_t val)
+{
+	const uint8_t en_rst_ship = (val >> 5) & 3U;
+
+	/* EN_RST_SHIP holds a request until carried out. Writing 00 cancels */
+	sim->regs[SHIP_RST] = val & (uint8_t)~SHIP_RST_REG_RST;
+
+	if (val & SHIP_RST_REG_RST) {
+		reset_control_registers(sim);
+		sim->pending_mode = 0;
+		sim->stats.register_resets++;
+		return;
+	}
+
+	if (en_rst_ship == 3) {
+		power_on(sim);
+		sim->stats.hardware_resets++;
+	} else {
+		sim->pending_mode = en_rst_ship;
+		enter_pending_mode(sim);
+	}
+}
+
+static bool is_reachable(struct bq25180_sim *sim, uint8_t addr,
+		uint8_t reg, size_t len)
+{
+	if (addr != sim->addr || sim->mode != BQ25180_SIM_ACTIVE ||
+			(size_t)reg + len > NR_REGISTERS) {
+		sim->stats.naks++;
+		return false;
+	}
+	if (sim->nak_count) {
+		sim->nak_count--;
+		sim->stats.naks++;
+		return false;
+	}
+
+	return true;
+}
+
+static int sim_read(void *ctx, uint8_t addr, uint8_t reg,
+		void *buf, size_t bufsize)
+{
+	struct bq25180_sim *sim = (struct bq25180_sim *)ctx;
+	uint8_t *p = (uint8_t *)buf;
+
+	if (!is_reachable(sim, addr, reg, bufsize)) {
+		return -EIO;
+	}
+
+	memcpy(p, &sim->regs[reg], bufsize);
+
+	if (reg <= FLAG0 && reg + bufsize > FLAG0) {
+		sim->regs[FLAG0] = 0;
+	}
+
+	sim->stats.reads++;
+	sim->stats.read_bytes += (uint32_t)bufsize;
+	kick_watchdog(sim);
+
+	return (int)bufsize;
+}
+
+static int sim_write(void *ctx, uint8_t addr, uint8_t reg,
+		const void *data, size_t data_len)
+{
+	struct bq25180_sim *sim = (struct bq25180_sim *)ctx;
+	const uint8_t *p = (const uint8_t *)data;
+
+	if (!is_reachable(sim, addr, reg, data_len)) {
+		return -EIO;
+	}
+
+	sim->stats.writes++;
+	sim->stats.written_bytes += (uint32_t)data_len;
+	kick_watchdog(sim);
+
+	for (size_t i = 0; i < data_len; i++) {
+		const uint8_t r = (uint8_t)(reg + i);
+		const uint8_t val = (uint8_t)((sim->regs[r] & ~writable[r]) |
+				(p[i] & writable[r]));
+
+		if (r == SHIP_RST) {
+			write_ship_rst(sim, val);
+		} else {
+			sim->regs[r] = val;
+		}
+	}
+
+	update(sim, 0);
+
+	return (int)data_len;
+}
+
+const struct bq25180_bus bq25180_sim_bus = {
+	.read = sim_read,
+	.write = sim_write,
+};
+
+void bq25180_sim_init(struct bq25180_sim *sim, uint8_t addr)
+{
+	memset(sim, 0, sizeof(*sim));
+
+	sim->addr = addr;
+	sim->env.battery_capacity_mah = DEFAULT_CAPACITY_mAh;
+	sim->env.ambient_celsius = DEFAULT_AMBIENT_CELSIUS;
+	sim->env.celsius_per_watt = DEFAULT_CELSIUS_PER_WATT;
+	sim->model.battery_microvoltage = DEFAULT_BATTERY_mV * 1000U;
+
+	power_on(sim);
+	update(sim, 0);
+}
+
+void bq25180_sim_step(struct bq25180_sim *sim, uint32_t elapsed_ms)
+{
+	if (sim->mode != BQ25180_SIM_ACTIVE) {
+		return;
+	}
+
+	run_watchdog(sim, elapsed_ms);
+	enter_pending_mode(sim);
+
+	if (sim->mode == BQ25180_SIM_ACTIVE) {
+		update(sim, elapsed_ms);
+	}
+}
+
+void bq25180_sim_set_source(struct bq25180_sim *sim,
+		uint16_t millivoltage, uint16_t milliohm)
+{
+	sim->env.source_millivoltage = millivoltage;
+	sim->env.source_milliohm = milliohm;
+
+	if (sim->mode != BQ25180_SIM_ACTIVE) {
+		if (!millivoltage) {
+			return;
+		}
+		power_on(sim);
+	}
+
+	enter_pending_mode(sim);
+
+	if (sim->mode == BQ25180_SIM_ACTIVE) {
+		update(sim, 0);
+	}
+}
+
+void bq25180_sim_set_battery(struct bq25180_sim *sim,
+		uint16_t millivoltage, uint16_t capacity_mah)
+{
+	sim->model.battery_microvoltage = millivoltage * 1000U;
+	sim->env.battery_capacity_mah = capacity_mah? capacity_mah : 1U;
+
+	if (sim->mode == BQ25180_SIM_ACTIVE) {
+		update(sim, 0);
+	}
+}
+
+void bq25180_sim_set_sys_load(struct bq25180_sim *sim, uint16_t milliampere)
+{
+	sim->env.sys_load_milliampere = milliampere;
+
+	if (sim->mode == BQ25180_SIM_ACTIVE) {
+		update(sim, 0);
+	}
+}
+
+void bq25180_sim_set_thermal(struct bq25180_sim *sim,
+		int16_t ambient_celsius, uint16_t celsius_per_watt)
+{
+	sim->env.ambient_celsius = ambient_celsius;
+	sim->env.celsius_per_watt = celsius_per_watt;
+
+	if (sim->mode == BQ25180_SIM_ACTIVE) {
+		update(sim, 0);
+	}
+}
+
+void bq25180_sim_set_ts_status(struct bq25180_sim *sim, uint8_t ts_status)
+{
+	sim->env.ts_status = ts_status & 3U;
+
+	if (sim->mode == BQ25180_SIM_ACTIVE) {
+		update(sim, 0);
+	}
+}
+
+void bq25180_sim_press_button(struct bq25180_sim *sim)
+{
+	if (sim->mode == BQ25180_SIM_SHIP) {
+		power_on(sim);
+		update(sim, 0);
+	}
+}
+
+void bq25180_sim_inject_nak(struct bq25180_sim *sim, uint8_t count)
+{
+	sim->nak_count = count;
+}
+
+void bq25180_sim_set_interrupt_handler(struct bq25180_sim *sim,
+		void (*func)(void *ctx), void *ctx)
+{
+	sim->on_interrupt = func;
+	sim->interrupt_ctx = ctx;
+}
+
+uint8_t bq25180_sim_peek(const struct bq25180_sim *sim, uint8_t reg)
+{
+	return reg < NR_REGISTERS? sim->regs[reg] : 0;
+}
+
+uint16_t bq25180_sim_battery_millivoltage(const struct bq25180_sim *sim)
+{
+	return get_battery_mV(sim);
+}
+
+uint16_t bq25180_sim_charge_milliampere(const struct bq25180_sim *sim)
+{
+	return sim->model.charge_milliampere;
+}
+
+uint16_t bq25180_sim_input_milliampere(const struct bq25180_sim *sim)
+{
+	return sim->model.input_milliampere;
+}
+
+int16_t bq25180_sim_die_celsius(const struct bq25180_sim *sim)
+{
+	return sim->model.die_celsius;
+}
+
+enum bq25180_sim_mode bq25180_sim_mode(const struct bq25180_sim *sim)
+{
+	return sim->mode;
+}
+
+void bq25180_sim_get_stats(const struct bq25180_sim *sim,
+		struct bq25180_sim_stats *stats)
+{
+	*stats = sim->stats;
+}
+
+void bq25180_sim_clear_stats(struct bq25180_sim *sim)
+{
+	memset(&sim->stats, 0, sizeof(sim->stats));
+}
@@ -0,0 +1,268 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_SIM_H
+#define LIBMCU_BQ25180_SIM_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+enum bq25180_sim_mode {
+	BQ25180_SIM_ACTIVE,
+	BQ25180_SIM_SHIP, /**< wakes up on VIN or the push button */
+	BQ25180_SIM_SHUTDOWN, /**< wakes up on VIN only */
+};
+
+struct bq25180_sim_stats {
+	uint32_t reads; /**< read transactions */
+	uint32_t writes; /**< write transactions */
+	uint32_t read_bytes; /**< register bytes read */
+	uint32_t written_bytes; /**< register bytes written */
+	uint32_t naks; /**< transactions refused */
+	uint32_t watchdog_expiries;
+	uint32_t register_resets; /**< by REG_RST or the watchdog */
+	uint32_t hardware_resets;
+	uint32_t interrupts; /**< pulses on the INT pin */
+};
+
+/**
+ * @brief Behavioral model of a BQ25180
+ *
+ * The register file behaves as the datasheet describes: reset values,
+ * read-only status registers and ID, clear-on-read FLAG0, self-clearing
+ * REG_RST, EN_RST_SHIP holding a shipmode or shutdown request until VIN is
+ * removed or 00 is written, and the I2C watchdog resetting the control
+ * registers on expiry.
+ *
+ * Behind it sits a simple electrical model. The input source is an ideal
+ * voltage source behind a resistance, limited by ILIM and VINDPM. The battery
+ * charges through precharge, constant current and constant voltage phases,
+ * with the die temperature following the power dissipated in the charger.
+ *
+ * Members are private. Use the functions below.
+ */
+struct bq25180_sim {
+	uint8_t addr;
+	uint8_t regs[BQ25180_NR_REGISTERS];
+	enum bq25180_sim_mode mode;
+	uint8_t pending_mode;
+
+	struct {
+		uint16_t source_millivoltage;
+		uint16_t source_milliohm;
+		uint16_t sys_load_milliampere;
+		uint16_t battery_capacity_mah;
+		int16_t ambient_celsius;
+		uint16_t celsius_per_watt;
+		uint8_t ts_status;
+	} env;
+
+	struct {
+		uint32_t battery_microvoltage;
+		uint16_t input_millivoltage;
+		uint16_t input_milliampere;
+		uint16_t charge_milliampere;
+		uint32_t taper_microampere;
+		int16_t die_celsius;
+		bool done;
+		bool safety_expired;
+		uint32_t charge_ms;
+		uint32_t watchdog_ms;
+	} model;
+
+	uint8_t nak_count;
+	void (*on_interrupt)(void *ctx);
+	void *interrupt_ctx;
+
+	struct bq25180_sim_stats stats;
+};
+
+/**
+ * @brief Bus operations reaching the simulated device
+ *
+ * Pass the @ref bq25180_sim as the bus context of @ref bq25180_dev_init.
+ */
+extern const struct bq25180_bus bq25180_sim_bus;
+
+/**
+ * @brief Power on a simulated device
+ *
+ * The device starts with the reset values, no input source, 3.7V on a
+ * 100mAh battery and no system load at 25 degree Celsius.
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[in] addr device address to answer
+ */
+void bq25180_sim_init(struct bq25180_sim *sim, uint8_t addr);
+
+/**
+ * @brief Advance the simulated time
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[in] elapsed_ms time passed in milliseconds
+ */
+void bq25180_sim_step(struct bq25180_sim *sim, uint32_t elapsed_ms);
+
+/**
+ * @brief Set the input source
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[in] millivoltage open circuit voltage or 0 to unplug
+ * @param[in] milliohm resistance of the source and the cable
+ */
+void bq25180_sim_set_source(struct bq25180_sim *sim,
+		uint16_t millivoltage, uint16_t milliohm);
+
+/**
+ * @brief Set the battery
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[in] millivoltage open circuit voltage
+ * @param[in] capacity_mah capacity used to integrate the charge
+ */
+void bq25180_sim_set_battery(struct bq25180_sim *sim,
+		uint16_t millivoltage, uint16_t capacity_mah);
+
+/**
+ * @brief Set the current drawn from SYS
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[in] milliampere system load
+ */
+void bq25180_sim_set_sys_load(struct bq25180_sim *sim, uint16_t milliampere);
+
+/**
+ * @brief Set the thermal environment
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[in] ambient_celsius ambient temperature
+ * @param[in] celsius_per_watt die temperature rise per watt dissipated
+ */
+void bq25180_sim_set_thermal(struct bq25180_sim *sim,
+		int16_t ambient_celsius, uint16_t celsius_per_watt);
+
+/**
+ * @brief Set the TS_STAT the thermistor reports
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[in] ts_status 0 for normal, 1 for suspended, 2 and 3 for the reduced
+ *            current and voltage zones. The reduction follows TS_CONTROL
+ *            while TS_EN is set
+ */
+void bq25180_sim_set_ts_status(struct bq25180_sim *sim, uint8_t ts_status);
+
+/**
+ * @brief Press the push button long enough to wake the device from shipmode
+ *
+ * @param[in] sim @ref bq25180_sim
+ */
+void bq25180_sim_press_button(struct bq25180_sim *sim);
+
+/**
+ * @brief Refuse the next transactions
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[in] count number of transactions to be NAK'd
+ */
+void bq25180_sim_inject_nak(struct bq25180_sim *sim, uint8_t count);
+
+/**
+ * @brief Set the function to be called on every INT pulse
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[in] func function to be called or NULL
+ * @param[in] ctx context to be passed to @p func
+ */
+void bq25180_sim_set_interrupt_handler(struct bq25180_sim *sim,
+		void (*func)(void *ctx), void *ctx);
+
+/**
+ * @brief Get a register value without any side effect
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[in] reg register address
+ *
+ * @return register value
+ */
+uint8_t bq25180_sim_peek(const struct bq25180_sim *sim, uint8_t reg);
+
+/**
+ * @brief Get the battery voltage
+ *
+ * @param[in] sim @ref bq25180_sim
+ *
+ * @return battery voltage in millivolt
+ */
+uint16_t bq25180_sim_battery_millivoltage(const struct bq25180_sim *sim);
+
+/**
+ * @brief Get the current charging the battery
+ *
+ * @param[in] sim @ref bq25180_sim
+ *
+ * @return charge current in milliampere
+ */
+uint16_t bq25180_sim_charge_milliampere(const struct bq25180_sim *sim);
+
+/**
+ * @brief Get the current drawn from the input source
+ *
+ * @param[in] sim @ref bq25180_sim
+ *
+ * @return input current in milliampere
+ */
+uint16_t bq25180_sim_input_milliampere(const struct bq25180_sim *sim);
+
+/**
+ * @brief Get the die temperature
+ *
+ * @param[in] sim @ref bq25180_sim
+ *
+ * @return die temperature in degree Celsius
+ */
+int16_t bq25180_sim_die_celsius(const struct bq25180_sim *sim);
+
+/**
+ * @brief Get the power mode
+ *
+ * @param[in] sim @ref bq25180_sim
+ *
+ * @return @ref bq25180_sim_mode
+ */
+enum bq25180_sim_mode bq25180_sim_mode(const struct bq25180_sim *sim);
+
+/**
+ * @brief Get the bus and event statistics
+ *
+ * @param[in] sim @ref bq25180_sim
+ * @param[out] stats @ref bq25180_sim_stats
+ */
+void bq25180_sim_get_stats(const struct bq25180_sim *sim,
+		struct bq25180_sim_stats *stats);
+
+/**
+ * @brief Clear the statistics
+ *
+ * @param[in] sim @ref bq25180_sim
+ */
+void bq25180_sim_clear_stats(struct bq25180_sim *sim);
+
+/**
+ * @brief Get the device the bq25180_read() and bq25180_write() overrides in
+ *        bq25180_sim_overrides.c reach
+ *
+ * @return @ref bq25180_sim
+ */
+struct bq25180_sim *bq25180_sim_get_default(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_SIM_H */
@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_sim_clock.h"
+#include <string.h>
+
+/* Start and stop conditions, about a bit time each */
+#define FRAMING_BITS		2
+#define BITS_PER_BYTE		9 /* with the acknowledge bit */
+
+static uint64_t get_bits(bool read, size_t len)
+{
+	/* Address and register pointer, then the address again for reads */
+	const uint64_t bytes = 2U + (read? 1U : 0U) + (uint64_t)len;
+
+	return bytes * BITS_PER_BYTE + FRAMING_BITS + (read? 1U : 0U);
+}
+
+static void tick(struct bq25180_sim_clock *clock, bool read, size_t len)
+{
+	const uint32_t before = (uint32_t)(clock->bits * 1000000 / clock->hz);
+
+	clock->bits += get_bits(read, len);
+	clock->now_us += (uint32_t)(clock->bits * 1000000 / clock->hz) - before;
+
+	if (clock->on_transfer) {
+		clock->on_transfer(clock->transfer_ctx);
+	}
+}
+
+static int clock_read(void *ctx, uint8_t addr, uint8_t reg,
+		void *buf, size_t bufsize)
+{
+	struct bq25180_sim_clock *clock = (struct bq25180_sim_clock *)ctx;
+	const int res = clock->bus->read(clock->bus_ctx, addr, reg,
+			buf, bufsize);
+
+	tick(clock, true, bufsize);
+
+	return res;
+}
+
+static int clock_write(void *ctx, uint8_t addr, uint8_t reg,
+		const void *data, size_t data_len)
+{
+	struct bq25180_sim_clock *clock = (struct bq25180_sim_clock *)ctx;
+	const int res = clock->bus->write(clock->bus_ctx, addr, reg,
+			data, data_len);
+
+	tick(clock, false, data_len);
+
+	return res;
+}
+
+const struct bq25180_bus bq25180_sim_clock_bus = {
+	.read = clock_read,
+	.write = clock_write,
+};
+
+void bq25180_sim_clock_init(struct bq25180_sim_clock *clock, uint32_t hz,
+		const struct bq25180_bus *bus, void *bus_ctx)
+{
+	memset(clock, 0, sizeof(*clock));
+
+	clock->hz = hz;
+	clock->bus = bus;
+	clock->bus_ctx = bus_ctx;
+}
+
+uint32_t bq25180_sim_clock_now(void *ctx)
+{
+	const struct bq25180_sim_clock *clock =
+		(const struct bq25180_sim_clock *)ctx;
+	return clock->now_us;
+}
+
+void bq25180_sim_clock_advance(struct bq25180_sim_clock *clock, uint32_t us)
+{
+	clock->now_us += us;
+}
+
+uint32_t bq25180_sim_clock_transfer_us(const struct bq25180_sim_clock *clock,
+		bool read, size_t len)
+{
+	return (uint32_t)(get_bits(read, len) * 1000000 / clock->hz);
+}
+
+void bq25180_sim_clock_set_transfer_handler(struct bq25180_sim_clock *clock,
+		void (*func)(void *ctx), void *ctx)
+{
+	clock->on_transfer = func;
+	clock->transfer_ctx = ctx;
+}
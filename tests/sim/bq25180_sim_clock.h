@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_SIM_CLOCK_H
+#define LIBMCU_BQ25180_SIM_CLOCK_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180.h"
+
+/**
+ * @brief Bus clock advanced by the transfers themselves
+ *
+ * Every transaction passed through takes the time its bits take on the wire
+ * at the bus frequency: the address, the register pointer, the data and an
+ * acknowledge bit after each byte, plus a repeated start and the address
+ * again for reads. Nothing else advances the clock but
+ * @ref bq25180_sim_clock_advance.
+ *
+ * Members are private. Use the functions below.
+ */
+struct bq25180_sim_clock {
+	const struct bq25180_bus *bus;
+	void *bus_ctx;
+	uint32_t hz;
+	uint64_t bits;
+	uint32_t now_us;
+
+	/* Called after every transaction, as if from another bus master */
+	void (*on_transfer)(void *ctx);
+	void *transfer_ctx;
+};
+
+/**
+ * @brief Bus operations going through the clock
+ *
+ * Pass the @ref bq25180_sim_clock as the bus context.
+ */
+extern const struct bq25180_bus bq25180_sim_clock_bus;
+
+/**
+ * @brief Start a bus clock at 0
+ *
+ * @param[in] clock @ref bq25180_sim_clock
+ * @param[in] hz bus frequency, like 100000 or 400000
+ * @param[in] bus @ref bq25180_bus the transactions are passed to
+ * @param[in] bus_ctx context to be passed to @p bus
+ */
+void bq25180_sim_clock_init(struct bq25180_sim_clock *clock, uint32_t hz,
+		const struct bq25180_bus *bus, void *bus_ctx);
+
+/**
+ * @brief Get the time in microseconds
+ *
+ * In the form of a time source to be given to the driver.
+ *
+ * @param[in] ctx @ref bq25180_sim_clock
+ *
+ * @return microseconds since @ref bq25180_sim_clock_init
+ */
+uint32_t bq25180_sim_clock_now(void *ctx);
+
+/**
+ * @brief Let time pass with the bus idle
+ *
+ * @param[in] clock @ref bq25180_sim_clock
+ * @param[in] us microseconds
+ */
+void bq25180_sim_clock_advance(struct bq25180_sim_clock *clock, uint32_t us);
+
+/**
+ * @brief Get the time a transaction takes on the wire
+ *
+ * @param[in] clock @ref bq25180_sim_clock
+ * @param[in] read true for a read or false for a write
+ * @param[in] len number of register bytes
+ *
+ * @return microseconds, rounded down
+ */
+uint32_t bq25180_sim_clock_transfer_us(const struct bq25180_sim_clock *clock,
+		bool read, size_t len);
+
+/**
+ * @brief Set the function to be called after every transaction
+ *
+ * @param[in] clock @ref bq25180_sim_clock
+ * @param[in] func function to be called or NULL
+ * @param[in] ctx context to be passed to @p func
+ */
+void bq25180_sim_clock_set_transfer_handler(struct bq25180_sim_clock *clock,
+		void (*func)(void *ctx), void *ctx);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_SIM_CLOCK_H */
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_sim_mux.h"
+#include <errno.h>
+#include <string.h>
+
+static struct bq25180_sim_mux *find_mux(struct bq25180_sim_mux *head,
+		uint8_t addr)
+{
+	for (struct bq25180_sim_mux *mux = head; mux; mux = mux->next) {
+		if (mux->addr == addr) {
+			return mux;
+		}
+	}
+
+	return NULL;
+}
+
+/* The device reachable at the address, or NULL if none or more than one */
+static struct bq25180_sim *find_device(struct bq25180_sim_mux *head,
+		uint8_t addr)
+{
+	struct bq25180_sim *found = NULL;
+	unsigned int count = 0;
+
+	for (struct bq25180_sim_mux *mux = head; mux; mux = mux->next) {
+		for (uint8_t ch = 0; ch < BQ25180_SIM_MUX_NR_CHANNELS; ch++) {
+			struct bq25180_sim *sim = mux->channels[ch];
+
+			if (sim && (mux->selected & (1U << ch)) &&
+					sim->addr == addr) {
+				found = sim;
+				count++;
+			}
+		}
+	}
+
+	if (count > 1) {
+		head->stats.collisions++;
+		return NULL;
+	} else if (count == 0) {
+		head->stats.naks++;
+		return NULL;
+	}
+
+	head->stats.transfers++;
+
+	return found;
+}
+
+static int mux_read(void *ctx, uint8_t addr, uint8_t reg,
+		void *buf, size_t bufsize)
+{
+	struct bq25180_sim_mux *head = (struct bq25180_sim_mux *)ctx;
+	struct bq25180_sim_mux *mux = find_mux(head, addr);
+
+	if (mux) {
+		/* No register pointer: every byte reads the control register */
+		memset(buf, mux->selected, bufsize);
+		return (int)bufsize;
+	}
+
+	struct bq25180_sim *sim = find_device(head, addr);
+
+	if (sim == NULL) {
+		return -EIO;
+	}
+
+	return bq25180_sim_bus.read(sim, addr, reg, buf, bufsize);
+}
+
+static int mux_write(void *ctx, uint8_t addr, uint8_t reg,
+		const void *data, size_t data_len)
+{
+	struct bq25180_sim_mux *head = (struct bq25180_sim_mux *)ctx;
+	struct bq25180_sim_mux *mux = find_mux(head, addr);
+
+	if (mux && mux->naks_to_inject) {
+		mux->naks_to_inject--;
+		return -EIO;
+	} else if (mux) {
+		/* The first byte is the control register, the rest ignored */
+		mux->selected = reg;
+		mux->stats.selects++;
+		return (int)data_len;
+	}
+
+	struct bq25180_sim *sim = find_device(head, addr);
+
+	if (sim == NULL) {
+		return -EIO;
+	}
+
+	return bq25180_sim_bus.write(sim, addr, reg, data, data_len);
+}
+
+const struct bq25180_bus bq25180_sim_mux_bus = {
+	.read = mux_read,
+	.write = mux_write,
+};
+
+void bq25180_sim_mux_init(struct bq25180_sim_mux *mux, uint8_t addr,
+		struct bq25180_sim_mux *next)
+{
+	memset(mux, 0, sizeof(*mux));
+	mux->addr = addr;
+	mux->next = next;
+}
+
+void bq25180_sim_mux_attach(struct bq25180_sim_mux *mux, uint8_t channel,
+		struct bq25180_sim *sim)
+{
+	mux->channels[channel] = sim;
+}
+
+uint8_t bq25180_sim_mux_selected(const struct bq25180_sim_mux *mux)
+{
+	return mux->selected;
+}
+
+void bq25180_sim_mux_inject_nak(struct bq25180_sim_mux *mux, uint8_t count)
+{
+	mux->naks_to_inject = count;
+}
+
+void bq25180_sim_mux_get_stats(const struct bq25180_sim_mux *mux,
+		struct bq25180_sim_mux_stats *stats)
+{
+	*stats = mux->stats;
+}
@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LIBMCU_BQ25180_SIM_MUX_H
+#define LIBMCU_BQ25180_SIM_MUX_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "bq25180_sim.h"
+
+#define BQ25180_SIM_MUX_NR_CHANNELS	8
+
+struct bq25180_sim_mux_stats {
+	uint32_t selects; /**< writes to the control register */
+	uint32_t transfers; /**< passed through to a device */
+	uint32_t collisions; /**< more than one device reachable */
+	uint32_t naks; /**< no device reachable */
+};
+
+/**
+ * @brief Behavioral model of a TCA9548-style I2C multiplexer
+ *
+ * A single control register, written with no register pointer, connects any
+ * of the 8 channels to the upstream bus. Muxes chained by
+ * @ref bq25180_sim_mux_init share the upstream bus: a transaction to a device
+ * reaches every device at the address on every channel selected, which is a
+ * collision if there are more than one.
+ *
+ * Members are private. Use the functions below.
+ */
+struct bq25180_sim_mux {
+	uint8_t addr;
+	uint8_t selected;
+	struct bq25180_sim *channels[BQ25180_SIM_MUX_NR_CHANNELS];
+	struct bq25180_sim_mux *next;
+	struct bq25180_sim_mux_stats stats;
+	uint8_t naks_to_inject;
+};
+
+/**
+ * @brief Bus operations reaching the muxes and the devices behind them
+ *
+ * Pass the first @ref bq25180_sim_mux of the chain as the bus context.
+ * Transfers to devices are counted in its statistics, selects in the mux
+ * written.
+ */
+extern const struct bq25180_bus bq25180_sim_mux_bus;
+
+/**
+ * @brief Power on a simulated mux with no channel selected
+ *
+ * @param[in] mux @ref bq25180_sim_mux
+ * @param[in] addr mux address to answer
+ * @param[in] next another mux on the same upstream bus or NULL
+ */
+void bq25180_sim_mux_init(struct bq25180_sim_mux *mux, uint8_t addr,
+		struct bq25180_sim_mux *next);
+
+/**
+ * @brief Put a simulated device on a channel
+ *
+ * @param[in] mux @ref bq25180_sim_mux
+ * @param[in] channel 0 to 7
+ * @param[in] sim @ref bq25180_sim
+ */
+void bq25180_sim_mux_attach(struct bq25180_sim_mux *mux, uint8_t channel,
+		struct bq25180_sim *sim);
+
+/**
+ * @brief Get the channel mask selected
+ *
+ * @param[in] mux @ref bq25180_sim_mux
+ *
+ * @return the control register
+ */
+uint8_t bq25180_sim_mux_selected(const struct bq25180_sim_mux *mux);
+
+/**
+ * @brief Refuse the next writes to the control register
+ *
+ * The mux stays on the bus with its channels as they are.
+ *
+ * @param[in] mux @ref bq25180_sim_mux
+ * @param[in] count number of writes to be NAK'd
+ */
+void bq25180_sim_mux_inject_nak(struct bq25180_sim_mux *mux, uint8_t count);
+
+/**
+ * @brief Get the statistics
+ *
+ * @param[in] mux @ref bq25180_sim_mux
+ * @param[out] stats @ref bq25180_sim_mux_stats
+ */
+void bq25180_sim_mux_get_stats(const struct bq25180_sim_mux *mux,
+		struct bq25180_sim_mux_stats *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LIBMCU_BQ25180_SIM_MUX_H */
@@ -0,0 +1,33 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bq25180_sim.h"
+#include "bq25180_overrides.h"
+
+static struct bq25180_sim default_sim;
+static bool initialized;
+
+struct bq25180_sim *bq25180_sim_get_default(void)
+{
+	if (!initialized) {
+		bq25180_sim_init(&default_sim, BQ25180_DEVICE_ADDRESS);
+		initialized = true;
+	}
+
+	return &default_sim;
+}
+
+int bq25180_read(uint8_t addr, uint8_t reg, void *buf, size_t bufsize)
+{
+	return bq25180_sim_bus.read(bq25180_sim_get_default(),
+			addr, reg, buf, bufsize);
+}
+
+int bq25180_write(uint8_t addr, uint8_t reg, const void *data, size_t data_len)
+{
+	return bq25180_sim_bus.write(bq25180_sim_get_default(),
+			addr, reg, data, data_len);
+}
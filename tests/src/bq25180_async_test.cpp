@@ -0,0 +1,263 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include "bq25180_async.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+/* Simulated completion source: transfers are only recorded when started and
+ * get completed by the test. */
+static struct {
+	uint8_t reg;
+	void *buf;
+	size_t len;
+	uint8_t written[4];
+	int started;
+	int start_err;
+	/* Completes from inside the start hook when set */
+	struct bq25180_async *sync;
+	const uint8_t *sync_data;
+} xfer;
+
+static int start_read(void *ctx, uint8_t addr, uint8_t reg,
+		void *buf, size_t bufsize) {
+	xfer.reg = reg;
+	xfer.buf = buf;
+	xfer.len = bufsize;
+	xfer.started++;
+	const int err = mock().actualCall(__func__)
+		.withParameter("reg", reg)
+		.withParameter("bufsize", bufsize)
+		.returnIntValueOrDefault(xfer.start_err);
+	if (xfer.sync && err >= 0) {
+		memcpy(buf, xfer.sync_data, bufsize);
+		bq25180_async_complete(xfer.sync, 0);
+	}
+	return err;
+}
+
+static int start_write(void *ctx, uint8_t addr, uint8_t reg,
+		const void *data, size_t data_len) {
+	xfer.reg = reg;
+	xfer.len = data_len;
+	memcpy(xfer.written, data, data_len);
+	xfer.started++;
+	const int err = mock().actualCall(__func__)
+		.withParameter("reg", reg)
+		.withMemoryBufferParameter("data", (const uint8_t *)data, data_len)
+		.returnIntValueOrDefault(xfer.start_err);
+	if (xfer.sync && err >= 0) {
+		bq25180_async_complete(xfer.sync, 0);
+	}
+	return err;
+}
+
+static void done(struct bq25180_async *async, int err, void *arg) {
+	mock().actualCall(__func__)
+		.withParameter("err", err)
+		.withParameter("arg", arg);
+}
+
+TEST_GROUP(BQ25180Async) {
+	const struct bq25180_async_bus bus = {
+		.start_read = start_read,
+		.start_write = start_write,
+	};
+	struct bq25180_async async;
+
+	void setup(void) {
+		mock().strictOrder();
+		memset(&xfer, 0, sizeof(xfer));
+
+		bq25180_async_init(&async, BQ25180_DEVICE_ADDRESS, &bus, NULL);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void complete_read(const uint8_t *data, size_t len) {
+		memcpy(xfer.buf, data, len);
+		bq25180_async_complete(&async, 0);
+	}
+};
+
+TEST(BQ25180Async, set_ShouldReadModifyWrite_DrivenByCompletions) {
+	uint8_t ichg = 0x85;
+	uint8_t expected = 0x9f;
+
+	mock().expectOneCall("start_read")
+		.withParameter("reg", 0x04).withParameter("bufsize", 1);
+	LONGS_EQUAL(true, bq25180_async_set_fastcharge_current(&async, 40,
+				done, &ichg));
+	LONGS_EQUAL(true, bq25180_async_busy(&async));
+	mock().checkExpectations();
+
+	mock().expectOneCall("start_write")
+		.withParameter("reg", 0x04)
+		.withMemoryBufferParameter("data", &expected, 1);
+	complete_read(&ichg, 1);
+	mock().checkExpectations();
+
+	mock().expectOneCall("done")
+		.withParameter("err", 0).withParameter("arg", &ichg);
+	bq25180_async_complete(&async, 0);
+	LONGS_EQUAL(false, bq25180_async_busy(&async));
+}
+
+TEST(BQ25180Async, read_state_ShouldDecodeAfterBurstRead) {
+	uint8_t regs[] = { 0x35, 0x95 };
+	struct bq25180_state state;
+
+	mock().expectOneCall("start_read")
+		.withParameter("reg", 0x00).withParameter("bufsize", 2);
+	bq25180_async_read_state(&async, &state, done, NULL);
+
+	mock().expectOneCall("done")
+		.withParameter("err", 0).withParameter("arg", (void *)NULL);
+	complete_read(regs, sizeof(regs));
+
+	LONGS_EQUAL(1, state.vin_good);
+	LONGS_EQUAL(1, state.charging_status);
+	LONGS_EQUAL(2, state.ts_status);
+}
+
+TEST(BQ25180Async, read_snapshot_ShouldReadFlagsToo_WhenEventGiven) {
+	uint8_t regs[] = { 0x00, 0x00, 0x41 };
+	struct bq25180_event event;
+
+	mock().expectOneCall("start_read")
+		.withParameter("reg", 0x00).withParameter("bufsize", 3);
+	bq25180_async_read_snapshot(&async, NULL, &event, NULL, NULL);
+	complete_read(regs, sizeof(regs));
+
+	LONGS_EQUAL(1, event.battery_overcurrent);
+	LONGS_EQUAL(1, event.ilim_fault);
+}
+
+TEST(BQ25180Async, ShouldRunQueuedOperationsInOrder) {
+	uint8_t ilim = 0x4d;
+	uint8_t vbat = 0x46;
+	uint8_t expected_ilim = 0x4f;
+
+	mock().expectOneCall("start_read")
+		.withParameter("reg", 0x08).withParameter("bufsize", 1);
+	bq25180_async_set_input_current(&async, 1100, done, &ilim);
+	bq25180_async_set_battery_regulation_voltage(&async, 4200, done, &vbat);
+	LONGS_EQUAL(1, xfer.started);
+
+	mock().expectOneCall("start_write")
+		.withParameter("reg", 0x08)
+		.withMemoryBufferParameter("data", &expected_ilim, 1);
+	complete_read(&ilim, 1);
+
+	mock().expectOneCall("done")
+		.withParameter("err", 0).withParameter("arg", &ilim);
+	mock().expectOneCall("start_write")
+		.withParameter("reg", 0x03)
+		.withMemoryBufferParameter("data", &vbat, 1);
+	bq25180_async_complete(&async, 0);
+
+	mock().expectOneCall("done")
+		.withParameter("err", 0).withParameter("arg", &vbat);
+	bq25180_async_complete(&async, 0);
+}
+
+TEST(BQ25180Async, ShouldNotWrite_WhenReadFails) {
+	mock().expectOneCall("start_read").ignoreOtherParameters();
+	bq25180_async_enable_battery_charging(&async, false, done, NULL);
+
+	mock().expectOneCall("done")
+		.withParameter("err", -5).withParameter("arg", (void *)NULL);
+	bq25180_async_complete(&async, -5);
+	LONGS_EQUAL(false, bq25180_async_busy(&async));
+}
+
+TEST(BQ25180Async, ShouldReportError_WhenTransferFailsToStart) {
+	mock().expectOneCall("start_read").ignoreOtherParameters()
+		.andReturnValue(-16);
+	mock().expectOneCall("done")
+		.withParameter("err", -16).withParameter("arg", (void *)NULL);
+	bq25180_async_enable_battery_charging(&async, true, done, NULL);
+	LONGS_EQUAL(false, bq25180_async_busy(&async));
+}
+
+TEST(BQ25180Async, ShouldReturnFalse_WhenQueueFull) {
+	struct bq25180_state state;
+
+	mock().expectOneCall("start_read").ignoreOtherParameters();
+	for (int i = 0; i < BQ25180_ASYNC_QUEUE_LEN; i++) {
+		LONGS_EQUAL(true, bq25180_async_read_state(&async, &state,
+					NULL, NULL));
+	}
+	LONGS_EQUAL(false, bq25180_async_read_state(&async, &state,
+				NULL, NULL));
+}
+
+TEST(BQ25180Async, ShouldRunThrough_WhenCompletedInsideStart) {
+	uint8_t ilim = 0x4d;
+	uint8_t vbat = 0x46;
+	uint8_t expected_ilim = 0x4f;
+
+	xfer.sync = &async;
+	xfer.sync_data = &ilim;
+
+	mock().expectOneCall("start_read")
+		.withParameter("reg", 0x08).withParameter("bufsize", 1);
+	mock().expectOneCall("start_write")
+		.withParameter("reg", 0x08)
+		.withMemoryBufferParameter("data", &expected_ilim, 1);
+	mock().expectOneCall("done")
+		.withParameter("err", 0).withParameter("arg", &ilim);
+	LONGS_EQUAL(true, bq25180_async_set_input_current(&async, 1100,
+				done, &ilim));
+
+	mock().expectOneCall("start_write")
+		.withParameter("reg", 0x03)
+		.withMemoryBufferParameter("data", &vbat, 1);
+	mock().expectOneCall("done")
+		.withParameter("err", 0).withParameter("arg", &vbat);
+	LONGS_EQUAL(true, bq25180_async_set_battery_regulation_voltage(&async,
+				4200, done, &vbat));
+
+	LONGS_EQUAL(false, bq25180_async_busy(&async));
+}
+
+TEST(BQ25180Async, set_termination_current_ShouldUpdateOnlyItsField) {
+	uint8_t chargectrl0 = 0x2c;
+	uint8_t expected = 0x3c;
+
+	mock().expectOneCall("start_read")
+		.withParameter("reg", 0x05).withParameter("bufsize", 1);
+	bq25180_async_set_termination_current(&async, 20, done, NULL);
+
+	mock().expectOneCall("start_write")
+		.withParameter("reg", 0x05)
+		.withMemoryBufferParameter("data", &expected, 1);
+	complete_read(&chargectrl0, 1);
+
+	mock().expectOneCall("done")
+		.withParameter("err", 0).withParameter("arg", (void *)NULL);
+	bq25180_async_complete(&async, 0);
+}
@@ -0,0 +1,195 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include "bq25180_governor.h"
+#include "bq25180_sim.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+static void on_decision(enum bq25180_governor_decision decision,
+		uint16_t from_milliampere, uint16_t to_milliampere, void *ctx)
+{
+	mock().actualCall(__func__)
+		.withParameter("decision", decision)
+		.withParameter("from", from_milliampere)
+		.withParameter("to", to_milliampere)
+		.withParameter("ctx", ctx);
+}
+
+TEST_GROUP(BQ25180Governor) {
+	struct bq25180_sim sim;
+	struct bq25180 dev;
+	struct bq25180_governor gov;
+	uint32_t now;
+
+	void setup(void) {
+		struct bq25180_config cfg;
+
+		bq25180_sim_init(&sim, BQ25180_DEVICE_ADDRESS);
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_sim_bus, &sim);
+		bq25180_get_default_config(&cfg);
+		cfg.input_milliampere = 1100;
+		cfg.watchdog = BQ25180_WDT_DISABLE;
+		bq25180_dev_apply_config(&dev, &cfg);
+		bq25180_sim_set_battery(&sim, 3600, 60000);
+		bq25180_sim_set_source(&sim, 5000, 0);
+		/* 75C of headroom over 1.4V of drop: regulating above 535mA */
+		bq25180_sim_set_thermal(&sim, 50, 100);
+
+		now = 0;
+		bq25180_governor_init(&gov, &dev, NULL, NULL, NULL);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void run(uint32_t ms) {
+		for (uint32_t t = 0; t < ms; t += 500) {
+			struct bq25180_state state;
+
+			bq25180_sim_step(&sim, 500);
+			now += 500;
+			LONGS_EQUAL(true,
+				bq25180_dev_read_state(&dev, &state));
+			LONGS_EQUAL(true,
+				bq25180_governor_update(&gov, &state, now));
+		}
+	}
+	struct bq25180_governor_stats stats(void) {
+		struct bq25180_governor_stats s;
+		bq25180_governor_get_stats(&gov, &s);
+		return s;
+	}
+	uint32_t bus_writes(void) {
+		struct bq25180_sim_stats s;
+		bq25180_sim_get_stats(&sim, &s);
+		return s.writes;
+	}
+};
+
+TEST(BQ25180Governor, ShouldStartAtMax) {
+	run(500);
+	LONGS_EQUAL(1000, stats().fastcharge_milliampere);
+	LONGS_EQUAL(127, bq25180_sim_peek(&sim, 0x04) & 0x7f);
+}
+
+TEST(BQ25180Governor, ShouldTrim_WhenThermalRegulationKeepsOn) {
+	run(1500);
+	LONGS_EQUAL(900, stats().fastcharge_milliampere);
+	LONGS_EQUAL(1, stats().trims);
+	LONGS_EQUAL(1000, stats().ceiling_milliampere);
+}
+
+TEST(BQ25180Governor, ShouldSettleJustBelowRegulation) {
+	run(10 * 1000);
+	LONGS_EQUAL(510, stats().fastcharge_milliampere);
+	LONGS_EQUAL(510, bq25180_sim_charge_milliampere(&sim));
+	LONGS_EQUAL(6, stats().trims);
+	LONGS_EQUAL(0, stats().raises);
+
+	/* Steps up in 20mA until it trips at 550mA */
+	run(80 * 1000);
+	LONGS_EQUAL(530, stats().fastcharge_milliampere);
+	LONGS_EQUAL(550, stats().ceiling_milliampere);
+	LONGS_EQUAL(2, stats().raises);
+	LONGS_EQUAL(7, stats().trims);
+}
+
+TEST(BQ25180Governor, ShouldBackOffProbing_WhenProbesKeepFailing) {
+	run(100 * 1000);
+	const uint32_t regulation_ms = stats().regulation_ms;
+
+	/* The first one failed. Then after 60s, 120s, 240s, 480s and 600s */
+	run(30 * 60 * 1000);
+	LONGS_EQUAL(530, stats().fastcharge_milliampere);
+	LONGS_EQUAL(6, stats().failed_probes);
+	LONGS_EQUAL(600000, stats().probe_delay_ms);
+	LONGS_EQUAL(5 * 1000, stats().regulation_ms - regulation_ms);
+}
+
+TEST(BQ25180Governor, ShouldRaiseBackToMax_WhenConditionsImprove) {
+	run(100 * 1000);
+	LONGS_EQUAL(530, stats().fastcharge_milliampere);
+
+	bq25180_sim_set_thermal(&sim, 25, 100);
+	/* The probe to 550mA holds, then 20mA every 30s up to 710mA */
+	run(320 * 1000);
+	LONGS_EQUAL(710, stats().fastcharge_milliampere);
+	LONGS_EQUAL(0, stats().ceiling_milliampere);
+	LONGS_EQUAL(30000, stats().probe_delay_ms);
+}
+
+TEST(BQ25180Governor, ShouldNotWrite_WhenNothingToDo) {
+	bq25180_sim_set_thermal(&sim, 25, 0);
+	run(500);
+	const uint32_t writes = bus_writes();
+
+	run(10 * 60 * 1000);
+	LONGS_EQUAL(writes, bus_writes());
+	LONGS_EQUAL(0, stats().regulation_ms);
+}
+
+TEST(BQ25180Governor, ShouldNotTrim_WhenOnBattery) {
+	run(500);
+	bq25180_sim_set_source(&sim, 0, 0);
+	const uint32_t writes = bus_writes();
+
+	run(60 * 1000);
+	LONGS_EQUAL(writes, bus_writes());
+	LONGS_EQUAL(1000, stats().fastcharge_milliampere);
+}
+
+TEST(BQ25180Governor, ShouldReportDecisions) {
+	int ctx;
+
+	bq25180_governor_init(&gov, &dev, NULL, on_decision, &ctx);
+	mock().expectOneCall("on_decision")
+		.withParameter("decision", BQ25180_GOVERNOR_START)
+		.withParameter("from", 0)
+		.withParameter("to", 1000)
+		.withParameter("ctx", &ctx);
+	mock().expectOneCall("on_decision")
+		.withParameter("decision", BQ25180_GOVERNOR_TRIM)
+		.withParameter("from", 1000)
+		.withParameter("to", 900)
+		.withParameter("ctx", &ctx);
+
+	run(1500);
+}
+
+TEST(BQ25180Governor, ShouldRetry_WhenWriteFails) {
+	struct bq25180_state state;
+
+	run(1000);
+	LONGS_EQUAL(true, bq25180_dev_read_state(&dev, &state));
+	bq25180_sim_inject_nak(&sim, 1);
+	now += 500;
+	LONGS_EQUAL(false, bq25180_governor_update(&gov, &state, now));
+	LONGS_EQUAL(1000, stats().fastcharge_milliampere);
+
+	run(500);
+	LONGS_EQUAL(900, stats().fastcharge_milliampere);
+}
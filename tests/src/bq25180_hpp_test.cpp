@@ -0,0 +1,187 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include <type_traits>
+#include "bq25180.hpp"
+#include "bq25180_sim.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+namespace bq = libmcu::bq25180;
+using namespace bq::literals;
+
+/* Whether the fast charge current is accepted at compile time */
+template <std::uint16_t mA, typename = void>
+struct ichg_ok : std::false_type {};
+template <std::uint16_t mA>
+struct ichg_ok<mA, std::void_t<std::integral_constant<std::uint8_t,
+	bq::encode_fastcharge_current(bq::milliamps{mA})>>>
+	: std::true_type {};
+
+template <std::uint16_t mV, typename = void>
+struct vbat_ok : std::false_type {};
+template <std::uint16_t mV>
+struct vbat_ok<mV, std::void_t<std::integral_constant<std::uint8_t,
+	bq::encode_battery_regulation(bq::millivolts{mV})>>>
+	: std::true_type {};
+
+template <std::uint16_t mA, typename = void>
+struct ilim_ok : std::false_type {};
+template <std::uint16_t mA>
+struct ilim_ok<mA, std::void_t<std::integral_constant<std::uint8_t,
+	bq::encode_input_current(bq::milliamps{mA})>>>
+	: std::true_type {};
+
+static_assert(ichg_ok<5>::value && ichg_ok<35>::value);
+static_assert(!ichg_ok<36>::value && !ichg_ok<39>::value);
+static_assert(ichg_ok<40>::value && ichg_ok<1000>::value);
+static_assert(!ichg_ok<4>::value && !ichg_ok<45>::value);
+static_assert(!ichg_ok<1010>::value);
+static_assert(vbat_ok<3500>::value && vbat_ok<4650>::value);
+static_assert(!vbat_ok<3499>::value && !vbat_ok<4660>::value);
+static_assert(!vbat_ok<4205>::value);
+static_assert(ilim_ok<50>::value && ilim_ok<1100>::value);
+static_assert(!ilim_ok<600>::value && !ilim_ok<1200>::value);
+
+static_assert(bq::encode_fastcharge_current(35_mA) == 30);
+static_assert(bq::encode_fastcharge_current(40_mA) == 31);
+static_assert(bq::encode_fastcharge_current(1000_mA) == 127);
+static_assert(bq::encode_battery_under_voltage(2800_mV) == 3);
+static_assert(bq::encode_termination_current(20_pct) == 3);
+
+TEST_GROUP(BQ25180Hpp) {
+	struct bq25180_sim sim;
+	struct bq25180 dev;
+
+	void setup(void) {
+		bq25180_sim_init(&sim, BQ25180_DEVICE_ADDRESS);
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_sim_bus, &sim);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void read_image(uint8_t image[BQ25180_CONFIG_IMAGE_LEN]) {
+		for (uint8_t i = 0; i < BQ25180_CONFIG_IMAGE_LEN; i++) {
+			image[i] = bq25180_sim_peek(&sim, (uint8_t)(3 + i));
+		}
+	}
+};
+
+TEST(BQ25180Hpp, image_ShouldMatchApplyConfig) {
+	constexpr auto image = bq::config()
+		.charging(false)
+		.battery_regulation(4350_mV)
+		.fastcharge_current(200_mA)
+		.termination_current(5_pct)
+		.double_precharge_current(false)
+		.precharge_threshold(2800_mV)
+		.battery_under_voltage(2400_mV)
+		.discharge_current(BQ25180_BAT_DISCHAGE_1500mA)
+		.input_current(700_mA)
+		.vindpm(BQ25180_VINDPM_4500mV)
+		.dppm(false)
+		.safety_timer(BQ25180_SAFETY_12H)
+		.watchdog(BQ25180_WDT_40_SEC)
+		.sys_source(BQ25180_SYS_SRC_VBAT)
+		.sys_voltage(BQ25180_SYS_REG_V4_8)
+		.thermal_protection(false)
+		.thermistor({ BQ25180_TS_HOT_45C, BQ25180_TS_COLD_5C,
+				true, false, BQ25180_TS_ICHG_20PCT,
+				BQ25180_TS_VBATREG_MINUS_200mV })
+		.push_button(false)
+		.interrupts(BQ25180_INTR_CHARGING_STATUS |
+				BQ25180_INTR_THERMAL_FAULT)
+		.image();
+	struct bq25180_config cfg;
+	uint8_t expected[BQ25180_CONFIG_IMAGE_LEN];
+
+	bq25180_get_default_config(&cfg);
+	cfg.charging_enabled = false;
+	cfg.battery_regulation_millivoltage = 4350;
+	cfg.fastcharge_milliampere = 200;
+	cfg.termination_pct = 5;
+	cfg.double_precharge_current = false;
+	cfg.precharge_threshold_millivoltage = 2800;
+	cfg.battery_undervoltage_millivoltage = 2400;
+	cfg.discharge_current = BQ25180_BAT_DISCHAGE_1500mA;
+	cfg.input_milliampere = 700;
+	cfg.vindpm = BQ25180_VINDPM_4500mV;
+	cfg.dppm_enabled = false;
+	cfg.safety_timer = BQ25180_SAFETY_12H;
+	cfg.watchdog = BQ25180_WDT_40_SEC;
+	cfg.sys_source = BQ25180_SYS_SRC_VBAT;
+	cfg.sys_voltage = BQ25180_SYS_REG_V4_8;
+	cfg.thermal_protection_enabled = false;
+	cfg.ts.hot = BQ25180_TS_HOT_45C;
+	cfg.ts.cold = BQ25180_TS_COLD_5C;
+	cfg.ts.cool_enabled = false;
+	cfg.ts.cool_current = BQ25180_TS_ICHG_20PCT;
+	cfg.ts.warm_voltage = BQ25180_TS_VBATREG_MINUS_200mV;
+	cfg.push_button_enabled = false;
+	cfg.interrupts = BQ25180_INTR_CHARGING_STATUS |
+		BQ25180_INTR_THERMAL_FAULT;
+	LONGS_EQUAL(true, bq25180_dev_apply_config(&dev, &cfg));
+	read_image(expected);
+
+	MEMCMP_EQUAL(expected, image.data(), sizeof(expected));
+}
+
+TEST(BQ25180Hpp, defaults_ShouldMatchDefaultConfig) {
+	constexpr auto image = bq::config().image();
+	uint8_t expected[BQ25180_CONFIG_IMAGE_LEN];
+
+	read_image(expected);
+	MEMCMP_EQUAL(expected, image.data(), sizeof(expected));
+}
+
+TEST(BQ25180Hpp, apply_config_image_ShouldWriteOnlyChangedRegisters) {
+	constexpr auto image = bq::config()
+		.fastcharge_current(500_mA)
+		.input_current(1100_mA)
+		.image();
+	struct bq25180_sim_stats stats;
+
+	LONGS_EQUAL(true, bq25180_dev_apply_config_image(&dev, image.data()));
+
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(1, stats.reads);
+	LONGS_EQUAL(2, stats.writes);
+	LONGS_EQUAL(77, bq25180_sim_peek(&sim, 0x04)); /* 500mA */
+	LONGS_EQUAL(0x4f, bq25180_sim_peek(&sim, 0x08));
+}
+
+TEST(BQ25180Hpp, encode_ShouldRoundDownAtRunTime_WhenNotAConstant) {
+	volatile std::uint16_t mA = 37;
+
+	LONGS_EQUAL(30, bq::encode_fastcharge_current(
+				bq::milliamps{mA}));
+	mA = 650;
+	LONGS_EQUAL(5, bq::encode_input_current(bq::milliamps{mA}));
+	mA = 2000;
+	LONGS_EQUAL(127, bq::encode_fastcharge_current(
+				bq::milliamps{mA}));
+}
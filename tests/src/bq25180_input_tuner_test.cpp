@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include "bq25180_input_tuner.h"
+#include "bq25180_sim.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+TEST_GROUP(BQ25180InputTuner) {
+	struct bq25180_sim sim;
+	struct bq25180 dev;
+	struct bq25180_input_tuner tuner;
+
+	void setup(void) {
+		struct bq25180_config cfg;
+
+		bq25180_sim_init(&sim, BQ25180_DEVICE_ADDRESS);
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_sim_bus, &sim);
+		bq25180_get_default_config(&cfg);
+		cfg.fastcharge_milliampere = 1000;
+		cfg.watchdog = BQ25180_WDT_DISABLE;
+		bq25180_dev_apply_config(&dev, &cfg);
+		bq25180_sim_set_battery(&sim, 3600, 1000);
+		bq25180_sim_set_thermal(&sim, 25, 0);
+
+		bq25180_input_tuner_init(&tuner, &dev, NULL);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void run(int updates) {
+		for (int i = 0; i < updates; i++) {
+			struct bq25180_state state;
+
+			bq25180_sim_step(&sim, 100);
+			LONGS_EQUAL(true,
+				bq25180_dev_read_state(&dev, &state));
+			LONGS_EQUAL(true,
+				bq25180_input_tuner_update(&tuner, &state));
+		}
+	}
+	struct bq25180_input_tuner_result result(void) {
+		struct bq25180_input_tuner_result res;
+		LONGS_EQUAL(true, bq25180_input_tuner_get_result(&tuner, &res));
+		return res;
+	}
+	uint32_t bus_writes(void) {
+		struct bq25180_sim_stats stats;
+		bq25180_sim_get_stats(&sim, &stats);
+		return stats.writes;
+	}
+};
+
+TEST(BQ25180InputTuner, ShouldDoNothing_WhenNoInput) {
+	struct bq25180_input_tuner_result res;
+
+	bq25180_sim_clear_stats(&sim);
+	run(10);
+
+	LONGS_EQUAL(0, bus_writes());
+	LONGS_EQUAL(false, bq25180_input_tuner_get_result(&tuner, &res));
+}
+
+TEST(BQ25180InputTuner, ShouldWriteStartSettings_WhenPluggedIn) {
+	bq25180_sim_set_source(&sim, 5000, 0);
+	run(1);
+
+	LONGS_EQUAL(500, result().input_milliampere);
+	LONGS_EQUAL(BQ25180_VINDPM_4700mV, result().vindpm);
+	LONGS_EQUAL(0x05, bq25180_sim_peek(&sim, 0x08/*TMR_ILIM*/) & 7);
+	LONGS_EQUAL(0x08, bq25180_sim_peek(&sim, 0x05/*CHARGECTRL0*/) & 0x0c);
+}
+
+TEST(BQ25180InputTuner, ShouldClimbToMaximum_WhenAdapterIsStiff) {
+	bq25180_sim_set_source(&sim, 5000, 0);
+	run(20);
+
+	LONGS_EQUAL(1100, result().input_milliampere);
+	LONGS_EQUAL(false, result().limited);
+	LONGS_EQUAL(1000, bq25180_sim_charge_milliampere(&sim));
+	LONGS_EQUAL(2, bq25180_input_tuner_steps(&tuner));
+}
+
+TEST(BQ25180InputTuner, ShouldSettleBelowVindpm_WhenAdapterIsWeak) {
+	/* 1 ohm: 300mA at 4.7V, 500mA at 4.5V and 800mA at 4.2V */
+	bq25180_sim_set_source(&sim, 5000, 1000);
+	run(50);
+
+	LONGS_EQUAL(700, result().input_milliampere);
+	LONGS_EQUAL(BQ25180_VINDPM_4200mV, result().vindpm);
+	LONGS_EQUAL(true, result().limited);
+	LONGS_EQUAL(700, bq25180_sim_input_milliampere(&sim));
+
+	/* and stays there */
+	bq25180_sim_clear_stats(&sim);
+	run(100);
+	LONGS_EQUAL(0, bus_writes());
+	LONGS_EQUAL(700, result().input_milliampere);
+}
+
+TEST(BQ25180InputTuner, ShouldOutperformStaticSettings_WhenAdapterIsWeak) {
+	uint16_t tuned;
+
+	bq25180_sim_set_source(&sim, 5000, 1000);
+	run(50);
+	tuned = bq25180_sim_charge_milliampere(&sim);
+
+	/* What the start settings would give if left as they are */
+	bq25180_dev_set_input_current(&dev, 500);
+	bq25180_dev_enable_vindpm(&dev, BQ25180_VINDPM_4700mV);
+	bq25180_sim_step(&sim, 100);
+
+	CHECK(tuned > bq25180_sim_charge_milliampere(&sim) * 2);
+}
+
+TEST(BQ25180InputTuner, ShouldStartOver_WhenReplugged) {
+	bq25180_sim_set_source(&sim, 5000, 1000);
+	run(50);
+
+	bq25180_sim_set_source(&sim, 0, 0);
+	run(1);
+	bq25180_sim_set_source(&sim, 5000, 0);
+	run(20);
+
+	LONGS_EQUAL(1100, result().input_milliampere);
+	LONGS_EQUAL(BQ25180_VINDPM_4700mV, result().vindpm);
+}
+
+TEST(BQ25180InputTuner, get_result_ShouldKeepLastSession_WhenUnplugged) {
+	bq25180_sim_set_source(&sim, 5000, 1000);
+	run(50);
+
+	bq25180_sim_set_source(&sim, 0, 0);
+	run(1);
+
+	LONGS_EQUAL(700, result().input_milliampere);
+	LONGS_EQUAL(BQ25180_VINDPM_4200mV, result().vindpm);
+	LONGS_EQUAL(true, result().limited);
+}
+
+TEST(BQ25180InputTuner, ShouldWaitForUpSamples_BeforeSteppingUp) {
+	bq25180_sim_set_source(&sim, 5000, 0);
+	run(3);
+	LONGS_EQUAL(500, result().input_milliampere);
+	run(1);
+	LONGS_EQUAL(700, result().input_milliampere);
+}
+
+TEST(BQ25180InputTuner, update_ShouldRetry_WhenWriteFailed) {
+	struct bq25180_state state;
+
+	bq25180_sim_set_source(&sim, 5000, 0);
+	bq25180_sim_step(&sim, 100);
+	bq25180_dev_read_state(&dev, &state);
+
+	bq25180_sim_inject_nak(&sim, 1);
+	LONGS_EQUAL(false, bq25180_input_tuner_update(&tuner, &state));
+	LONGS_EQUAL(true, bq25180_input_tuner_update(&tuner, &state));
+	LONGS_EQUAL(500, result().input_milliampere);
+}
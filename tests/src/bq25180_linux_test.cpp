@@ -0,0 +1,252 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <errno.h>
+#include <string.h>
+#include <linux/i2c-dev.h>
+#include "bq25180_linux.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+#define FAKE_FD				3
+
+/* Fake file descriptor layer acting as an adapter with a single device */
+static struct {
+	uint8_t regs[BQ25180_NR_REGISTERS];
+	unsigned long funcs;
+	int ioctls;
+	int msgs;
+	int err;
+	int fails; /* ioctls to fail with EIO before going through */
+} adapter;
+
+static int fake_open(const char *path, int flags) {
+	return mock().actualCall(__func__)
+		.withParameter("path", path)
+		.returnIntValueOrDefault(FAKE_FD);
+}
+
+static int fake_close(int fd) {
+	return mock().actualCall(__func__)
+		.withParameter("fd", fd)
+		.returnIntValueOrDefault(0);
+}
+
+static int fake_rdwr(struct i2c_rdwr_ioctl_data *data) {
+	uint8_t reg = 0;
+
+	adapter.ioctls++;
+	adapter.msgs += (int)data->nmsgs;
+
+	if (adapter.err) {
+		errno = adapter.err;
+		return -1;
+	}
+	if (adapter.fails) {
+		adapter.fails--;
+		errno = EIO;
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < data->nmsgs; i++) {
+		struct i2c_msg *msg = &data->msgs[i];
+
+		LONGS_EQUAL(BQ25180_DEVICE_ADDRESS, msg->addr);
+
+		if (msg->flags & I2C_M_RD) {
+			memcpy(msg->buf, &adapter.regs[reg], msg->len);
+		} else {
+			reg = msg->buf[0];
+			memcpy(&adapter.regs[reg], &msg->buf[1],
+					msg->len - 1U);
+		}
+	}
+
+	return (int)data->nmsgs;
+}
+
+static int fake_ioctl(int fd, unsigned long request, void *arg) {
+	LONGS_EQUAL(FAKE_FD, fd);
+
+	switch (request) {
+	case I2C_FUNCS:
+		*(unsigned long *)arg = adapter.funcs;
+		return 0;
+	case I2C_RDWR:
+		return fake_rdwr((struct i2c_rdwr_ioctl_data *)arg);
+	default:
+		FAIL("unexpected ioctl");
+		return -1;
+	}
+}
+
+static const struct bq25180_linux_sys fake_sys = {
+	.open = fake_open,
+	.close = fake_close,
+	.ioctl = fake_ioctl,
+};
+
+TEST_GROUP(BQ25180Linux) {
+	struct bq25180_linux port;
+	struct bq25180 dev;
+
+	void setup(void) {
+		memset(&adapter, 0, sizeof(adapter));
+		adapter.funcs = I2C_FUNC_I2C;
+		adapter.regs[0x04/*ICHG_CTRL*/] = 0x05;
+
+		mock().expectOneCall("fake_open")
+			.withParameter("path", "/dev/i2c-1");
+		LONGS_EQUAL(0, bq25180_linux_open(&port, "/dev/i2c-1",
+					&fake_sys));
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_linux_bus, &port);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+};
+
+TEST(BQ25180Linux, open_ShouldFail_WhenAdapterLacksPlainI2c) {
+	struct bq25180_linux stub;
+	adapter.funcs = I2C_FUNC_SMBUS_BYTE_DATA;
+
+	mock().expectOneCall("fake_open").withParameter("path", "/dev/i2c-9");
+	mock().expectOneCall("fake_close").withParameter("fd", FAKE_FD);
+	LONGS_EQUAL(-EOPNOTSUPP, bq25180_linux_open(&stub, "/dev/i2c-9",
+				&fake_sys));
+}
+
+TEST(BQ25180Linux, read_ShouldTakeSingleCombinedTransfer) {
+	struct bq25180_state state;
+	adapter.regs[0x00/*STAT0*/] = 0x60;
+
+	LONGS_EQUAL(true, bq25180_dev_read_snapshot(&dev, &state, NULL));
+	LONGS_EQUAL(1, adapter.ioctls);
+	LONGS_EQUAL(2, adapter.msgs);
+	LONGS_EQUAL(3, state.charging_status);
+}
+
+TEST(BQ25180Linux, setter_ShouldTakeOneIoctlPerTransaction) {
+	LONGS_EQUAL(true, bq25180_dev_enable_battery_charging(&dev, false));
+	LONGS_EQUAL(2, adapter.ioctls);
+	LONGS_EQUAL(0x85, adapter.regs[0x04/*ICHG_CTRL*/]);
+}
+
+TEST(BQ25180Linux, burst_ShouldGoInSingleMessage) {
+	struct bq25180_config cfg;
+	bq25180_get_default_config(&cfg);
+	bq25180_dev_enable_cache(&dev, false);
+	cfg.input_milliampere = 500;
+	cfg.fastcharge_milliampere = 100;
+
+	LONGS_EQUAL(true, bq25180_dev_apply_config(&dev, &cfg));
+	LONGS_EQUAL(1, adapter.ioctls);
+	LONGS_EQUAL(1, adapter.msgs);
+}
+
+TEST(BQ25180Linux, write_ShouldSendPointerOnly_WhenNoData) {
+	LONGS_EQUAL(0, bq25180_linux_bus.write(&port, BQ25180_DEVICE_ADDRESS,
+				0x01, NULL, 0));
+	LONGS_EQUAL(1, adapter.ioctls);
+	LONGS_EQUAL(1, adapter.msgs);
+}
+
+TEST(BQ25180Linux, batch_ShouldGoAlongWithNextRead) {
+	struct bq25180_state state;
+	bq25180_dev_enable_cache(&dev, false);
+
+	bq25180_linux_begin_batch(&port);
+	bq25180_dev_enable_battery_charging(&dev, false);
+	bq25180_dev_enable_dppm(&dev, false);
+	LONGS_EQUAL(0, adapter.ioctls);
+
+	bq25180_dev_read_snapshot(&dev, &state, NULL);
+	LONGS_EQUAL(1, adapter.ioctls);
+	LONGS_EQUAL(4, adapter.msgs);
+	LONGS_EQUAL(0x85, adapter.regs[0x04/*ICHG_CTRL*/]);
+	LONGS_EQUAL(0, bq25180_linux_end_batch(&port));
+	LONGS_EQUAL(1, adapter.ioctls);
+}
+
+TEST(BQ25180Linux, batch_ShouldBeFlushedOnEnd) {
+	bq25180_dev_enable_cache(&dev, false);
+
+	bq25180_linux_begin_batch(&port);
+	for (int i = 0; i < BQ25180_LINUX_BATCH_LEN + 1; i++) {
+		bq25180_dev_enable_battery_charging(&dev, i & 1);
+	}
+	LONGS_EQUAL(1, adapter.ioctls);
+	LONGS_EQUAL(0, bq25180_linux_end_batch(&port));
+	LONGS_EQUAL(2, adapter.ioctls);
+	LONGS_EQUAL(BQ25180_LINUX_BATCH_LEN + 1, adapter.msgs);
+}
+
+TEST(BQ25180Linux, batch_ShouldGoAgainWithRetriedRead_WhenTransferFails) {
+	const struct bq25180_retry_policy retry = { .max_retries = 1, };
+	struct bq25180_state state;
+	bq25180_dev_enable_cache(&dev, false);
+	bq25180_dev_set_retry_policy(&dev, &retry);
+
+	bq25180_linux_begin_batch(&port);
+	bq25180_dev_enable_battery_charging(&dev, false);
+	adapter.fails = 1;
+
+	LONGS_EQUAL(true, bq25180_dev_read_snapshot(&dev, &state, NULL));
+	LONGS_EQUAL(2, adapter.ioctls);
+	LONGS_EQUAL(6, adapter.msgs);
+	LONGS_EQUAL(0x85, adapter.regs[0x04/*ICHG_CTRL*/]);
+	LONGS_EQUAL(0, bq25180_linux_end_batch(&port));
+	LONGS_EQUAL(2, adapter.ioctls);
+}
+
+TEST(BQ25180Linux, end_batch_ShouldKeepWrites_WhenTransferFails) {
+	bq25180_dev_enable_cache(&dev, false);
+
+	bq25180_linux_begin_batch(&port);
+	bq25180_dev_enable_battery_charging(&dev, false);
+	adapter.fails = 1;
+	LONGS_EQUAL(-EIO, bq25180_linux_end_batch(&port));
+	LONGS_EQUAL(0x05, adapter.regs[0x04/*ICHG_CTRL*/]);
+
+	LONGS_EQUAL(0, bq25180_linux_end_batch(&port));
+	LONGS_EQUAL(0x85, adapter.regs[0x04/*ICHG_CTRL*/]);
+}
+
+TEST(BQ25180Linux, ShouldReturnErrno_WhenTransferFails) {
+	adapter.err = EREMOTEIO;
+
+	LONGS_EQUAL(false, bq25180_dev_enable_battery_charging(&dev, false));
+	LONGS_EQUAL(1, adapter.ioctls);
+
+	bq25180_linux_begin_batch(&port);
+	bq25180_dev_enable_cache(&dev, false);
+	bq25180_dev_enable_dppm(&dev, false);
+	LONGS_EQUAL(-EREMOTEIO, bq25180_linux_end_batch(&port));
+}
+
+TEST(BQ25180Linux, close_ShouldReleaseFd) {
+	mock().expectOneCall("fake_close").withParameter("fd", FAKE_FD);
+	bq25180_linux_close(&port);
+}
@@ -0,0 +1,194 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include "bq25180_poll.h"
+#include "bq25180_sim.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+struct report {
+	int count;
+	uint16_t changed;
+	bool event;
+	struct bq25180_state state;
+};
+
+static void on_change(const struct bq25180_state *state, uint16_t changed,
+		const struct bq25180_event *event, void *ctx) {
+	struct report *report = (struct report *)ctx;
+
+	report->count++;
+	report->changed = changed;
+	report->event = event != NULL;
+	report->state = *state;
+}
+
+TEST_GROUP(BQ25180Poll) {
+	struct bq25180_sim sim;
+	struct bq25180 dev;
+	struct bq25180_poll poll;
+	struct report report;
+
+	void setup(void) {
+		bq25180_sim_init(&sim, BQ25180_DEVICE_ADDRESS);
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_sim_bus, &sim);
+		memset(&report, 0, sizeof(report));
+		bq25180_poll_init(&poll, &dev, NULL, on_change, &report);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void plug(void) {
+		bq25180_sim_set_source(&sim, 5000, 100);
+		bq25180_sim_step(&sim, 10);
+	}
+	uint32_t bus_reads(void) {
+		struct bq25180_sim_stats stats;
+		bq25180_sim_get_stats(&sim, &stats);
+		return stats.reads;
+	}
+};
+
+TEST(BQ25180Poll, run_ShouldReportEverything_WhenFirstPolled) {
+	LONGS_EQUAL(0, bq25180_poll_time_to_deadline(&poll, 0));
+	LONGS_EQUAL(true, bq25180_poll_run(&poll, 0));
+	LONGS_EQUAL(1, report.count);
+	LONGS_EQUAL(BQ25180_CHANGE_ALL, report.changed);
+	LONGS_EQUAL(false, report.event);
+}
+
+TEST(BQ25180Poll, run_ShouldNotTouchTheBus_WhenNotDue) {
+	bq25180_poll_run(&poll, 0);
+	bq25180_sim_clear_stats(&sim);
+
+	LONGS_EQUAL(true, bq25180_poll_run(&poll, 9999));
+	LONGS_EQUAL(0, bus_reads());
+	LONGS_EQUAL(1, report.count);
+}
+
+TEST(BQ25180Poll, run_ShouldNotReport_WhenNothingChanged) {
+	bq25180_poll_run(&poll, 0);
+	bq25180_sim_clear_stats(&sim);
+
+	LONGS_EQUAL(true, bq25180_poll_run(&poll, 10000));
+	LONGS_EQUAL(1, bus_reads());
+	LONGS_EQUAL(1, report.count);
+}
+
+TEST(BQ25180Poll, run_ShouldPollSlowly_WhenOnBattery) {
+	bq25180_poll_run(&poll, 0);
+	LONGS_EQUAL(10000, bq25180_poll_next_deadline(&poll));
+	LONGS_EQUAL(10000, bq25180_poll_time_to_deadline(&poll, 0));
+	LONGS_EQUAL(1, bq25180_poll_time_to_deadline(&poll, 9999));
+	LONGS_EQUAL(0, bq25180_poll_time_to_deadline(&poll, 10001));
+}
+
+TEST(BQ25180Poll, run_ShouldReportOnlyChanges_WhenPluggedIn) {
+	bq25180_poll_run(&poll, 0);
+	plug();
+	bq25180_poll_kick(&poll, 10);
+	bq25180_poll_run(&poll, 10);
+
+	LONGS_EQUAL(2, report.count);
+	LONGS_EQUAL(BQ25180_CHANGE_VIN_GOOD | BQ25180_CHANGE_CHARGING_STATUS,
+			report.changed);
+	LONGS_EQUAL(true, report.state.vin_good);
+	/* Charging just started */
+	LONGS_EQUAL(110, bq25180_poll_next_deadline(&poll));
+
+	bq25180_poll_run(&poll, 110);
+	LONGS_EQUAL(2, report.count);
+	LONGS_EQUAL(1110, bq25180_poll_next_deadline(&poll));
+}
+
+TEST(BQ25180Poll, run_ShouldPollFast_WhenInputCurrentLimited) {
+	plug();
+	bq25180_poll_run(&poll, 0);
+	LONGS_EQUAL(1000, bq25180_poll_next_deadline(&poll));
+
+	bq25180_sim_set_sys_load(&sim, 600);
+	bq25180_sim_step(&sim, 10);
+	bq25180_poll_run(&poll, 1000);
+
+	LONGS_EQUAL(BQ25180_CHANGE_ILIM, report.changed);
+	LONGS_EQUAL(1100, bq25180_poll_next_deadline(&poll));
+	bq25180_poll_run(&poll, 1100);
+	LONGS_EQUAL(1200, bq25180_poll_next_deadline(&poll));
+}
+
+TEST(BQ25180Poll, run_ShouldHandleWrapAround) {
+	const uint32_t start = 0xffffff00u;
+
+	bq25180_poll_run(&poll, start);
+	LONGS_EQUAL(start + 10000u, bq25180_poll_next_deadline(&poll));
+	LONGS_EQUAL(10000, bq25180_poll_time_to_deadline(&poll, start));
+
+	bq25180_sim_clear_stats(&sim);
+	bq25180_poll_run(&poll, 0x1000);
+	LONGS_EQUAL(0, bus_reads());
+	bq25180_poll_run(&poll, start + 10000u);
+	LONGS_EQUAL(1, bus_reads());
+}
+
+TEST(BQ25180Poll, kick_ShouldMakePollDue) {
+	bq25180_poll_run(&poll, 0);
+	bq25180_poll_kick(&poll, 500);
+	LONGS_EQUAL(0, bq25180_poll_time_to_deadline(&poll, 500));
+
+	bq25180_sim_clear_stats(&sim);
+	bq25180_poll_run(&poll, 500);
+	LONGS_EQUAL(1, bus_reads());
+}
+
+TEST(BQ25180Poll, run_ShouldReportEvents_WhenReadEventsEnabled) {
+	struct bq25180_poll_config cfg;
+
+	bq25180_poll_get_default_config(&cfg);
+	cfg.read_events = true;
+	bq25180_poll_init(&poll, &dev, &cfg, on_change, &report);
+	bq25180_poll_run(&poll, 0);
+
+	bq25180_sim_set_battery(&sim, 2000, 100);
+	bq25180_sim_step(&sim, 10);
+	bq25180_poll_run(&poll, 10000);
+
+	LONGS_EQUAL(2, report.count);
+	LONGS_EQUAL(true, report.event);
+	LONGS_EQUAL(0, bq25180_sim_peek(&sim, 0x02));
+}
+
+TEST(BQ25180Poll, run_ShouldRetryFast_WhenReadFailed) {
+	bq25180_sim_inject_nak(&sim, 1);
+
+	LONGS_EQUAL(false, bq25180_poll_run(&poll, 0));
+	LONGS_EQUAL(0, report.count);
+	LONGS_EQUAL(100, bq25180_poll_next_deadline(&poll));
+
+	LONGS_EQUAL(true, bq25180_poll_run(&poll, 100));
+	LONGS_EQUAL(1, report.count);
+	LONGS_EQUAL(BQ25180_CHANGE_ALL, report.changed);
+}
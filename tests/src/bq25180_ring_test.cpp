@@ -0,0 +1,179 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include <thread>
+#include "bq25180_ring.h"
+#include "bq25180_sim.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+TEST_GROUP(BQ25180Ring) {
+	struct bq25180_sim sim;
+	struct bq25180 dev;
+	struct bq25180_ring ring;
+
+	void setup(void) {
+		bq25180_sim_init(&sim, BQ25180_DEVICE_ADDRESS);
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_sim_bus, &sim);
+		bq25180_ring_init(&ring);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	bool push(uint32_t timestamp) {
+		struct bq25180_ring_record record;
+		memset(&record, 0, sizeof(record));
+		record.timestamp = timestamp;
+		return bq25180_ring_push(&ring, &record);
+	}
+};
+
+TEST(BQ25180Ring, pop_ShouldReturnFalse_WhenEmpty) {
+	struct bq25180_ring_record record;
+
+	LONGS_EQUAL(0, bq25180_ring_count(&ring));
+	LONGS_EQUAL(false, bq25180_ring_pop(&ring, &record));
+}
+
+TEST(BQ25180Ring, pop_ShouldReturnRecordsInOrder) {
+	struct bq25180_ring_record record;
+
+	push(10);
+	push(20);
+	LONGS_EQUAL(2, bq25180_ring_count(&ring));
+
+	LONGS_EQUAL(true, bq25180_ring_pop(&ring, &record));
+	LONGS_EQUAL(10, record.timestamp);
+	LONGS_EQUAL(true, bq25180_ring_pop(&ring, &record));
+	LONGS_EQUAL(20, record.timestamp);
+	LONGS_EQUAL(false, bq25180_ring_pop(&ring, &record));
+}
+
+TEST(BQ25180Ring, push_ShouldDropAndCountNewRecords_WhenFull) {
+	struct bq25180_ring_record record;
+
+	for (uint32_t i = 0; i < BQ25180_RING_LEN; i++) {
+		LONGS_EQUAL(true, push(i));
+	}
+	LONGS_EQUAL(false, push(100));
+	LONGS_EQUAL(false, push(101));
+
+	LONGS_EQUAL(BQ25180_RING_LEN, bq25180_ring_count(&ring));
+	LONGS_EQUAL(2, bq25180_ring_overflows(&ring));
+	bq25180_ring_pop(&ring, &record);
+	LONGS_EQUAL(0, record.timestamp);
+	LONGS_EQUAL(true, push(102));
+}
+
+TEST(BQ25180Ring, ShouldKeepWorking_WhenIndicesWrapAround) {
+	struct bq25180_ring_record record;
+
+	ring.head = ring.tail = 0xfffffffeu;
+
+	for (uint32_t i = 0; i < BQ25180_RING_LEN; i++) {
+		LONGS_EQUAL(true, push(i));
+	}
+	LONGS_EQUAL(false, push(100));
+	LONGS_EQUAL(BQ25180_RING_LEN, bq25180_ring_count(&ring));
+
+	for (uint32_t i = 0; i < BQ25180_RING_LEN; i++) {
+		LONGS_EQUAL(true, bq25180_ring_pop(&ring, &record));
+		LONGS_EQUAL(i, record.timestamp);
+	}
+	LONGS_EQUAL(0, bq25180_ring_count(&ring));
+}
+
+TEST(BQ25180Ring, capture_ShouldKeepEvents_WhenFlagClearedOnRead) {
+	struct bq25180_ring_record record;
+
+	bq25180_sim_set_battery(&sim, 2000, 100);
+	bq25180_sim_step(&sim, 10);
+
+	LONGS_EQUAL(true, bq25180_ring_capture(&ring, &dev, 1234));
+	LONGS_EQUAL(0, bq25180_sim_peek(&sim, 0x02));
+
+	LONGS_EQUAL(true, bq25180_ring_pop(&ring, &record));
+	LONGS_EQUAL(1234, record.timestamp);
+	LONGS_EQUAL(true, record.event.battery_undervoltage);
+	LONGS_EQUAL(true, record.state.battery_undervoltage_active);
+}
+
+TEST(BQ25180Ring, capture_ShouldLeaveEventsLatched_WhenFull) {
+	struct bq25180_ring_record record;
+
+	for (uint32_t i = 0; i < BQ25180_RING_LEN; i++) {
+		push(i);
+	}
+	bq25180_sim_set_battery(&sim, 2000, 100);
+	bq25180_sim_step(&sim, 10);
+
+	LONGS_EQUAL(false, bq25180_ring_capture(&ring, &dev, 1234));
+	LONGS_EQUAL(1, bq25180_ring_overflows(&ring));
+	CHECK(bq25180_sim_peek(&sim, 0x02/*FLAG0*/) != 0);
+
+	bq25180_ring_pop(&ring, &record);
+	LONGS_EQUAL(true, bq25180_ring_capture(&ring, &dev, 5678));
+	while (bq25180_ring_pop(&ring, &record)) {
+	}
+	LONGS_EQUAL(5678, record.timestamp);
+	LONGS_EQUAL(true, record.event.battery_undervoltage);
+}
+
+TEST(BQ25180Ring, capture_ShouldReturnFalse_WhenBusFailed) {
+	bq25180_sim_inject_nak(&sim, 1);
+
+	LONGS_EQUAL(false, bq25180_ring_capture(&ring, &dev, 0));
+	LONGS_EQUAL(0, bq25180_ring_count(&ring));
+	LONGS_EQUAL(0, bq25180_ring_overflows(&ring));
+}
+
+TEST(BQ25180Ring, ShouldNeitherLoseNorDuplicate_WhenRunConcurrently) {
+	const uint32_t n = 100000;
+	uint32_t expected = 0;
+	uint32_t popped = 0;
+
+	std::thread producer([&]() {
+		for (uint32_t i = 0; i < n; i++) {
+			push(i);
+		}
+	});
+
+	while (popped + bq25180_ring_overflows(&ring) < n) {
+		struct bq25180_ring_record record;
+		if (!bq25180_ring_pop(&ring, &record)) {
+			continue;
+		}
+		/* Strictly increasing: dropped ones leave gaps only */
+		CHECK(record.timestamp >= expected);
+		expected = record.timestamp + 1;
+		popped++;
+	}
+
+	producer.join();
+	LONGS_EQUAL(n, popped + bq25180_ring_overflows(&ring));
+	LONGS_EQUAL(0, bq25180_ring_count(&ring));
+}
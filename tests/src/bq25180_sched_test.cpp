@@ -0,0 +1,288 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include "bq25180_sched.h"
+#include "bq25180_sim.h"
+#include "bq25180_sim_clock.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+static struct bq25180_sim sim;
+static struct bq25180_sim_clock bus_clock;
+static struct bq25180_sched sched;
+static struct bq25180_sched_port port;
+static struct bq25180 dev;
+
+static int order[16];
+static int nr_order;
+
+static bool read_state(struct bq25180 *p, void *ctx) {
+	struct bq25180_state state;
+
+	order[nr_order++] = *(int *)ctx;
+
+	return bq25180_dev_read_snapshot(p, &state, NULL);
+}
+
+static bool dump(struct bq25180 *p, void *ctx) {
+	struct bq25180_dump regs;
+
+	order[nr_order++] = *(int *)ctx;
+
+	return bq25180_dev_dump(p, &regs);
+}
+
+static bool set_ichg(struct bq25180 *p, void *ctx) {
+	order[nr_order++] = 1;
+
+	return bq25180_dev_set_fastcharge_current(p, *(uint16_t *)ctx);
+}
+
+static uint8_t ichg_seen;
+static bool peek_ichg(struct bq25180 *p, void *ctx) {
+	(void)p;
+	order[nr_order++] = *(int *)ctx;
+	ichg_seen = bq25180_sim_peek(&sim, 0x04/*ICHG_CTRL*/);
+	return true;
+}
+
+/* The interrupt line asserted during the first transaction of a job */
+static struct bq25180_sched_job irq_job;
+static void raise_irq(void *ctx) {
+	(void)ctx;
+	bq25180_sim_clock_set_transfer_handler(&bus_clock, NULL, NULL);
+	bq25180_sched_submit(&sched, &irq_job, BQ25180_SCHED_PRIO_STATUS);
+}
+
+static int resubmissions;
+static void resubmit(struct bq25180_sched_job *job) {
+	if (resubmissions-- > 0) {
+		bq25180_sched_submit(&sched, job,
+				BQ25180_SCHED_PRIO_BACKGROUND);
+	}
+}
+
+TEST_GROUP(BQ25180Sched) {
+	int id[8];
+
+	void setup(void) {
+		bq25180_sim_init(&sim, BQ25180_DEVICE_ADDRESS);
+		bq25180_sim_clock_init(&bus_clock, 400000,
+				&bq25180_sim_bus, &sim);
+		bq25180_sched_init(&sched, bq25180_sim_clock_now, &bus_clock);
+		port = (struct bq25180_sched_port) {
+			.sched = &sched,
+			.bus = &bq25180_sim_clock_bus,
+			.bus_ctx = &bus_clock,
+		};
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_sched_bus, &port);
+
+		for (int i = 0; i < 8; i++) {
+			id[i] = i;
+		}
+
+		memset(&irq_job, 0, sizeof(irq_job));
+		nr_order = 0;
+		resubmissions = 0;
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	struct bq25180_sched_job job(bq25180_sched_op_t op, int i) {
+		return (struct bq25180_sched_job) {
+			.dev = &dev,
+			.op = op,
+			.ctx = &id[i],
+		};
+	}
+	struct bq25180_sched_stats stats(enum bq25180_sched_prio prio) {
+		struct bq25180_sched_stats s;
+		bq25180_sched_get_stats(&sched, prio, &s);
+		return s;
+	}
+};
+
+TEST(BQ25180Sched, run_ShouldRunHigherPriorityFirst) {
+	struct bq25180_sched_job jobs[] = {
+		job(dump, 2), job(read_state, 1), job(read_state, 0),
+		job(dump, 3),
+	};
+	const int expected[] = { 0, 1, 2, 3 };
+
+	bq25180_sched_submit(&sched, &jobs[0], BQ25180_SCHED_PRIO_BACKGROUND);
+	bq25180_sched_submit(&sched, &jobs[1], BQ25180_SCHED_PRIO_CONFIG);
+	bq25180_sched_submit(&sched, &jobs[2], BQ25180_SCHED_PRIO_STATUS);
+	bq25180_sched_submit(&sched, &jobs[3], BQ25180_SCHED_PRIO_BACKGROUND);
+	LONGS_EQUAL(4, bq25180_sched_pending(&sched));
+
+	LONGS_EQUAL(4, bq25180_sched_run(&sched));
+
+	MEMCMP_EQUAL(expected, order, sizeof(expected));
+	LONGS_EQUAL(0, bq25180_sched_pending(&sched));
+	LONGS_EQUAL(true, jobs[3].ok);
+}
+
+TEST(BQ25180Sched, run_next_ShouldReturnFalse_WhenNothingQueued) {
+	LONGS_EQUAL(false, bq25180_sched_run_next(&sched));
+	LONGS_EQUAL(0, bq25180_sched_run(&sched));
+}
+
+TEST(BQ25180Sched, submit_ShouldReturnFalse_WhenQueuedAlready) {
+	struct bq25180_sched_job j = job(read_state, 0);
+
+	LONGS_EQUAL(true, bq25180_sched_submit(&sched, &j,
+				BQ25180_SCHED_PRIO_STATUS));
+	LONGS_EQUAL(false, bq25180_sched_submit(&sched, &j,
+				BQ25180_SCHED_PRIO_BACKGROUND));
+	LONGS_EQUAL(1, bq25180_sched_run(&sched));
+
+	LONGS_EQUAL(true, bq25180_sched_submit(&sched, &j,
+				BQ25180_SCHED_PRIO_STATUS));
+}
+
+TEST(BQ25180Sched, ShouldKeepReadModifyWriteWhole_WhenStatusRequested) {
+	uint16_t ma = 500;
+	struct bq25180_sched_job config = {
+		.dev = &dev, .op = set_ichg, .ctx = &ma,
+	};
+	const int expected[] = { 1, 0 };
+
+	irq_job = job(peek_ichg, 0);
+	bq25180_sim_clock_set_transfer_handler(&bus_clock, raise_irq, NULL);
+	bq25180_sched_submit(&sched, &config, BQ25180_SCHED_PRIO_CONFIG);
+
+	LONGS_EQUAL(2, bq25180_sched_run(&sched));
+
+	MEMCMP_EQUAL(expected, order, sizeof(expected));
+	/* The status job saw the write done, not the read alone */
+	LONGS_EQUAL(77, ichg_seen);
+	LONGS_EQUAL(2, stats(BQ25180_SCHED_PRIO_CONFIG).transfers);
+	/* It waited for the write of the config job, give or take the
+	 * rounding of the clock */
+	const uint32_t write_us =
+		bq25180_sim_clock_transfer_us(&bus_clock, false, 1);
+	CHECK(stats(BQ25180_SCHED_PRIO_STATUS).max_wait >= write_us);
+	CHECK(stats(BQ25180_SCHED_PRIO_STATUS).max_wait <= write_us + 1);
+}
+
+TEST(BQ25180Sched, statusLatency_ShouldBeBoundedByOneJob_WhenBacklogged) {
+	struct bq25180_sched_job jobs[6];
+	const uint32_t dump_us = bq25180_sim_clock_transfer_us(&bus_clock,
+			true, BQ25180_NR_REGISTERS);
+
+	for (int i = 0; i < 6; i++) {
+		jobs[i] = job(dump, i + 1);
+		bq25180_sched_submit(&sched, &jobs[i],
+				BQ25180_SCHED_PRIO_BACKGROUND);
+	}
+	irq_job = job(read_state, 0);
+	bq25180_sim_clock_set_transfer_handler(&bus_clock, raise_irq, NULL);
+
+	LONGS_EQUAL(7, bq25180_sched_run(&sched));
+
+	/* Served right after the dump in progress, ahead of the backlog */
+	LONGS_EQUAL(1, order[0]);
+	LONGS_EQUAL(0, order[1]);
+	CHECK(stats(BQ25180_SCHED_PRIO_STATUS).max_wait <= dump_us);
+	CHECK(stats(BQ25180_SCHED_PRIO_BACKGROUND).max_wait >= 5 * dump_us);
+	LONGS_EQUAL(6, stats(BQ25180_SCHED_PRIO_BACKGROUND).max_pending);
+	LONGS_EQUAL(6, stats(BQ25180_SCHED_PRIO_BACKGROUND).completed);
+}
+
+TEST(BQ25180Sched, stats_ShouldAccountLatencyAndBusTime) {
+	struct bq25180_sched_job jobs[] = {
+		job(read_state, 0), job(read_state, 1),
+	};
+	const uint32_t us = bq25180_sim_clock_transfer_us(&bus_clock, true, 2);
+	struct bq25180_sched_stats s;
+
+	bq25180_sched_submit(&sched, &jobs[0], BQ25180_SCHED_PRIO_STATUS);
+	bq25180_sched_submit(&sched, &jobs[1], BQ25180_SCHED_PRIO_STATUS);
+	bq25180_sim_clock_advance(&bus_clock, 1000);
+	bq25180_sched_run(&sched);
+
+	s = stats(BQ25180_SCHED_PRIO_STATUS);
+	LONGS_EQUAL(2, s.completed);
+	LONGS_EQUAL(2, s.transfers);
+	LONGS_EQUAL(1000 + us, s.max_wait);
+	LONGS_EQUAL(1000 + 1000 + us, s.total_wait);
+	CHECK(s.busy >= 2 * us && s.busy <= 2 * us + 1);
+	LONGS_EQUAL(2, s.max_pending);
+	LONGS_EQUAL(0, s.pending);
+}
+
+TEST(BQ25180Sched, stats_ShouldCountFailures) {
+	struct bq25180_sched_job j = job(read_state, 0);
+
+	bq25180_sim_inject_nak(&sim, 1);
+	bq25180_sched_submit(&sched, &j, BQ25180_SCHED_PRIO_STATUS);
+	bq25180_sched_run(&sched);
+
+	LONGS_EQUAL(false, j.ok);
+	LONGS_EQUAL(1, stats(BQ25180_SCHED_PRIO_STATUS).failed);
+	LONGS_EQUAL(0, stats(BQ25180_SCHED_PRIO_STATUS).completed);
+}
+
+TEST(BQ25180Sched, run_ShouldRunJobsSubmittedFromCallback) {
+	struct bq25180_sched_job j = job(read_state, 0);
+
+	j.done = resubmit;
+	resubmissions = 2;
+	bq25180_sched_submit(&sched, &j, BQ25180_SCHED_PRIO_BACKGROUND);
+
+	LONGS_EQUAL(3, bq25180_sched_run(&sched));
+	LONGS_EQUAL(3, stats(BQ25180_SCHED_PRIO_BACKGROUND).completed);
+}
+
+TEST(BQ25180Sched, ShouldCountUnscheduledTransfers_WhenBusUsedDirectly) {
+	struct bq25180_state state;
+
+	LONGS_EQUAL(true, bq25180_dev_read_snapshot(&dev, &state, NULL));
+
+	LONGS_EQUAL(1, bq25180_sched_get_unscheduled(&sched));
+	LONGS_EQUAL(0, stats(BQ25180_SCHED_PRIO_STATUS).transfers);
+}
+
+TEST(BQ25180Sched, clear_stats_ShouldKeepJobsQueued) {
+	struct bq25180_sched_job jobs[] = {
+		job(read_state, 0), job(read_state, 1),
+	};
+	struct bq25180_state state;
+
+	bq25180_dev_read_snapshot(&dev, &state, NULL);
+	bq25180_sched_submit(&sched, &jobs[0], BQ25180_SCHED_PRIO_CONFIG);
+	bq25180_sched_run(&sched);
+	bq25180_sched_submit(&sched, &jobs[1], BQ25180_SCHED_PRIO_CONFIG);
+
+	bq25180_sched_clear_stats(&sched);
+
+	LONGS_EQUAL(0, bq25180_sched_get_unscheduled(&sched));
+	LONGS_EQUAL(0, stats(BQ25180_SCHED_PRIO_CONFIG).completed);
+	LONGS_EQUAL(1, stats(BQ25180_SCHED_PRIO_CONFIG).pending);
+	LONGS_EQUAL(1, bq25180_sched_run(&sched));
+	LONGS_EQUAL(1, stats(BQ25180_SCHED_PRIO_CONFIG).completed);
+}
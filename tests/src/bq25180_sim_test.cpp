@@ -0,0 +1,510 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include "bq25180.h"
+#include "bq25180_sim.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+static void on_interrupt(void *ctx) {
+	(*(int *)ctx)++;
+}
+
+TEST_GROUP(BQ25180Sim) {
+	struct bq25180_sim sim;
+	struct bq25180 dev;
+
+	void setup(void) {
+		bq25180_sim_init(&sim, BQ25180_DEVICE_ADDRESS);
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_sim_bus, &sim);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void step_until_state(uint8_t charging_status, uint32_t limit_ms) {
+		struct bq25180_state state;
+
+		for (uint32_t t = 0; t < limit_ms; t += 1000) {
+			bq25180_sim_step(&sim, 1000);
+			bq25180_dev_read_snapshot(&dev, &state, NULL);
+			if (state.charging_status == charging_status) {
+				return;
+			}
+		}
+
+		FAIL("charging status not reached");
+	}
+};
+
+TEST(BQ25180Sim, ShouldHaveResetValues) {
+	const uint8_t expected[BQ25180_NR_REGISTERS] = {
+		0x00, 0x00, 0x00, 0x46, 0x05, 0x2c, 0x56,
+		0x84, 0x4d, 0x11, 0x40, 0x00, 0xc0,
+	};
+
+	for (uint8_t i = 3; i < BQ25180_NR_REGISTERS; i++) {
+		LONGS_EQUAL(expected[i], bq25180_sim_peek(&sim, i));
+	}
+}
+
+TEST(BQ25180Sim, ShouldIgnoreWritesToReadOnlyBits) {
+	const uint8_t val[] = { 0xff, 0xff, 0xff };
+	const uint8_t id = 0xff;
+
+	LONGS_EQUAL(3, bq25180_sim_bus.write(&sim, BQ25180_DEVICE_ADDRESS,
+				0x00/*STAT0*/, val, sizeof(val)));
+	LONGS_EQUAL(1, bq25180_sim_bus.write(&sim, BQ25180_DEVICE_ADDRESS,
+				0x0c/*MASK_ID*/, &id, sizeof(id)));
+
+	LONGS_EQUAL(0x00, bq25180_sim_peek(&sim, 0x00));
+	LONGS_EQUAL(0x00, bq25180_sim_peek(&sim, 0x02));
+	LONGS_EQUAL(0xf0, bq25180_sim_peek(&sim, 0x0c));
+}
+
+TEST(BQ25180Sim, ShouldClearFlagsOnRead) {
+	struct bq25180_event event;
+
+	bq25180_sim_set_source(&sim, 6000, 0);
+	LONGS_EQUAL(true, bq25180_dev_read_event(&dev, &event));
+	LONGS_EQUAL(1, event.input_overvoltage);
+
+	bq25180_sim_set_source(&sim, 5000, 0);
+	LONGS_EQUAL(true, bq25180_dev_read_event(&dev, &event));
+	LONGS_EQUAL(0, event.input_overvoltage);
+}
+
+TEST(BQ25180Sim, ShouldResetControlRegisters_WhenWatchdogExpires) {
+	struct bq25180_sim_stats stats;
+
+	bq25180_dev_set_fastcharge_current(&dev, 100);
+	bq25180_sim_step(&sim, 159000);
+	LONGS_EQUAL(0x25, bq25180_sim_peek(&sim, 0x04/*ICHG_CTRL*/));
+
+	bq25180_sim_step(&sim, 1000);
+	LONGS_EQUAL(0x05, bq25180_sim_peek(&sim, 0x04/*ICHG_CTRL*/));
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(1, stats.watchdog_expiries);
+}
+
+TEST(BQ25180Sim, ShouldNotExpireWatchdog_WhenDisabled) {
+	bq25180_dev_set_watchdog_timer(&dev, BQ25180_WDT_DISABLE);
+	bq25180_dev_set_fastcharge_current(&dev, 100);
+
+	bq25180_sim_step(&sim, 1000000);
+	LONGS_EQUAL(0x25, bq25180_sim_peek(&sim, 0x04/*ICHG_CTRL*/));
+}
+
+TEST(BQ25180Sim, ShouldResetRegisters_WhenSoftwareReset) {
+	bq25180_dev_set_fastcharge_current(&dev, 100);
+	bq25180_dev_reset(&dev, false);
+
+	LONGS_EQUAL(0x05, bq25180_sim_peek(&sim, 0x04/*ICHG_CTRL*/));
+	LONGS_EQUAL(0x11, bq25180_sim_peek(&sim, 0x09/*SHIP_RST*/));
+}
+
+TEST(BQ25180Sim, ShouldChargeThroughAllPhases) {
+	bq25180_dev_set_watchdog_timer(&dev, BQ25180_WDT_DISABLE);
+	bq25180_dev_set_fastcharge_current(&dev, 100);
+	bq25180_dev_set_input_current(&dev, 500);
+	bq25180_sim_set_battery(&sim, 2900, 100);
+	bq25180_sim_set_source(&sim, 5000, 100);
+
+	LONGS_EQUAL(20, bq25180_sim_charge_milliampere(&sim)); /* precharge */
+	step_until_state(1, 1000);
+	step_until_state(2, 4 * 3600000U);
+	LONGS_EQUAL(4200, bq25180_sim_battery_millivoltage(&sim));
+	step_until_state(3, 4 * 3600000U);
+	LONGS_EQUAL(0, bq25180_sim_charge_milliampere(&sim));
+}
+
+TEST(BQ25180Sim, ShouldLimitInputCurrent) {
+	struct bq25180_state state;
+
+	bq25180_dev_set_fastcharge_current(&dev, 500);
+	bq25180_dev_set_input_current(&dev, 300);
+	bq25180_sim_set_source(&sim, 5000, 0);
+
+	bq25180_dev_read_snapshot(&dev, &state, NULL);
+	LONGS_EQUAL(1, state.ilim_active);
+	LONGS_EQUAL(300, bq25180_sim_input_milliampere(&sim));
+}
+
+TEST(BQ25180Sim, ShouldHoldInputAtVindpm) {
+	struct bq25180_state state;
+
+	bq25180_dev_set_fastcharge_current(&dev, 500);
+	bq25180_dev_set_input_current(&dev, 700);
+	bq25180_dev_enable_vindpm(&dev, BQ25180_VINDPM_4500mV);
+	bq25180_sim_set_source(&sim, 5000, 2000);
+
+	bq25180_dev_read_snapshot(&dev, &state, NULL);
+	LONGS_EQUAL(1, state.vindpm_active);
+	LONGS_EQUAL(250, bq25180_sim_input_milliampere(&sim));
+}
+
+TEST(BQ25180Sim, ShouldRegulateDieTemperature) {
+	struct bq25180_state state;
+
+	bq25180_dev_set_fastcharge_current(&dev, 500);
+	bq25180_dev_set_input_current(&dev, 700);
+	bq25180_sim_set_thermal(&sim, 60, 200);
+	bq25180_sim_set_source(&sim, 5000, 0);
+
+	bq25180_dev_read_snapshot(&dev, &state, NULL);
+	LONGS_EQUAL(1, state.thermal_regulation_active);
+	LONGS_EQUAL(250, bq25180_sim_charge_milliampere(&sim));
+	LONGS_EQUAL(125, bq25180_sim_die_celsius(&sim));
+}
+
+TEST(BQ25180Sim, ShouldPulseInterrupt_WhenUnmaskedStatusChanges) {
+	int count = 0;
+
+	bq25180_sim_set_interrupt_handler(&sim, on_interrupt, &count);
+	bq25180_sim_set_source(&sim, 5000, 0);
+	LONGS_EQUAL(1, count);
+
+	bq25180_dev_disable_interrupt(&dev, BQ25180_INTR_ALL);
+	bq25180_sim_set_source(&sim, 0, 0);
+	LONGS_EQUAL(1, count);
+}
+
+TEST(BQ25180Sim, ShouldEnterShipmode_WhenInputRemoved) {
+	struct bq25180_state state;
+
+	bq25180_sim_set_source(&sim, 5000, 0);
+	LONGS_EQUAL(true, bq25180_dev_set_battery_discharge_current(&dev,
+				BQ25180_BAT_DISCHAGE_500mA));
+	const uint8_t val = 0x51; /* EN_RST_SHIP = shipmode */
+	bq25180_sim_bus.write(&sim, BQ25180_DEVICE_ADDRESS,
+			0x09/*SHIP_RST*/, &val, sizeof(val));
+	LONGS_EQUAL(BQ25180_SIM_ACTIVE, bq25180_sim_mode(&sim));
+
+	bq25180_sim_set_source(&sim, 0, 0);
+	LONGS_EQUAL(BQ25180_SIM_SHIP, bq25180_sim_mode(&sim));
+	LONGS_EQUAL(false, bq25180_dev_read_snapshot(&dev, &state, NULL));
+
+	bq25180_sim_press_button(&sim);
+	LONGS_EQUAL(true, bq25180_dev_read_snapshot(&dev, &state, NULL));
+	LONGS_EQUAL(0x56, bq25180_sim_peek(&sim, 0x06/*CHARGECTRL1*/));
+}
+
+TEST(BQ25180Sim, enter_power_mode_ShouldWaitVinRemoval_WhenRequested) {
+	struct bq25180_state state;
+
+	bq25180_sim_set_source(&sim, 5000, 0);
+	LONGS_EQUAL(true, bq25180_dev_enter_power_mode(&dev,
+				BQ25180_POWER_SHIP, true));
+	LONGS_EQUAL(BQ25180_SIM_ACTIVE, bq25180_sim_mode(&sim));
+	LONGS_EQUAL(BQ25180_POWER_SHIP,
+			bq25180_dev_get_pending_power_mode(&dev));
+
+	bq25180_sim_set_source(&sim, 0, 0);
+	LONGS_EQUAL(BQ25180_SIM_SHIP, bq25180_sim_mode(&sim));
+	LONGS_EQUAL(false, bq25180_dev_read_snapshot(&dev, &state, NULL));
+}
+
+TEST(BQ25180Sim, enter_power_mode_ShouldClearPending_WhenWokenUpWithoutVin) {
+	struct bq25180_state state;
+
+	bq25180_dev_enable_cache(&dev, true);
+	bq25180_sim_set_source(&sim, 5000, 0);
+	bq25180_dev_set_fastcharge_current(&dev, 100);
+	bq25180_dev_enter_power_mode(&dev, BQ25180_POWER_SHIP, true);
+	bq25180_sim_set_source(&sim, 0, 0);
+	bq25180_sim_press_button(&sim);
+
+	LONGS_EQUAL(true, bq25180_dev_read_state(&dev, &state));
+	LONGS_EQUAL(BQ25180_POWER_ACTIVE,
+			bq25180_dev_get_pending_power_mode(&dev));
+	/* The cache follows the device back to the reset defaults */
+	bq25180_dev_enable_battery_charging(&dev, true);
+	LONGS_EQUAL(0x05, bq25180_sim_peek(&sim, 0x04/*ICHG_CTRL*/));
+}
+
+TEST(BQ25180Sim, enter_power_mode_ShouldStayPending_WhenWakeConfigWritten) {
+	struct bq25180_wake_config wake;
+
+	bq25180_dev_enable_cache(&dev, true);
+	bq25180_sim_set_source(&sim, 5000, 0);
+	bq25180_dev_enter_power_mode(&dev, BQ25180_POWER_SHIP, true);
+
+	LONGS_EQUAL(true, bq25180_dev_get_wake_config(&dev, &wake));
+	wake.push_button_enabled = false;
+	LONGS_EQUAL(true, bq25180_dev_set_wake_config(&dev, &wake));
+	LONGS_EQUAL(true, bq25180_dev_enable_push_button(&dev, true));
+
+	bq25180_sim_set_source(&sim, 0, 0);
+	LONGS_EQUAL(BQ25180_SIM_SHIP, bq25180_sim_mode(&sim));
+}
+
+TEST(BQ25180Sim, enter_power_mode_ShouldStayPending_WhenConfigApplied) {
+	struct bq25180_config cfg;
+
+	bq25180_sim_set_source(&sim, 5000, 0);
+	bq25180_dev_enter_power_mode(&dev, BQ25180_POWER_SHUTDOWN, true);
+
+	bq25180_get_default_config(&cfg);
+	cfg.push_button_enabled = false;
+	LONGS_EQUAL(true, bq25180_dev_apply_config(&dev, &cfg));
+
+	bq25180_sim_set_source(&sim, 0, 0);
+	LONGS_EQUAL(BQ25180_SIM_SHUTDOWN, bq25180_sim_mode(&sim));
+}
+
+TEST(BQ25180Sim, enter_power_mode_ShouldIgnoreButton_WhenShutdown) {
+	LONGS_EQUAL(true, bq25180_dev_enter_power_mode(&dev,
+				BQ25180_POWER_SHUTDOWN, false));
+	LONGS_EQUAL(BQ25180_SIM_SHUTDOWN, bq25180_sim_mode(&sim));
+
+	bq25180_sim_press_button(&sim);
+	LONGS_EQUAL(BQ25180_SIM_SHUTDOWN, bq25180_sim_mode(&sim));
+	bq25180_sim_set_source(&sim, 5000, 0);
+	LONGS_EQUAL(BQ25180_SIM_ACTIVE, bq25180_sim_mode(&sim));
+}
+
+TEST(BQ25180Sim, reset_ShouldCancelPendingPowerMode) {
+	bq25180_sim_set_source(&sim, 5000, 0);
+	bq25180_dev_enter_power_mode(&dev, BQ25180_POWER_SHIP, true);
+	LONGS_EQUAL(true, bq25180_dev_reset(&dev, false));
+
+	bq25180_sim_set_source(&sim, 0, 0);
+	LONGS_EQUAL(BQ25180_SIM_ACTIVE, bq25180_sim_mode(&sim));
+	LONGS_EQUAL(BQ25180_POWER_ACTIVE,
+			bq25180_dev_get_pending_power_mode(&dev));
+}
+
+TEST(BQ25180Sim, ShouldNak_WhenInjected) {
+	struct bq25180_sim_stats stats;
+
+	bq25180_sim_inject_nak(&sim, 1);
+	LONGS_EQUAL(false, bq25180_dev_enable_battery_charging(&dev, false));
+	LONGS_EQUAL(true, bq25180_dev_enable_battery_charging(&dev, false));
+
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(1, stats.naks);
+	LONGS_EQUAL(1, stats.reads);
+	LONGS_EQUAL(1, stats.writes);
+}
+
+TEST(BQ25180Sim, ShouldServeLegacyApiThroughOverrides) {
+	struct bq25180_sim *p = bq25180_sim_get_default();
+
+	bq25180_enable_battery_charging(false);
+	LONGS_EQUAL(0x85, bq25180_sim_peek(p, 0x04/*ICHG_CTRL*/));
+}
+
+TEST(BQ25180Sim, dump_ShouldDecodeBackTheAppliedConfig) {
+	struct bq25180_config cfg;
+	struct bq25180_dump dump;
+	struct bq25180_dump_info info;
+	struct bq25180_sim_stats stats;
+
+	bq25180_get_default_config(&cfg);
+	cfg.battery_regulation_millivoltage = 4350;
+	cfg.fastcharge_milliampere = 300;
+	cfg.input_milliampere = 700;
+	cfg.battery_undervoltage_millivoltage = 2400;
+	cfg.watchdog = BQ25180_WDT_DISABLE;
+	cfg.interrupts = BQ25180_INTR_ALL;
+	bq25180_dev_apply_config(&dev, &cfg);
+	bq25180_sim_clear_stats(&sim);
+
+	LONGS_EQUAL(true, bq25180_dev_dump(&dev, &dump));
+	bq25180_decode_dump(&dump, &info);
+
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(1, stats.reads);
+	LONGS_EQUAL(13, stats.read_bytes);
+	LONGS_EQUAL(4350, info.config.battery_regulation_millivoltage);
+	LONGS_EQUAL(300, info.config.fastcharge_milliampere);
+	LONGS_EQUAL(700, info.config.input_milliampere);
+	LONGS_EQUAL(2400, info.config.battery_undervoltage_millivoltage);
+	LONGS_EQUAL(BQ25180_WDT_DISABLE, info.config.watchdog);
+	LONGS_EQUAL(BQ25180_INTR_ALL, info.config.interrupts);
+	LONGS_EQUAL(cfg.charging_enabled, info.config.charging_enabled);
+}
+
+TEST(BQ25180Sim, restore_config_ShouldRewriteImage_WhenWatchdogExpired) {
+	struct bq25180_config cfg;
+	struct bq25180_sim_stats stats;
+	uint8_t image[BQ25180_CONFIG_IMAGE_LEN];
+	bool restored;
+
+	bq25180_get_default_config(&cfg);
+	cfg.fastcharge_milliampere = 500;
+	cfg.input_milliampere = 700;
+	bq25180_get_config_image(&cfg, image);
+	bq25180_dev_enable_cache(&dev, false);
+	bq25180_dev_apply_config_image(&dev, image);
+
+	bq25180_sim_step(&sim, 160000);
+	LONGS_EQUAL(0x05, bq25180_sim_peek(&sim, 0x04/*ICHG_CTRL*/));
+	bq25180_sim_clear_stats(&sim);
+
+	LONGS_EQUAL(true, bq25180_dev_restore_config_image(&dev, image,
+				&restored));
+	LONGS_EQUAL(true, restored);
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(1, stats.reads);
+	LONGS_EQUAL(1, stats.read_bytes);
+	LONGS_EQUAL(1, stats.writes);
+	LONGS_EQUAL(5, stats.written_bytes); /* ICHG_CTRL to TMR_ILIM */
+	for (uint8_t i = 0; i < BQ25180_CONFIG_IMAGE_LEN; i++) {
+		LONGS_EQUAL(image[i], bq25180_sim_peek(&sim, (uint8_t)(3 + i)));
+	}
+
+	/* Served by the shadow re-seeded */
+	bq25180_sim_clear_stats(&sim);
+	bq25180_dev_set_watchdog_timer(&dev, BQ25180_WDT_DISABLE);
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(0, stats.reads);
+	LONGS_EQUAL(0x87, bq25180_sim_peek(&sim, 0x07/*IC_CTRL*/));
+}
+
+TEST(BQ25180Sim, restore_config_ShouldOnlyRead_WhenNotReset) {
+	struct bq25180_config cfg;
+	struct bq25180_sim_stats stats;
+	uint8_t image[BQ25180_CONFIG_IMAGE_LEN];
+	bool restored = true;
+
+	bq25180_get_default_config(&cfg);
+	cfg.fastcharge_milliampere = 500;
+	bq25180_get_config_image(&cfg, image);
+	bq25180_dev_apply_config_image(&dev, image);
+	bq25180_sim_clear_stats(&sim);
+
+	LONGS_EQUAL(true, bq25180_dev_restore_config_image(&dev, image,
+				&restored));
+	LONGS_EQUAL(false, restored);
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(1, stats.reads);
+	LONGS_EQUAL(0, stats.writes);
+}
+
+TEST(BQ25180Sim, restore_config_ShouldNotTouchBus_WhenImageIsResetValues) {
+	struct bq25180_config cfg;
+	struct bq25180_sim_stats stats;
+	uint8_t image[BQ25180_CONFIG_IMAGE_LEN];
+	bool restored = true;
+
+	bq25180_get_default_config(&cfg);
+	bq25180_get_config_image(&cfg, image);
+
+	LONGS_EQUAL(true, bq25180_dev_restore_config_image(&dev, image,
+				&restored));
+	LONGS_EQUAL(false, restored);
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(0, stats.reads + stats.writes);
+}
+
+TEST(BQ25180Sim, probe_ShouldWriteImageInSingleBurst_OnColdBoot) {
+	struct bq25180_config cfg;
+	struct bq25180_sim_stats stats;
+	struct bq25180_probe_report report;
+	uint8_t image[BQ25180_CONFIG_IMAGE_LEN];
+
+	bq25180_get_default_config(&cfg);
+	cfg.fastcharge_milliampere = 500;
+	cfg.input_milliampere = 700;
+	bq25180_get_config_image(&cfg, image);
+	bq25180_dev_enable_cache(&dev, false);
+
+	LONGS_EQUAL(true, bq25180_dev_probe(&dev, image, &report));
+	LONGS_EQUAL(BQ25180_DEVICE_ID, report.device_id);
+	LONGS_EQUAL(true, report.at_reset_defaults);
+	LONGS_EQUAL(2, report.transactions);
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(1, stats.reads);
+	LONGS_EQUAL(10, stats.read_bytes);
+	LONGS_EQUAL(1, stats.writes);
+	LONGS_EQUAL(5, stats.written_bytes); /* ICHG_CTRL to TMR_ILIM */
+	for (uint8_t i = 0; i < BQ25180_CONFIG_IMAGE_LEN; i++) {
+		LONGS_EQUAL(image[i], bq25180_sim_peek(&sim, (uint8_t)(3 + i)));
+	}
+
+	/* Served by the shadow seeded */
+	bq25180_sim_clear_stats(&sim);
+	bq25180_dev_set_watchdog_timer(&dev, BQ25180_WDT_DISABLE);
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(0, stats.reads);
+}
+
+TEST(BQ25180Sim, probe_ShouldOnlyRead_WhenImageAlreadyApplied) {
+	struct bq25180_config cfg;
+	struct bq25180_sim_stats stats;
+	struct bq25180_probe_report report;
+	uint8_t image[BQ25180_CONFIG_IMAGE_LEN];
+
+	bq25180_get_default_config(&cfg);
+	cfg.fastcharge_milliampere = 500;
+	bq25180_get_config_image(&cfg, image);
+	bq25180_dev_apply_config_image(&dev, image);
+	bq25180_sim_clear_stats(&sim);
+
+	LONGS_EQUAL(true, bq25180_dev_probe(&dev, image, &report));
+	LONGS_EQUAL(false, report.at_reset_defaults);
+	LONGS_EQUAL(1, report.transactions);
+	bq25180_sim_get_stats(&sim, &stats);
+	LONGS_EQUAL(0, stats.writes);
+}
+
+TEST(BQ25180Sim, probe_ShouldReturnFalse_WhenNoDevice) {
+	struct bq25180_probe_report report;
+
+	bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS + 1,
+			&bq25180_sim_bus, &sim);
+
+	LONGS_EQUAL(false, bq25180_dev_probe(&dev, NULL, &report));
+	LONGS_EQUAL(1, report.transactions);
+}
+
+TEST(BQ25180Sim, probe_ShouldCountRetries) {
+	const struct bq25180_retry_policy policy = { .max_retries = 2, };
+	struct bq25180_probe_report report;
+
+	bq25180_dev_set_retry_policy(&dev, &policy);
+	bq25180_sim_inject_nak(&sim, 1);
+
+	LONGS_EQUAL(true, bq25180_dev_probe(&dev, NULL, &report));
+	LONGS_EQUAL(true, report.at_reset_defaults);
+	LONGS_EQUAL(2, report.transactions);
+}
+
+TEST(BQ25180Sim, restore_config_ShouldReturnFalse_WhenReadFails) {
+	struct bq25180_config cfg;
+	uint8_t image[BQ25180_CONFIG_IMAGE_LEN];
+	bool restored = true;
+
+	bq25180_get_default_config(&cfg);
+	cfg.fastcharge_milliampere = 500;
+	bq25180_get_config_image(&cfg, image);
+	bq25180_sim_inject_nak(&sim, 1);
+
+	LONGS_EQUAL(false, bq25180_dev_restore_config_image(&dev, image,
+				&restored));
+	LONGS_EQUAL(false, restored);
+}
@@ -10,6 +10,7 @@
 
 #include "bq25180.h"
 #include "bq25180_overrides.h"
+#include "bq25180_internal.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -43,6 +44,14 @@ int bq25180_write(uint8_t addr, uint8_t reg, const void *data, size_t data_len)
 			.returnIntValueOrDefault((int)data_len);
 }
 
+static void intr_callback(enum bq25180_intr intr,
+		const struct bq25180_state *state,
+		const struct bq25180_event *event, void *ctx) {
+	mock().actualCall(__func__)
+		.withParameter("intr", (int)intr)
+		.withParameter("ctx", ctx);
+}
+
 TEST_GROUP(BQ25180) {
 	void setup(void) {
 		mock().strictOrder();
@@ -50,6 +59,9 @@ TEST_GROUP(BQ25180) {
 	void teardown(void) {
 		mock().checkExpectations();
 		mock().clear();
+
+		bq25180_disable_cache();
+		bq25180_register_interrupt_callback(BQ25180_INTR_ALL, NULL, NULL);
 	}
 
 	void expect_reg_read(uint8_t reg, uint8_t *p) {
@@ -59,6 +71,13 @@ TEST_GROUP(BQ25180) {
 			.withOutputParameterReturning("buf", p, sizeof(*p))
 			.withParameter("bufsize", 1);
 	}
+	void expect_state_read(uint8_t regs[2]) {
+		mock().expectOneCall("bq25180_read")
+			.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+			.withParameter("reg", 0x00/*STAT0*/)
+			.withOutputParameterReturning("buf", regs, 2)
+			.withParameter("bufsize", 2);
+	}
 	void expect_reg_write(uint8_t reg, uint8_t *p) {
 		mock().expectOneCall("bq25180_write")
 			.withParameter("addr", BQ25180_DEVICE_ADDRESS)
@@ -142,21 +161,18 @@ TEST(BQ25180, read_event_ShouldAssertParam_WhenNullParamGiven) {
 }
 
 TEST(BQ25180, read_state_ShouldReturnState) {
-	uint8_t stat0 = 0;
-	uint8_t stat1 = 0;
+	uint8_t stat[2] = { 0, 0 };
 	struct bq25180_state expected = { 0, };
 	struct bq25180_state actual;
 
-	expect_reg_read(0x00, &stat0);
-	expect_reg_read(0x01, &stat1);
+	expect_state_read(stat);
 
 	LONGS_EQUAL(true, bq25180_read_state(&actual));
 	MEMCMP_EQUAL(&expected, &actual, sizeof(expected));
 }
 
 TEST(BQ25180, read_state_ShouldReturnState_WhenAllStateAreSetToOnes) {
-	uint8_t stat0 = 0xff;
-	uint8_t stat1 = 0xff;
+	uint8_t stat[2] = { 0xff, 0xff };
 	struct bq25180_state expected = {
 		.vin_good = 1,
 		.thermal_regulation_active = 1,
@@ -175,16 +191,14 @@ TEST(BQ25180, read_state_ShouldReturnState_WhenAllStateAreSetToOnes) {
 
 	struct bq25180_state actual;
 
-	expect_reg_read(0x00, &stat0);
-	expect_reg_read(0x01, &stat1);
+	expect_state_read(stat);
 
 	LONGS_EQUAL(true, bq25180_read_state(&actual));
 	MEMCMP_EQUAL(&expected, &actual, sizeof(expected));
 }
 
 TEST(BQ25180, read_state_ShouldReturnState_WhenSomeStateAreSetToOnes) {
-	uint8_t stat0 = 0x35;
-	uint8_t stat1 = 0x95;
+	uint8_t stat[2] = { 0x35, 0x95 };
 	struct bq25180_state expected = {
 		.vin_good = 1,
 		.thermal_regulation_active = 0,
@@ -203,8 +217,7 @@ TEST(BQ25180, read_state_ShouldReturnState_WhenSomeStateAreSetToOnes) {
 
 	struct bq25180_state actual;
 
-	expect_reg_read(0x00, &stat0);
-	expect_reg_read(0x01, &stat1);
+	expect_state_read(stat);
 
 	LONGS_EQUAL(true, bq25180_read_state(&actual));
 	MEMCMP_EQUAL(&expected, &actual, sizeof(expected));
@@ -461,6 +474,36 @@ TEST(BQ25180, thermal_protection_ShouldEnable) {
 	bq25180_enable_thermal_protection(true);
 }
 
+TEST(BQ25180, set_ts_control_ShouldWriteWholeRegisterWithoutReading) {
+	struct bq25180_ts_config ts = {
+		.hot = BQ25180_TS_HOT_50C,
+		.cold = BQ25180_TS_COLD_MINUS_3C,
+		.warm_enabled = false,
+		.cool_enabled = true,
+		.cool_current = BQ25180_TS_ICHG_20PCT,
+		.warm_voltage = BQ25180_TS_VBATREG_MINUS_200mV,
+	};
+	uint8_t expected = 0xbb;
+
+	expect_reg_write(0x0b/*TS_CONTROL*/, &expected);
+	LONGS_EQUAL(true, bq25180_set_ts_control(&ts));
+}
+
+TEST(BQ25180, get_ts_control_ShouldDecodeRegister) {
+	struct bq25180_ts_config ts;
+	uint8_t val = 0x76;
+
+	expect_reg_read(0x0b/*TS_CONTROL*/, &val);
+	LONGS_EQUAL(true, bq25180_get_ts_control(&ts));
+
+	LONGS_EQUAL(BQ25180_TS_HOT_65C, ts.hot);
+	LONGS_EQUAL(BQ25180_TS_COLD_MINUS_3C, ts.cold);
+	LONGS_EQUAL(true, ts.warm_enabled);
+	LONGS_EQUAL(false, ts.cool_enabled);
+	LONGS_EQUAL(BQ25180_TS_ICHG_20PCT, ts.cool_current);
+	LONGS_EQUAL(BQ25180_TS_VBATREG_MINUS_100mV, ts.warm_voltage);
+}
+
 TEST(BQ25180, enable_push_button_ShouldDisable) {
 	expect_reg(0x09/*SHIP_RST*/, 0x11, 0x10);
 	bq25180_enable_push_button(false);
@@ -471,6 +514,68 @@ TEST(BQ25180, enable_push_button_ShouldEnable) {
 	bq25180_enable_push_button(true);
 }
 
+TEST(BQ25180, set_wake_config_ShouldWriteShipRst) {
+	struct bq25180_wake_config wake = {
+		.push_button_enabled = true,
+		.wake1 = BQ25180_WAKE1_1000ms,
+		.wake2 = BQ25180_WAKE2_3600ms,
+		.long_press = BQ25180_PB_SHUTDOWN,
+	};
+
+	expect_reg(0x09/*SHIP_RST*/, 0x11, 0x1f);
+	LONGS_EQUAL(true, bq25180_set_wake_config(&wake));
+}
+
+TEST(BQ25180, get_wake_config_ShouldDecodeRegister) {
+	struct bq25180_wake_config wake;
+	uint8_t val = 0x11;
+
+	expect_reg_read(0x09/*SHIP_RST*/, &val);
+	LONGS_EQUAL(true, bq25180_get_wake_config(&wake));
+
+	LONGS_EQUAL(true, wake.push_button_enabled);
+	LONGS_EQUAL(BQ25180_WAKE1_300ms, wake.wake1);
+	LONGS_EQUAL(BQ25180_WAKE2_2000ms, wake.wake2);
+	LONGS_EQUAL(BQ25180_PB_SHIPMODE, wake.long_press);
+}
+
+TEST(BQ25180, enter_power_mode_ShouldRequestShipmode_WhenVinAbsent) {
+	uint8_t stat0 = 0x00;
+
+	expect_reg_read(0x00/*STAT0*/, &stat0);
+	expect_reg(0x09/*SHIP_RST*/, 0x11, 0x51);
+	LONGS_EQUAL(true, bq25180_enter_power_mode(BQ25180_POWER_SHIP, false));
+	LONGS_EQUAL(BQ25180_POWER_ACTIVE, bq25180_get_pending_power_mode());
+}
+
+TEST(BQ25180, enter_power_mode_ShouldRefuse_WhenVinPresent) {
+	uint8_t stat0 = 0x01;
+
+	expect_reg_read(0x00/*STAT0*/, &stat0);
+	LONGS_EQUAL(false,
+		bq25180_enter_power_mode(BQ25180_POWER_SHUTDOWN, false));
+	LONGS_EQUAL(BQ25180_POWER_ACTIVE, bq25180_get_pending_power_mode());
+}
+
+TEST(BQ25180, enter_power_mode_ShouldLeavePending_WhenVinPresent) {
+	uint8_t stat0 = 0x01;
+
+	expect_reg_read(0x00/*STAT0*/, &stat0);
+	expect_reg(0x09/*SHIP_RST*/, 0x11, 0x31);
+	LONGS_EQUAL(true,
+		bq25180_enter_power_mode(BQ25180_POWER_SHUTDOWN, true));
+	LONGS_EQUAL(BQ25180_POWER_SHUTDOWN, bq25180_get_pending_power_mode());
+
+	expect_reg(0x09/*SHIP_RST*/, 0x11, 0x91);
+	bq25180_reset(false);
+	LONGS_EQUAL(BQ25180_POWER_ACTIVE, bq25180_get_pending_power_mode());
+}
+
+TEST(BQ25180, enter_power_mode_ShouldAssertParam_WhenActiveGiven) {
+	mock().expectOneCall("fake_assert");
+	bq25180_enter_power_mode(BQ25180_POWER_ACTIVE, false);
+}
+
 TEST(BQ25180, enable_interrupt_ShouldEnable) {
 	expect_reg(0x0C/*MASK_ID*/, 0xC0, 0x40);
 	bq25180_enable_interrupt(BQ25180_INTR_THERMAL_FAULT);
@@ -506,3 +611,937 @@ TEST(BQ25180, disable_interrupt_ShouldDisable) {
 	expect_reg(0x06/*CHARGECTRL1*/, 0, 1);
 	bq25180_disable_interrupt(BQ25180_INTR_VDPM);
 }
+
+TEST(BQ25180, enable_cache_ShouldSeedFromResetDefaults_WithoutBusAccess) {
+	LONGS_EQUAL(true, bq25180_enable_cache(false));
+}
+
+TEST(BQ25180, enable_cache_ShouldSeedWithSingleBurstRead_WhenReadDeviceGiven) {
+	uint8_t regs[10] = { 0x46,0x05,0x2c,0x56,0x84,0x4d,0x11,0x40,0x00,0xc0 };
+	regs[1] = 0x85;
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x03/*VBAT_CTRL*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+	LONGS_EQUAL(true, bq25180_enable_cache(true));
+
+	uint8_t expected = 0x9f;
+	expect_reg_write(0x04/*ICHG_CTRL*/, &expected);
+	bq25180_set_fastcharge_current(40);
+}
+
+TEST(BQ25180, enable_cache_ShouldReturnFalse_WhenBurstReadFails) {
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x03/*VBAT_CTRL*/)
+		.ignoreOtherParameters()
+		.andReturnValue(-1);
+	LONGS_EQUAL(false, bq25180_enable_cache(true));
+
+	expect_reg(0x04/*ICHG_CTRL*/, 0x05, 0x1f);
+	bq25180_set_fastcharge_current(40);
+}
+
+TEST(BQ25180, cache_ShouldWriteWithoutReadBack_WhenEnabled) {
+	uint8_t v1 = 0x66, v2 = 0xe6;
+	bq25180_enable_cache(false);
+
+	expect_reg_write(0x06/*CHARGECTRL1*/, &v1);
+	bq25180_set_battery_under_voltage(2600);
+	expect_reg_write(0x06/*CHARGECTRL1*/, &v2);
+	bq25180_set_battery_discharge_current(BQ25180_BAT_DISCHAGE_DISABLE);
+}
+
+TEST(BQ25180, cache_ShouldKeepStatusRegistersUncached) {
+	uint8_t flag0 = 0x01;
+	struct bq25180_event actual;
+	bq25180_enable_cache(false);
+
+	expect_reg_read(0x02, &flag0);
+	bq25180_read_event(&actual);
+	LONGS_EQUAL(1, actual.battery_overcurrent);
+}
+
+TEST(BQ25180, cache_ShouldAccumulateFieldWrites_OnTheSameRegister) {
+	uint8_t v1 = 0x1f, v2 = 0x9f;
+	bq25180_enable_cache(false);
+
+	expect_reg_write(0x04/*ICHG_CTRL*/, &v1);
+	bq25180_set_fastcharge_current(40);
+	expect_reg_write(0x04/*ICHG_CTRL*/, &v2);
+	bq25180_enable_battery_charging(false);
+}
+
+TEST(BQ25180, cache_ShouldReturnToDefaults_WhenReset) {
+	uint8_t v1 = 0x1f, v2 = 0x91, v3 = 0x85;
+	bq25180_enable_cache(false);
+
+	expect_reg_write(0x04/*ICHG_CTRL*/, &v1);
+	bq25180_set_fastcharge_current(40);
+	expect_reg_write(0x09/*SHIP_RST*/, &v2);
+	bq25180_reset(false);
+	expect_reg_write(0x04/*ICHG_CTRL*/, &v3);
+	bq25180_enable_battery_charging(false);
+}
+
+TEST(BQ25180, cache_ShouldReadBeforeWrite_WhenDisabled) {
+	bq25180_enable_cache(false);
+	bq25180_disable_cache();
+
+	expect_reg(0x04/*ICHG_CTRL*/, 0x05, 0x85);
+	bq25180_enable_battery_charging(false);
+}
+
+TEST(BQ25180, read_snapshot_ShouldReadStatusAndFlagsInSingleBurst) {
+	uint8_t regs[3] = { 0x35, 0x95, 0x55 };
+	struct bq25180_state state;
+	struct bq25180_event event;
+
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x00/*STAT0*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+
+	LONGS_EQUAL(true, bq25180_read_snapshot(&state, &event));
+	LONGS_EQUAL(1, state.vin_good);
+	LONGS_EQUAL(1, state.charging_status);
+	LONGS_EQUAL(2, state.ts_status);
+	LONGS_EQUAL(1, state.vin_overvoltage_active);
+	LONGS_EQUAL(1, event.battery_overcurrent);
+	LONGS_EQUAL(0, event.battery_undervoltage);
+	LONGS_EQUAL(1, event.ilim_fault);
+}
+
+TEST(BQ25180, read_snapshot_ShouldLeaveFlagsUnread_WhenEventNotRequested) {
+	uint8_t regs[2] = { 0x01, 0x00 };
+	struct bq25180_state state;
+
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x00/*STAT0*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+
+	LONGS_EQUAL(true, bq25180_read_snapshot(&state, NULL));
+	LONGS_EQUAL(1, state.vin_good);
+}
+
+TEST(BQ25180, read_snapshot_ShouldReturnFalse_WhenBusFails) {
+	struct bq25180_event event;
+
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x00/*STAT0*/)
+		.ignoreOtherParameters()
+		.andReturnValue(-1);
+
+	LONGS_EQUAL(false, bq25180_read_snapshot(NULL, &event));
+}
+
+TEST(BQ25180, read_snapshot_ShouldAssertParam_WhenBothNull) {
+	mock().expectOneCall("fake_assert");
+	bq25180_read_snapshot(NULL, NULL);
+}
+
+TEST(BQ25180, dump_ShouldReadEveryRegisterInSingleBurst) {
+	uint8_t regs[13] = { 0x35,0x95,0x55,0x46,0x85,0x2c,0x56,
+		0x84,0x4f,0x11,0x40,0x00,0xc0 };
+	struct bq25180_dump dump;
+
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x00/*STAT0*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+
+	LONGS_EQUAL(true, bq25180_dump(&dump));
+	MEMCMP_EQUAL(regs, dump.regs, sizeof(regs));
+}
+
+TEST(BQ25180, dump_ShouldRefreshShadow_WhenCacheEnabled) {
+	uint8_t regs[13] = { 0,0,0,0x46,0x85,0x2c,0x56,
+		0x84,0x4d,0x11,0x40,0x00,0xc0 };
+	uint8_t expected = 0x05;
+	struct bq25180_dump dump;
+
+	bq25180_enable_cache(false);
+	mock().expectOneCall("bq25180_read").ignoreOtherParameters()
+		.withOutputParameterReturning("buf", regs, sizeof(regs));
+	bq25180_dump(&dump);
+
+	expect_reg_write(0x04/*ICHG_CTRL*/, &expected);
+	bq25180_enable_battery_charging(true);
+}
+
+TEST(BQ25180, dump_ShouldReturnFalse_WhenBusFails) {
+	struct bq25180_dump dump;
+
+	mock().expectOneCall("bq25180_read").ignoreOtherParameters()
+		.andReturnValue(-1);
+
+	LONGS_EQUAL(false, bq25180_dump(&dump));
+}
+
+TEST(BQ25180, decode_dump_ShouldDecodeSettingsInUnits) {
+	struct bq25180_dump dump = { { 0x35,0x95,0x55,0x50,0xff,0x18,0xa2,
+	0x06,0x4f,0x11,0x40,0x00,0x91 } };
+	struct bq25180_dump_info info;
+
+	bq25180_decode_dump(&dump, &info);
+
+	LONGS_EQUAL(1, info.state.charging_status);
+	LONGS_EQUAL(1, info.event.battery_overcurrent);
+	LONGS_EQUAL(false, info.config.charging_enabled);
+	LONGS_EQUAL(4300, info.config.battery_regulation_millivoltage);
+	LONGS_EQUAL(1000, info.config.fastcharge_milliampere);
+	LONGS_EQUAL(5, info.config.termination_pct);
+	LONGS_EQUAL(true, info.config.double_precharge_current);
+	LONGS_EQUAL(BQ25180_VINDPM_4700mV, info.config.vindpm);
+	LONGS_EQUAL(BQ25180_BAT_DISCHAGE_1500mA,
+			info.config.discharge_current);
+	LONGS_EQUAL(2600, info.config.battery_undervoltage_millivoltage);
+	LONGS_EQUAL(false, info.config.thermal_protection_enabled);
+	LONGS_EQUAL(3000, info.config.precharge_threshold_millivoltage);
+	LONGS_EQUAL(BQ25180_SAFETY_6H, info.config.safety_timer);
+	LONGS_EQUAL(BQ25180_WDT_40_SEC, info.config.watchdog);
+	LONGS_EQUAL(1100, info.config.input_milliampere);
+	LONGS_EQUAL(BQ25180_INTR_CHARGING_STATUS | BQ25180_INTR_VDPM |
+			BQ25180_INTR_THERMAL_REGULATION |
+			BQ25180_INTR_BATTERY_RANGE,
+			info.config.interrupts);
+	LONGS_EQUAL(1, info.device_id);
+}
+
+TEST(BQ25180, format_dump_ShouldPutSettingsAndRawRegistersInOneLine) {
+	struct bq25180_dump dump = { { 0x35,0x95,0x55,0x46,0x05,0x2c,0x56,
+		0x84,0x4d,0x11,0x40,0x00,0xc0 } };
+	const char *expected = "chg=1 pg=1 flag=55 vreg=4200mV ichg=10mA "
+		"iterm=10% ilim=500mA buvlo=3000mV id=0 "
+		"regs=35955546052c56844d114000c0";
+	char buf[128];
+
+	LONGS_EQUAL(strlen(expected),
+			bq25180_format_dump(&dump, buf, sizeof(buf)));
+	STRCMP_EQUAL(expected, buf);
+}
+
+TEST(BQ25180, format_dump_ShouldTruncate_WhenBufferTooSmall) {
+	struct bq25180_dump dump = { { 0, } };
+	char buf[8];
+
+	CHECK(bq25180_format_dump(&dump, buf, sizeof(buf)) >= 8);
+	STRCMP_EQUAL("chg=0 p", buf);
+}
+
+TEST(BQ25180, apply_config_ShouldNotWrite_WhenNothingChanged) {
+	uint8_t regs[10] = { 0x46,0x05,0x2c,0x56,0x84,0x4d,0x11,0x40,0x00,0xc0 };
+	struct bq25180_config cfg;
+
+	bq25180_get_default_config(&cfg);
+
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x03/*VBAT_CTRL*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+
+	LONGS_EQUAL(true, bq25180_apply_config(&cfg));
+}
+
+TEST(BQ25180, apply_config_ShouldWriteChangedRegistersInBursts) {
+	uint8_t burst1[] = { 0x1f/*ICHG_CTRL*/, 0x2c, 0x50, 0xc4/*IC_CTRL*/ };
+	uint8_t burst2[] = { 0x44/*SYS_REG*/, 0x00, 0x00/*MASK_ID*/ };
+	struct bq25180_config cfg;
+
+	bq25180_get_default_config(&cfg);
+	cfg.fastcharge_milliampere = 40;
+	cfg.precharge_threshold_millivoltage = 2800;
+	cfg.sys_source = BQ25180_SYS_SRC_VBAT;
+	cfg.interrupts = BQ25180_INTR_ALL;
+
+	bq25180_enable_cache(false);
+
+	mock().expectOneCall("bq25180_write")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x04/*ICHG_CTRL*/)
+		.withMemoryBufferParameter("data", burst1, sizeof(burst1));
+	mock().expectOneCall("bq25180_write")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x0a/*SYS_REG*/)
+		.withMemoryBufferParameter("data", burst2, sizeof(burst2));
+
+	LONGS_EQUAL(true, bq25180_apply_config(&cfg));
+}
+
+TEST(BQ25180, apply_config_ShouldKeepUncoveredBits) {
+	uint8_t regs[10] = { 0xc6,0x05,0x2f,0x56,0xb4,0xcd,0x19,0x42,0x5a,0xc0 };
+	uint8_t expected = 0xcf;
+	struct bq25180_config cfg;
+
+	bq25180_get_default_config(&cfg);
+	cfg.input_milliampere = 1100;
+	/* TS_CONTROL is covered as a whole: 0x5a */
+	cfg.ts.hot = BQ25180_TS_HOT_65C;
+	cfg.ts.cold = BQ25180_TS_COLD_3C;
+	cfg.ts.warm_enabled = false;
+	cfg.ts.cool_current = BQ25180_TS_ICHG_20PCT;
+
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x03/*VBAT_CTRL*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+	expect_reg_write(0x08/*TMR_ILIM*/, &expected);
+
+	LONGS_EQUAL(true, bq25180_apply_config(&cfg));
+}
+
+TEST(BQ25180, apply_config_ShouldReturnFalse_WhenReadFails) {
+	struct bq25180_config cfg;
+
+	bq25180_get_default_config(&cfg);
+
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x03/*VBAT_CTRL*/)
+		.ignoreOtherParameters()
+		.andReturnValue(-1);
+
+	LONGS_EQUAL(false, bq25180_apply_config(&cfg));
+}
+
+TEST(BQ25180, apply_config_ShouldAssertParam_WhenOutOfRange) {
+	struct bq25180_config cfg;
+
+	bq25180_get_default_config(&cfg);
+	cfg.fastcharge_milliampere = 1000+1;
+
+	mock().expectOneCall("fake_assert");
+	bq25180_apply_config(&cfg);
+}
+
+TEST(BQ25180, get_fastcharge_current_ShouldReadRegister_WhenCacheDisabled) {
+	uint16_t milliampere;
+	uint8_t val = 0x9f;
+
+	expect_reg_read(0x04/*ICHG_CTRL*/, &val);
+	LONGS_EQUAL(true, bq25180_get_fastcharge_current(&milliampere));
+	LONGS_EQUAL(40, milliampere);
+}
+
+TEST(BQ25180, get_input_current_ShouldReturnFalse_WhenReadFails) {
+	uint16_t milliampere;
+
+	mock().expectOneCall("bq25180_read").ignoreOtherParameters()
+		.andReturnValue(-1);
+	LONGS_EQUAL(false, bq25180_get_input_current(&milliampere));
+}
+
+TEST(BQ25180, getters_ShouldNotAccessBus_WhenCacheEnabled) {
+	enum bq25180_sys_source source;
+	uint16_t val;
+	uint8_t expected = 0x1f;
+
+	bq25180_enable_cache(false);
+	expect_reg_write(0x04/*ICHG_CTRL*/, &expected);
+	bq25180_set_fastcharge_current(40);
+
+	LONGS_EQUAL(true, bq25180_get_fastcharge_current(&val));
+	LONGS_EQUAL(40, val);
+	LONGS_EQUAL(true, bq25180_get_input_current(&val));
+	LONGS_EQUAL(500, val);
+	LONGS_EQUAL(true, bq25180_get_battery_regulation_voltage(&val));
+	LONGS_EQUAL(4200, val);
+	LONGS_EQUAL(true, bq25180_get_sys_source(&source));
+	LONGS_EQUAL(BQ25180_SYS_SRC_VIN_VBAT, source);
+}
+
+TEST(BQ25180, get_config_ShouldServeFromShadow_WithoutBusAccess) {
+	struct bq25180_config cfg;
+
+	bq25180_enable_cache(false);
+	LONGS_EQUAL(true, bq25180_get_config(&cfg, false));
+
+	LONGS_EQUAL(true, cfg.charging_enabled);
+	LONGS_EQUAL(4200, cfg.battery_regulation_millivoltage);
+	LONGS_EQUAL(10, cfg.fastcharge_milliampere);
+	LONGS_EQUAL(500, cfg.input_milliampere);
+	LONGS_EQUAL(BQ25180_WDT_DEFAULT, cfg.watchdog);
+}
+
+TEST(BQ25180, get_config_ShouldReadInSingleBurst_WhenCacheDisabled) {
+	uint8_t regs[10] = { 0x46,0x9f,0x2c,0x56,0x84,0x4f,0x11,0x44,0x00,0xc0 };
+	struct bq25180_config cfg;
+
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x03/*VBAT_CTRL*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+	LONGS_EQUAL(true, bq25180_get_config(&cfg, false));
+
+	LONGS_EQUAL(false, cfg.charging_enabled);
+	LONGS_EQUAL(40, cfg.fastcharge_milliampere);
+	LONGS_EQUAL(1100, cfg.input_milliampere);
+	LONGS_EQUAL(BQ25180_SYS_SRC_VBAT, cfg.sys_source);
+}
+
+TEST(BQ25180, get_config_ShouldReadDeviceAndRefreshShadow_WhenLive) {
+	uint8_t regs[10] = { 0x46,0x85,0x2c,0x56,0x84,0x4d,0x11,0x40,0x00,0xc0 };
+	uint8_t expected = 0x05;
+	struct bq25180_config cfg;
+
+	bq25180_enable_cache(false);
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x03/*VBAT_CTRL*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+	LONGS_EQUAL(true, bq25180_get_config(&cfg, true));
+	LONGS_EQUAL(false, cfg.charging_enabled);
+
+	expect_reg_write(0x04/*ICHG_CTRL*/, &expected);
+	bq25180_enable_battery_charging(true);
+}
+
+TEST(BQ25180, get_config_ShouldReturnFalse_WhenReadFails) {
+	struct bq25180_config cfg;
+
+	mock().expectOneCall("bq25180_read").ignoreOtherParameters()
+		.andReturnValue(-1);
+	LONGS_EQUAL(false, bq25180_get_config(&cfg, false));
+}
+
+TEST(BQ25180, get_config_image_ShouldStartFromResetValues) {
+	uint8_t expected[10] = {
+		0x46,0x1f,0x2c,0x50,0x84,0x4d,0x11,0x44,0x00,0x00 };
+	uint8_t image[10];
+	struct bq25180_config cfg;
+
+	bq25180_get_default_config(&cfg);
+	cfg.fastcharge_milliampere = 40;
+	cfg.sys_source = BQ25180_SYS_SRC_VBAT;
+	cfg.interrupts = BQ25180_INTR_ALL;
+
+	bq25180_get_config_image(&cfg, image);
+	MEMCMP_EQUAL(expected, image, sizeof(image));
+}
+
+TEST(BQ25180, config_blob_ShouldRoundTrip) {
+	uint8_t image[10] = { 0x46,0x1f,0x2c,0x50,0x84,0x4d,0x11,0x44,0,0 };
+	uint8_t blob[BQ25180_CONFIG_BLOB_LEN];
+	uint8_t decoded[10];
+
+	bq25180_encode_config_blob(image, blob);
+
+	LONGS_EQUAL(BQ25180_CONFIG_BLOB_VERSION, blob[0]);
+	LONGS_EQUAL(true, bq25180_decode_config_blob(blob, decoded));
+	MEMCMP_EQUAL(image, decoded, sizeof(image));
+}
+
+TEST(BQ25180, config_blob_ShouldBeRejected_WhenCorrupted) {
+	uint8_t image[10] = { 0x46,0x1f,0x2c,0x50,0x84,0x4d,0x11,0x44,0,0 };
+	uint8_t blob[BQ25180_CONFIG_BLOB_LEN];
+	uint8_t decoded[10] = { 0, };
+
+	bq25180_encode_config_blob(image, blob);
+	blob[2] ^= 0x10;
+	LONGS_EQUAL(false, bq25180_decode_config_blob(blob, decoded));
+	blob[2] ^= 0x10;
+	blob[0]++;
+	LONGS_EQUAL(false, bq25180_decode_config_blob(blob, decoded));
+	LONGS_EQUAL(0, decoded[0]);
+}
+
+TEST(BQ25180, probe_ShouldNotWrite_WhenDeviceIdMismatch) {
+	uint8_t regs[10] = { 0x46,0x05,0x2c,0x56,0x84,0x4d,0x11,0x40,0x00,0xc1 };
+	uint8_t image[10] = { 0x46,0x1f,0x2c,0x56,0x84,0x4d,0x11,0x40,0x00,0xc0 };
+	struct bq25180_probe_report report;
+
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x03/*VBAT_CTRL*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+
+	LONGS_EQUAL(false, bq25180_probe(image, &report));
+	LONGS_EQUAL(1, report.device_id);
+	LONGS_EQUAL(1, report.transactions);
+}
+
+TEST(BQ25180, enable_interrupt_ShouldWriteOncePerRegister_WhenMultipleGiven) {
+	uint8_t chargectrl1[] = { 0x56, 0x50 };
+	uint8_t mask_id[] = { 0xC0, 0x00 };
+
+	expect_reg_read(0x06/*CHARGECTRL1*/, &chargectrl1[0]);
+	expect_reg_write(0x06/*CHARGECTRL1*/, &chargectrl1[1]);
+	expect_reg_read(0x0C/*MASK_ID*/, &mask_id[0]);
+	expect_reg_write(0x0C/*MASK_ID*/, &mask_id[1]);
+	bq25180_enable_interrupt(BQ25180_INTR_ALL);
+}
+
+TEST(BQ25180, enable_interrupt_ShouldSkipWrite_WhenMaskUnchanged) {
+	bq25180_enable_cache(false);
+	bq25180_enable_interrupt(BQ25180_INTR_VDPM | BQ25180_INTR_POWER_ERROR);
+}
+
+TEST(BQ25180, process_interrupt_ShouldDoNothing_WhenNoInterruptPending) {
+	LONGS_EQUAL(true, bq25180_process_interrupt());
+}
+
+TEST(BQ25180, process_interrupt_ShouldReadOnce_WhenPulsesCoalesced) {
+	uint8_t regs[3] = { 0x00, 0x00, 0x48 };
+	int ctx;
+
+	bq25180_register_interrupt_callback(BQ25180_INTR_CURRENT_LIMIT |
+			BQ25180_INTR_THERMAL_REGULATION, intr_callback, &ctx);
+
+	bq25180_notify_interrupt();
+	bq25180_notify_interrupt();
+	bq25180_notify_interrupt();
+
+	mock().expectOneCall("bq25180_read")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x00/*STAT0*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+	mock().expectOneCall("intr_callback")
+		.withParameter("intr", BQ25180_INTR_CURRENT_LIMIT)
+		.withParameter("ctx", &ctx);
+	mock().expectOneCall("intr_callback")
+		.withParameter("intr", BQ25180_INTR_THERMAL_REGULATION)
+		.withParameter("ctx", &ctx);
+
+	LONGS_EQUAL(true, bq25180_process_interrupt());
+	LONGS_EQUAL(true, bq25180_process_interrupt());
+}
+
+TEST(BQ25180, process_interrupt_ShouldKeepPending_WhenReadFails) {
+	uint8_t regs[3] = { 0x00, 0x00, 0x00 };
+
+	mock().expectOneCall("bq25180_read").ignoreOtherParameters()
+		.andReturnValue(-1);
+	mock().expectOneCall("bq25180_read").ignoreOtherParameters()
+		.withOutputParameterReturning("buf", regs, sizeof(regs));
+
+	bq25180_notify_interrupt();
+	LONGS_EQUAL(false, bq25180_process_interrupt());
+	LONGS_EQUAL(true, bq25180_process_interrupt());
+}
+
+static int fake_bus_read(void *ctx, uint8_t addr, uint8_t reg,
+		void *buf, size_t bufsize) {
+	return mock().actualCall(__func__)
+			.withParameter("ctx", ctx)
+			.withParameter("addr", addr)
+			.withParameter("reg", reg)
+			.withOutputParameter("buf", buf)
+			.withParameter("bufsize", bufsize)
+			.returnIntValueOrDefault((int)bufsize);
+}
+
+static int fake_bus_write(void *ctx, uint8_t addr, uint8_t reg,
+		const void *data, size_t data_len) {
+	return mock().actualCall(__func__)
+			.withParameter("ctx", ctx)
+			.withParameter("addr", addr)
+			.withParameter("reg", reg)
+			.withMemoryBufferParameter("data", (const uint8_t *)data, data_len)
+			.returnIntValueOrDefault((int)data_len);
+}
+
+TEST_GROUP(BQ25180Instance) {
+	const struct bq25180_bus bus = {
+		.read = fake_bus_read,
+		.write = fake_bus_write,
+	};
+	struct bq25180 dev1;
+	struct bq25180 dev2;
+	int ctx1;
+	int ctx2;
+
+	void setup(void) {
+		mock().strictOrder();
+
+		bq25180_dev_init(&dev1, BQ25180_DEVICE_ADDRESS, &bus, &ctx1);
+		bq25180_dev_init(&dev2, 0x6B, &bus, &ctx2);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void expect_read(void *ctx, uint8_t addr, uint8_t reg, uint8_t *p) {
+		mock().expectOneCall("fake_bus_read")
+			.withParameter("ctx", ctx)
+			.withParameter("addr", addr)
+			.withParameter("reg", reg)
+			.withOutputParameterReturning("buf", p, sizeof(*p))
+			.withParameter("bufsize", 1);
+	}
+	void expect_interrupt_read(void *ctx, uint8_t regs[3]) {
+		mock().expectOneCall("fake_bus_read")
+			.withParameter("ctx", ctx)
+			.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+			.withParameter("reg", 0x00/*STAT0*/)
+			.withOutputParameterReturning("buf", regs, 3)
+			.withParameter("bufsize", 3);
+	}
+	void expect_write(void *ctx, uint8_t addr, uint8_t reg, uint8_t *p) {
+		mock().expectOneCall("fake_bus_write")
+			.withParameter("ctx", ctx)
+			.withParameter("addr", addr)
+			.withParameter("reg", reg)
+			.withMemoryBufferParameter("data", p, sizeof(*p));
+	}
+};
+
+TEST(BQ25180Instance, ShouldAccessEachDeviceThroughItsOwnBus) {
+	uint8_t v1[] = { 0x05, 0x85 };
+	uint8_t v2[] = { 0x85, 0x05 };
+
+	expect_read(&ctx1, BQ25180_DEVICE_ADDRESS, 0x04/*ICHG_CTRL*/, &v1[0]);
+	expect_write(&ctx1, BQ25180_DEVICE_ADDRESS, 0x04/*ICHG_CTRL*/, &v1[1]);
+	bq25180_dev_enable_battery_charging(&dev1, false);
+
+	expect_read(&ctx2, 0x6B, 0x04/*ICHG_CTRL*/, &v2[0]);
+	expect_write(&ctx2, 0x6B, 0x04/*ICHG_CTRL*/, &v2[1]);
+	bq25180_dev_enable_battery_charging(&dev2, true);
+}
+
+TEST(BQ25180Instance, ShouldKeepCachePerDevice) {
+	uint8_t v1 = 0x85;
+	uint8_t v2[] = { 0x1f, 0x9f };
+
+	bq25180_dev_enable_cache(&dev1, false);
+
+	expect_write(&ctx1, BQ25180_DEVICE_ADDRESS, 0x04/*ICHG_CTRL*/, &v1);
+	bq25180_dev_enable_battery_charging(&dev1, false);
+
+	expect_read(&ctx2, 0x6B, 0x04/*ICHG_CTRL*/, &v2[0]);
+	expect_write(&ctx2, 0x6B, 0x04/*ICHG_CTRL*/, &v2[1]);
+	bq25180_dev_enable_battery_charging(&dev2, false);
+}
+
+TEST(BQ25180Instance, ShouldKeepInterruptsPerDevice) {
+	uint8_t regs[3] = { 0x00, 0x00, 0x40 };
+
+	bq25180_dev_register_interrupt_callback(&dev2,
+			BQ25180_INTR_CURRENT_LIMIT, intr_callback, &ctx2);
+	bq25180_dev_notify_interrupt(&dev2);
+
+	LONGS_EQUAL(true, bq25180_dev_process_interrupt(&dev1));
+
+	mock().expectOneCall("fake_bus_read")
+		.withParameter("ctx", &ctx2)
+		.withParameter("addr", 0x6B)
+		.withParameter("reg", 0x00/*STAT0*/)
+		.withOutputParameterReturning("buf", regs, sizeof(regs))
+		.withParameter("bufsize", sizeof(regs));
+	mock().expectOneCall("intr_callback")
+		.withParameter("intr", BQ25180_INTR_CURRENT_LIMIT)
+		.withParameter("ctx", &ctx2);
+	LONGS_EQUAL(true, bq25180_dev_process_interrupt(&dev2));
+}
+
+TEST(BQ25180Instance, process_interrupt_ShouldReportChargingStatus_OnlyWhenChanged) {
+	uint8_t regs[3] = { 0x20, 0x00, 0x00 };
+
+	bq25180_dev_register_interrupt_callback(&dev1,
+			BQ25180_INTR_CHARGING_STATUS | BQ25180_INTR_POWER_ERROR,
+			intr_callback, NULL);
+
+	/* The first read is the baseline, not a change */
+	expect_interrupt_read(&ctx1, regs);
+	bq25180_dev_notify_interrupt(&dev1);
+	LONGS_EQUAL(true, bq25180_dev_process_interrupt(&dev1));
+
+	expect_interrupt_read(&ctx1, regs);
+	bq25180_dev_notify_interrupt(&dev1);
+	LONGS_EQUAL(true, bq25180_dev_process_interrupt(&dev1));
+
+	regs[0] = 0x40;
+	expect_interrupt_read(&ctx1, regs);
+	mock().expectOneCall("intr_callback")
+		.withParameter("intr", BQ25180_INTR_CHARGING_STATUS)
+		.withParameter("ctx", (void *)NULL);
+	bq25180_dev_notify_interrupt(&dev1);
+	LONGS_EQUAL(true, bq25180_dev_process_interrupt(&dev1));
+}
+
+TEST(BQ25180Instance, process_interrupt_ShouldTakeBaselineFromStateRead) {
+	uint8_t stat[2] = { 0x20, 0x00 };
+	uint8_t regs[3] = { 0x40, 0x00, 0x00 };
+	struct bq25180_state state;
+
+	bq25180_dev_register_interrupt_callback(&dev1,
+			BQ25180_INTR_CHARGING_STATUS, intr_callback, NULL);
+
+	mock().expectOneCall("fake_bus_read")
+		.withParameter("ctx", &ctx1)
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x00/*STAT0*/)
+		.withOutputParameterReturning("buf", stat, sizeof(stat))
+		.withParameter("bufsize", sizeof(stat));
+	LONGS_EQUAL(true, bq25180_dev_read_snapshot(&dev1, &state, NULL));
+
+	expect_interrupt_read(&ctx1, regs);
+	mock().expectOneCall("intr_callback")
+		.withParameter("intr", BQ25180_INTR_CHARGING_STATUS)
+		.withParameter("ctx", (void *)NULL);
+	bq25180_dev_notify_interrupt(&dev1);
+	LONGS_EQUAL(true, bq25180_dev_process_interrupt(&dev1));
+}
+
+TEST(BQ25180Instance, ShouldServeLegacyApiWithDefaultDevice) {
+	struct bq25180 *dev = bq25180_get_default_device();
+	uint8_t v = 0x85;
+
+	bq25180_enable_cache(false);
+	mock().expectOneCall("bq25180_write")
+		.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+		.withParameter("reg", 0x04/*ICHG_CTRL*/)
+		.withMemoryBufferParameter("data", &v, sizeof(v));
+	bq25180_dev_enable_battery_charging(dev, false);
+	bq25180_disable_cache();
+}
+
+static void retry_backoff(void *ctx, uint8_t attempt, int err) {
+	mock().actualCall(__func__)
+		.withParameter("ctx", ctx)
+		.withParameter("attempt", attempt)
+		.withParameter("err", err);
+}
+
+static uint32_t retry_get_time(void *ctx) {
+	(void)ctx;
+	return (uint32_t)mock().actualCall(__func__).returnIntValue();
+}
+
+TEST_GROUP(BQ25180Retry) {
+	const struct bq25180_bus bus = {
+		.read = fake_bus_read,
+		.write = fake_bus_write,
+	};
+	struct bq25180_retry_policy policy;
+	struct bq25180 dev;
+	int ctx;
+
+	void setup(void) {
+		mock().strictOrder();
+
+		memset(&policy, 0, sizeof(policy));
+		policy.max_retries = 2;
+		policy.backoff = retry_backoff;
+		policy.ctx = &ctx;
+
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS, &bus, &ctx);
+		bq25180_dev_set_retry_policy(&dev, &policy);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void expect_fail(const char *name, int err) {
+		mock().expectOneCall(name)
+			.withParameter("ctx", &ctx)
+			.ignoreOtherParameters()
+			.andReturnValue(err);
+	}
+	void expect_backoff(uint8_t attempt, int err) {
+		mock().expectOneCall("retry_backoff")
+			.withParameter("ctx", &ctx)
+			.withParameter("attempt", attempt)
+			.withParameter("err", err);
+	}
+	void expect_time(uint32_t t) {
+		mock().expectOneCall("retry_get_time")
+			.andReturnValue((int)t);
+	}
+	void expect_read(uint8_t reg, uint8_t *p) {
+		mock().expectOneCall("fake_bus_read")
+			.withParameter("ctx", &ctx)
+			.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+			.withParameter("reg", reg)
+			.withOutputParameterReturning("buf", p, sizeof(*p))
+			.withParameter("bufsize", 1);
+	}
+	void expect_write(uint8_t reg, uint8_t *p) {
+		mock().expectOneCall("fake_bus_write")
+			.withParameter("ctx", &ctx)
+			.withParameter("addr", BQ25180_DEVICE_ADDRESS)
+			.withParameter("reg", reg)
+			.withMemoryBufferParameter("data", p, sizeof(*p));
+	}
+};
+
+TEST(BQ25180Retry, ShouldNotWrite_WhenReadFails) {
+	bq25180_dev_set_retry_policy(&dev, NULL);
+
+	expect_fail("fake_bus_read", -1);
+	LONGS_EQUAL(false, bq25180_dev_enable_battery_charging(&dev, false));
+}
+
+TEST(BQ25180Retry, ShouldReturnFalse_WhenWriteFails) {
+	uint8_t v[] = { 0x05, 0x85 };
+	bq25180_dev_set_retry_policy(&dev, NULL);
+
+	expect_read(0x04/*ICHG_CTRL*/, &v[0]);
+	expect_fail("fake_bus_write", -1);
+	LONGS_EQUAL(false, bq25180_dev_enable_battery_charging(&dev, false));
+}
+
+TEST(BQ25180Retry, ShouldRetryTransaction_WhenNacked) {
+	uint8_t v[] = { 0x05, 0x85 };
+
+	expect_fail("fake_bus_read", -5);
+	expect_backoff(1, -5);
+	expect_read(0x04/*ICHG_CTRL*/, &v[0]);
+	expect_fail("fake_bus_write", -5);
+	expect_backoff(1, -5);
+	expect_fail("fake_bus_write", -5);
+	expect_backoff(2, -5);
+	expect_write(0x04/*ICHG_CTRL*/, &v[1]);
+	LONGS_EQUAL(true, bq25180_dev_enable_battery_charging(&dev, false));
+
+	struct bq25180_retry_stats stats;
+	bq25180_dev_get_retry_stats(&dev, &stats);
+	LONGS_EQUAL(3, stats.retries);
+	LONGS_EQUAL(3, stats.retried_bytes);
+	LONGS_EQUAL(0, stats.failures);
+}
+
+TEST(BQ25180Retry, ShouldGiveUp_WhenRetriesExhausted) {
+	expect_fail("fake_bus_read", -5);
+	expect_backoff(1, -5);
+	expect_fail("fake_bus_read", -5);
+	expect_backoff(2, -5);
+	expect_fail("fake_bus_read", -5);
+	LONGS_EQUAL(false, bq25180_dev_enable_battery_charging(&dev, false));
+
+	struct bq25180_retry_stats stats;
+	bq25180_dev_get_retry_stats(&dev, &stats);
+	LONGS_EQUAL(2, stats.retries);
+	LONGS_EQUAL(1, stats.failures);
+}
+
+TEST(BQ25180Retry, ShouldStopRetrying_WhenBudgetRunsOut) {
+	policy.get_time = retry_get_time;
+	policy.budget = 10;
+
+	expect_fail("fake_bus_read", -5);
+	expect_time(100);
+	expect_time(105);
+	expect_backoff(1, -5);
+	expect_fail("fake_bus_read", -5);
+	expect_time(110);
+	expect_time(112);
+	LONGS_EQUAL(false, bq25180_dev_enable_battery_charging(&dev, false));
+
+	struct bq25180_retry_stats stats;
+	bq25180_dev_get_retry_stats(&dev, &stats);
+	LONGS_EQUAL(1, stats.retries);
+	LONGS_EQUAL(1, stats.budget_overruns);
+	LONGS_EQUAL(12, stats.retry_time);
+	LONGS_EQUAL(1, stats.failures);
+}
+
+TEST(BQ25180Retry, ShouldClearStats) {
+	bq25180_dev_set_retry_policy(&dev, NULL);
+	expect_fail("fake_bus_read", -1);
+	bq25180_dev_enable_battery_charging(&dev, false);
+
+	struct bq25180_retry_stats stats;
+	bq25180_dev_clear_retry_stats(&dev);
+	bq25180_dev_get_retry_stats(&dev, &stats);
+	LONGS_EQUAL(0, stats.failures);
+}
+
+TEST_GROUP(BQ25180Fields) {
+	void setup(void) {
+	}
+	void teardown(void) {
+	}
+};
+
+TEST(BQ25180Fields, ShouldCoverEveryDocumentedBitOnce) {
+	const uint8_t expected[NR_REGISTERS] = {
+		0xff, 0xdf, 0xff, 0x7f, 0xff, 0x7f, 0xff,
+		0xff, 0xff, 0xff, 0xef, 0xff, 0xff,
+	};
+	uint8_t covered[NR_REGISTERS] = { 0, };
+
+	for (int i = 0; i < NR_FIELDS; i++) {
+		const struct field *f = &bq25180_fields[i];
+		CHECK(f->reg < NR_REGISTERS);
+		CHECK(f->mask != 0);
+		LONGS_EQUAL(0, covered[f->reg] & f->mask);
+		covered[f->reg] |= f->mask;
+	}
+
+	MEMCMP_EQUAL(expected, covered, sizeof(expected));
+}
+
+TEST(BQ25180Fields, put_ShouldTouchOnlyTheField_WhenValueOverflows) {
+	uint8_t regs[NR_REGISTERS];
+	memset(regs, 0xa5, sizeof(regs));
+
+	put_field(regs, FIELD_BUVLO, 0xff);
+	LONGS_EQUAL(0xbd, regs[CHARGECTRL1]);
+	LONGS_EQUAL(7, get_field(regs, FIELD_BUVLO));
+	put_field(regs, FIELD_BUVLO, 2);
+	LONGS_EQUAL(0x95, regs[CHARGECTRL1]);
+	LONGS_EQUAL(0xa5, regs[IC_CTRL]);
+}
+
+TEST(BQ25180Fields, encode_ShouldMatchDatasheetThresholds) {
+	for (unsigned int mA = 0; mA <= 2000; mA++) {
+		const uint8_t expected = mA >= 1100? 7 : mA >= 700? 6 :
+			mA >= 500? 5 : mA >= 400? 4 : mA >= 300? 3 :
+			mA >= 200? 2 : mA >= 100? 1 : 0;
+		LONGS_EQUAL(expected,
+			bq25180_encode_input_current((uint16_t)mA));
+	}
+	for (unsigned int mV = 0; mV <= 3500; mV++) {
+		const uint8_t expected = mV > 2800? 2 : mV > 2600? 3 :
+			mV > 2400? 4 : mV > 2200? 5 : mV > 2000? 6 : 7;
+		LONGS_EQUAL(expected,
+			bq25180_encode_battery_under_voltage((uint16_t)mV));
+	}
+	for (unsigned int pct = 0; pct <= 255; pct++) {
+		const uint8_t expected = pct >= 20? 3 : pct >= 10? 2 :
+			pct >= 5? 1 : 0;
+		LONGS_EQUAL(expected,
+			bq25180_encode_termination_current((uint8_t)pct));
+	}
+}
+
+TEST(BQ25180Fields, decode_ShouldRoundTripEveryCode) {
+	for (uint8_t code = 0; code <= 115; code++) {
+		LONGS_EQUAL(code, bq25180_encode_battery_regulation_voltage(
+				bq25180_decode_battery_regulation_voltage(code)));
+	}
+	for (uint8_t code = 0; code <= 127; code++) {
+		LONGS_EQUAL(code, bq25180_encode_fastcharge_current(
+				bq25180_decode_fastcharge_current(code)));
+	}
+	for (uint8_t code = 2; code <= 7; code++) {
+		LONGS_EQUAL(code, bq25180_encode_battery_under_voltage(
+				bq25180_decode_battery_under_voltage(code)));
+	}
+	for (uint8_t code = 0; code <= 7; code++) {
+		LONGS_EQUAL(code, bq25180_encode_input_current(
+				bq25180_decode_input_current(code)));
+	}
+	for (uint8_t code = 0; code <= 3; code++) {
+		LONGS_EQUAL(code, bq25180_encode_termination_current(
+				bq25180_decode_termination_current(code)));
+	}
+	for (uint8_t code = 0; code <= 1; code++) {
+		LONGS_EQUAL(code, bq25180_encode_precharge_threshold(
+				bq25180_decode_precharge_threshold(code)));
+	}
+}
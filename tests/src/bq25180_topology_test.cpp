@@ -0,0 +1,245 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include "bq25180_topology.h"
+#include "bq25180_sim.h"
+#include "bq25180_sim_mux.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+#define NR_CHARGERS		4
+
+static int order[16];
+static int nr_order;
+
+static bool read_state(struct bq25180 *dev, void *ctx) {
+	struct bq25180_state state;
+
+	order[nr_order++] = *(int *)ctx;
+
+	return bq25180_dev_read_snapshot(dev, &state, NULL);
+}
+
+TEST_GROUP(BQ25180Topology) {
+	struct bq25180_sim_mux mux[2];
+	struct bq25180_sim sim[NR_CHARGERS];
+	struct bq25180_topology topo;
+	struct bq25180_topology_node node[NR_CHARGERS];
+	struct bq25180 dev[NR_CHARGERS];
+	int id[NR_CHARGERS];
+
+	void setup(void) {
+		/* 0x70: channel 0 and 3, 0x71: channel 1 and 2 */
+		const uint8_t where[NR_CHARGERS][2] = {
+			{ 0x70, 0 }, { 0x70, 3 }, { 0x71, 1 }, { 0x71, 2 },
+		};
+
+		bq25180_sim_mux_init(&mux[1], 0x71, NULL);
+		bq25180_sim_mux_init(&mux[0], 0x70, &mux[1]);
+		bq25180_topology_init(&topo, &bq25180_sim_mux_bus, &mux[0]);
+
+		for (int i = 0; i < NR_CHARGERS; i++) {
+			bq25180_sim_init(&sim[i], BQ25180_DEVICE_ADDRESS);
+			bq25180_sim_mux_attach(&mux[where[i][0] - 0x70],
+					where[i][1], &sim[i]);
+			node[i] = (struct bq25180_topology_node) {
+				.topo = &topo,
+				.mux_addr = where[i][0],
+				.channel = where[i][1],
+			};
+			bq25180_dev_init(&dev[i], BQ25180_DEVICE_ADDRESS,
+					&bq25180_topology_bus, &node[i]);
+			id[i] = i;
+		}
+
+		nr_order = 0;
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	uint32_t selects(void) {
+		struct bq25180_topology_stats stats;
+		bq25180_topology_get_stats(&topo, &stats);
+		return stats.selects;
+	}
+	uint32_t collisions(void) {
+		struct bq25180_sim_mux_stats stats;
+		bq25180_sim_mux_get_stats(&mux[0], &stats);
+		return stats.collisions;
+	}
+	struct bq25180_topology_job job(int i) {
+		return (struct bq25180_topology_job) {
+			.dev = &dev[i],
+			.node = &node[i],
+			.op = read_state,
+			.ctx = &id[i],
+		};
+	}
+};
+
+TEST(BQ25180Topology, ShouldSelectOnce_WhenSameChargerAccessedRepeatedly) {
+	struct bq25180_topology_stats stats;
+	struct bq25180_state state;
+
+	for (int i = 0; i < 3; i++) {
+		LONGS_EQUAL(true,
+			bq25180_dev_read_snapshot(&dev[0], &state, NULL));
+	}
+
+	bq25180_topology_get_stats(&topo, &stats);
+	LONGS_EQUAL(1, stats.selects);
+	LONGS_EQUAL(3, stats.transfers);
+	LONGS_EQUAL(0x01, bq25180_sim_mux_selected(&mux[0]));
+}
+
+TEST(BQ25180Topology, ShouldReachOnlyTheChargerAddressed) {
+	LONGS_EQUAL(true, bq25180_dev_set_fastcharge_current(&dev[2], 500));
+
+	LONGS_EQUAL(77, bq25180_sim_peek(&sim[2], 0x04/*ICHG_CTRL*/));
+	LONGS_EQUAL(0x05, bq25180_sim_peek(&sim[0], 0x04/*ICHG_CTRL*/));
+	LONGS_EQUAL(0x05, bq25180_sim_peek(&sim[3], 0x04/*ICHG_CTRL*/));
+}
+
+TEST(BQ25180Topology, ShouldSwitchChannel_WhenOnTheSameMux) {
+	struct bq25180_state state;
+
+	bq25180_dev_read_state(&dev[0], &state);
+	bq25180_dev_read_state(&dev[1], &state);
+
+	LONGS_EQUAL(2, selects());
+	LONGS_EQUAL(0x08, bq25180_sim_mux_selected(&mux[0]));
+}
+
+TEST(BQ25180Topology, ShouldDeselectPreviousMux_WhenMovingToAnother) {
+	struct bq25180_state state;
+
+	bq25180_dev_read_state(&dev[0], &state);
+	LONGS_EQUAL(true, bq25180_dev_read_state(&dev[2], &state));
+
+	LONGS_EQUAL(3, selects());
+	LONGS_EQUAL(0x00, bq25180_sim_mux_selected(&mux[0]));
+	LONGS_EQUAL(0x02, bq25180_sim_mux_selected(&mux[1]));
+	LONGS_EQUAL(0, collisions());
+}
+
+TEST(BQ25180Topology, ShouldReselect_WhenInvalidated) {
+	struct bq25180_state state;
+
+	bq25180_dev_read_state(&dev[0], &state);
+	bq25180_topology_invalidate(&topo);
+	bq25180_dev_read_state(&dev[0], &state);
+
+	LONGS_EQUAL(2, selects());
+}
+
+TEST(BQ25180Topology, ShouldFail_WhenMuxDoesNotAnswer) {
+	struct bq25180_topology_stats stats;
+	struct bq25180_state state;
+
+	node[1].mux_addr = 0x72;
+	LONGS_EQUAL(false, bq25180_dev_read_state(&dev[1], &state));
+	bq25180_topology_get_stats(&topo, &stats);
+	LONGS_EQUAL(1, stats.failures);
+	LONGS_EQUAL(0, stats.transfers);
+
+	/* Nothing left selected to get in the way */
+	LONGS_EQUAL(true, bq25180_dev_read_state(&dev[0], &state));
+	LONGS_EQUAL(0, collisions());
+}
+
+TEST(BQ25180Topology, ShouldRetryDeselect_WhenPreviousMuxRefusedIt) {
+	struct bq25180_topology_stats stats;
+	struct bq25180_state state;
+
+	bq25180_dev_read_state(&dev[2], &state);
+	/* 0x71 refuses once, its channel still selected */
+	bq25180_sim_mux_inject_nak(&mux[1], 1);
+
+	LONGS_EQUAL(false, bq25180_dev_read_state(&dev[0], &state));
+	LONGS_EQUAL(0x02, bq25180_sim_mux_selected(&mux[1]));
+	LONGS_EQUAL(true, bq25180_dev_read_state(&dev[0], &state));
+
+	bq25180_topology_get_stats(&topo, &stats);
+	LONGS_EQUAL(1, stats.failures);
+	LONGS_EQUAL(0x00, bq25180_sim_mux_selected(&mux[1]));
+	LONGS_EQUAL(0x01, bq25180_sim_mux_selected(&mux[0]));
+	LONGS_EQUAL(0, collisions());
+}
+
+TEST(BQ25180Topology, ShouldReachOthers_WhenGoneMuxForgotten) {
+	struct bq25180_state state;
+
+	bq25180_dev_read_state(&dev[2], &state);
+	/* 0x71 drops off the bus with its channel still selected */
+	mux[0].next = NULL;
+
+	LONGS_EQUAL(false, bq25180_dev_read_state(&dev[0], &state));
+	LONGS_EQUAL(false, bq25180_dev_read_state(&dev[0], &state));
+
+	bq25180_topology_forget_mux(&topo);
+	LONGS_EQUAL(true, bq25180_dev_read_state(&dev[0], &state));
+	LONGS_EQUAL(0x01, bq25180_sim_mux_selected(&mux[0]));
+	LONGS_EQUAL(0, collisions());
+}
+
+TEST(BQ25180Topology, run_ShouldGroupJobsByChannel) {
+	struct bq25180_topology_job jobs[] = {
+		job(0), job(2), job(0), job(2), job(1),
+	};
+	const int expected[] = { 0, 0, 2, 2, 1 };
+
+	LONGS_EQUAL(5, bq25180_topology_run(&topo, jobs,
+				sizeof(jobs) / sizeof(jobs[0])));
+
+	/* 0x70.0, then 0x70 off and 0x71.1, then 0x71 off and 0x70.3 */
+	LONGS_EQUAL(5, selects());
+	LONGS_EQUAL(5, nr_order);
+	MEMCMP_EQUAL(expected, order, sizeof(expected));
+	LONGS_EQUAL(0, collisions());
+}
+
+TEST(BQ25180Topology, run_ShouldStartWithTheChannelSelected) {
+	struct bq25180_state state;
+	struct bq25180_topology_job jobs[] = { job(0), job(3), job(0), };
+	const int expected[] = { 3, 0, 0 };
+
+	bq25180_dev_read_state(&dev[3], &state);
+	LONGS_EQUAL(3, bq25180_topology_run(&topo, jobs, 3));
+
+	LONGS_EQUAL(3, selects());
+	MEMCMP_EQUAL(expected, order, sizeof(expected));
+}
+
+TEST(BQ25180Topology, run_ShouldKeepGoing_WhenJobFails) {
+	struct bq25180_topology_job jobs[] = { job(0), job(1), job(2), };
+
+	bq25180_sim_inject_nak(&sim[1], 1);
+	LONGS_EQUAL(2, bq25180_topology_run(&topo, jobs, 3));
+
+	LONGS_EQUAL(true, jobs[0].ok);
+	LONGS_EQUAL(false, jobs[1].ok);
+	LONGS_EQUAL(true, jobs[2].ok);
+}
@@ -0,0 +1,162 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include "bq25180.h"
+#include "bq25180_sim.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+static uint32_t clock_ticks;
+
+static uint32_t get_time(void *ctx) {
+	return clock_ticks += 10;
+}
+
+static void op_begin(void *ctx, enum bq25180_op op, uint32_t timestamp) {
+	mock().actualCall(__func__)
+		.withParameter("op", op)
+		.withParameter("timestamp", timestamp);
+}
+
+static void op_end(void *ctx, enum bq25180_op op, bool ok,
+		uint32_t timestamp) {
+	mock().actualCall(__func__)
+		.withParameter("op", op)
+		.withParameter("ok", ok)
+		.withParameter("timestamp", timestamp);
+}
+
+static void bus_begin(void *ctx, bool write, uint8_t reg, size_t len,
+		uint32_t timestamp) {
+	mock().actualCall(__func__)
+		.withParameter("write", write)
+		.withParameter("reg", reg)
+		.withParameter("len", len)
+		.withParameter("timestamp", timestamp);
+}
+
+static void bus_end(void *ctx, bool write, uint8_t reg, size_t len,
+		int result, uint32_t timestamp) {
+	mock().actualCall(__func__)
+		.withParameter("write", write)
+		.withParameter("reg", reg)
+		.withParameter("len", len)
+		.withParameter("result", result)
+		.withParameter("timestamp", timestamp);
+}
+
+TEST_GROUP(BQ25180Trace) {
+	const struct bq25180_trace_hooks hooks = {
+		.op_begin = op_begin,
+		.op_end = op_end,
+		.bus_begin = bus_begin,
+		.bus_end = bus_end,
+		.get_time = get_time,
+		.ctx = NULL,
+	};
+	struct bq25180_sim sim;
+	struct bq25180 dev;
+
+	void setup(void) {
+		mock().strictOrder();
+		clock_ticks = 0;
+
+		bq25180_sim_init(&sim, BQ25180_DEVICE_ADDRESS);
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_sim_bus, &sim);
+		bq25180_dev_set_trace_hooks(&dev, &hooks);
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void expect_bus(bool write, uint8_t reg, size_t len, int result,
+			uint32_t t0) {
+		mock().expectOneCall("bus_begin")
+			.withParameter("write", write)
+			.withParameter("reg", reg)
+			.withParameter("len", len)
+			.withParameter("timestamp", t0);
+		mock().expectOneCall("bus_end")
+			.withParameter("write", write)
+			.withParameter("reg", reg)
+			.withParameter("len", len)
+			.withParameter("result", result)
+			.withParameter("timestamp", t0 + 10);
+	}
+};
+
+TEST(BQ25180Trace, ShouldTraceOperationAndTransactions) {
+	mock().expectOneCall("op_begin")
+		.withParameter("op", BQ25180_OP_ENABLE_BATTERY_CHARGING)
+		.withParameter("timestamp", 10);
+	expect_bus(false, 0x04/*ICHG_CTRL*/, 1, 1, 20);
+	expect_bus(true, 0x04/*ICHG_CTRL*/, 1, 1, 40);
+	mock().expectOneCall("op_end")
+		.withParameter("op", BQ25180_OP_ENABLE_BATTERY_CHARGING)
+		.withParameter("ok", true)
+		.withParameter("timestamp", 60);
+
+	LONGS_EQUAL(true, bq25180_dev_enable_battery_charging(&dev, false));
+}
+
+TEST(BQ25180Trace, ShouldAccumulateCounters) {
+	struct bq25180_trace_counters counters;
+	struct bq25180_state state;
+	mock().ignoreOtherCalls();
+
+	bq25180_dev_enable_battery_charging(&dev, false);
+	bq25180_dev_read_snapshot(&dev, &state, NULL);
+	bq25180_sim_inject_nak(&sim, 1);
+	bq25180_dev_read_snapshot(&dev, &state, NULL);
+
+	bq25180_dev_get_trace_counters(&dev, &counters);
+	LONGS_EQUAL(1, counters.ops[BQ25180_OP_ENABLE_BATTERY_CHARGING].calls);
+	LONGS_EQUAL(50, counters.ops[BQ25180_OP_ENABLE_BATTERY_CHARGING].time);
+	LONGS_EQUAL(2, counters.ops[BQ25180_OP_READ_SNAPSHOT].calls);
+	LONGS_EQUAL(1, counters.ops[BQ25180_OP_READ_SNAPSHOT].failures);
+	LONGS_EQUAL(2, counters.bus.reads);
+	LONGS_EQUAL(1, counters.bus.writes);
+	LONGS_EQUAL(3, counters.bus.read_bytes);
+	LONGS_EQUAL(1, counters.bus.written_bytes);
+	LONGS_EQUAL(1, counters.bus.errors);
+	LONGS_EQUAL(40, counters.bus.time);
+
+	bq25180_dev_clear_trace_counters(&dev);
+	bq25180_dev_get_trace_counters(&dev, &counters);
+	LONGS_EQUAL(0, counters.bus.reads);
+}
+
+TEST(BQ25180Trace, ShouldKeepCounters_WhenNoHooks) {
+	struct bq25180_trace_counters counters;
+
+	bq25180_dev_set_trace_hooks(&dev, NULL);
+	bq25180_dev_enable_interrupt(&dev, BQ25180_INTR_ALL);
+
+	bq25180_dev_get_trace_counters(&dev, &counters);
+	LONGS_EQUAL(1, counters.ops[BQ25180_OP_ENABLE_INTERRUPT].calls);
+	LONGS_EQUAL(4, counters.bus.reads + counters.bus.writes);
+	LONGS_EQUAL(0, counters.bus.time);
+}
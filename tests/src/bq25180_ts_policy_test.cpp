@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Kyunghwan Kwon <k@mononn.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/TestHarness_c.h"
+#include "CppUTestExt/MockSupport.h"
+
+#include <string.h>
+#include "bq25180_ts_policy.h"
+#include "bq25180_sim.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+void fake_assert(bool exp) {
+	if (exp) {
+		return;
+	}
+
+	mock().actualCall(__func__);
+	TEST_EXIT;
+}
+#if defined(__cplusplus)
+}
+#endif
+
+TEST_GROUP(BQ25180TsPolicy) {
+	struct bq25180_sim sim;
+	struct bq25180 dev;
+	struct bq25180_ts_policy policy;
+	struct bq25180_ts_policy_config cfg;
+
+	void setup(void) {
+		struct bq25180_config dev_cfg;
+
+		bq25180_sim_init(&sim, BQ25180_DEVICE_ADDRESS);
+		bq25180_sim_set_source(&sim, 5000, 0);
+		bq25180_dev_init(&dev, BQ25180_DEVICE_ADDRESS,
+				&bq25180_sim_bus, &sim);
+		bq25180_get_default_config(&dev_cfg);
+		dev_cfg.input_milliampere = 1100;
+		dev_cfg.watchdog = BQ25180_WDT_DISABLE;
+		bq25180_dev_apply_config(&dev, &dev_cfg);
+
+		cfg = (struct bq25180_ts_policy_config) {
+			.ts = dev_cfg.ts,
+			.normal = { 400, 4200 },
+			.cool = { 100, 4200 },
+			.warm = { 300, 4100 },
+		};
+	}
+	void teardown(void) {
+		mock().checkExpectations();
+		mock().clear();
+	}
+
+	void enter_zone(uint8_t zone) {
+		struct bq25180_state state;
+
+		bq25180_sim_set_ts_status(&sim, zone);
+		bq25180_sim_step(&sim, 100);
+		bq25180_dev_read_state(&dev, &state);
+		LONGS_EQUAL(true, bq25180_ts_policy_update(&policy, &state));
+		bq25180_sim_step(&sim, 100);
+	}
+	uint32_t bus_writes(void) {
+		struct bq25180_sim_stats stats;
+		bq25180_sim_get_stats(&sim, &stats);
+		return stats.writes;
+	}
+};
+
+TEST(BQ25180TsPolicy, init_ShouldWriteTsControl) {
+	cfg.ts.hot = BQ25180_TS_HOT_45C;
+	cfg.ts.cool_current = BQ25180_TS_ICHG_20PCT;
+
+	LONGS_EQUAL(true, bq25180_ts_policy_init(&policy, &dev, &cfg));
+	LONGS_EQUAL(0xc2, bq25180_sim_peek(&sim, 0x0b/*TS_CONTROL*/));
+}
+
+TEST(BQ25180TsPolicy, update_ShouldChargeAtNormalTarget_WhenNormal) {
+	bq25180_ts_policy_init(&policy, &dev, &cfg);
+	enter_zone(BQ25180_TS_ZONE_NORMAL);
+
+	LONGS_EQUAL(400, bq25180_sim_charge_milliampere(&sim));
+}
+
+TEST(BQ25180TsPolicy, update_ShouldMakeUpForDeviceReduction_WhenCool) {
+	bq25180_ts_policy_init(&policy, &dev, &cfg);
+	enter_zone(BQ25180_TS_ZONE_NORMAL);
+	enter_zone(BQ25180_TS_ZONE_COOL);
+
+	/* 200mA programmed, halved by the device */
+	LONGS_EQUAL(100, bq25180_sim_charge_milliampere(&sim));
+	LONGS_EQUAL(1, bq25180_ts_policy_zone_changes(&policy));
+
+	enter_zone(BQ25180_TS_ZONE_NORMAL);
+	LONGS_EQUAL(400, bq25180_sim_charge_milliampere(&sim));
+}
+
+TEST(BQ25180TsPolicy, update_ShouldNotExceedNormalTarget_WhenCoolTargetHigh) {
+	cfg.ts.cool_current = BQ25180_TS_ICHG_20PCT;
+	cfg.cool.fastcharge_milliampere = 200;
+	bq25180_ts_policy_init(&policy, &dev, &cfg);
+	enter_zone(BQ25180_TS_ZONE_COOL);
+
+	/* 1000mA would make 200mA but never more than 400mA programmed */
+	LONGS_EQUAL(80, bq25180_sim_charge_milliampere(&sim));
+}
+
+TEST(BQ25180TsPolicy, update_ShouldMakeUpForDeviceReduction_WhenWarm) {
+	bq25180_ts_policy_init(&policy, &dev, &cfg);
+	enter_zone(BQ25180_TS_ZONE_WARM);
+
+	/* 4200mV programmed, 100mV down by the device */
+	LONGS_EQUAL(4200 - 3500, (bq25180_sim_peek(&sim, 0x03) & 0x7f) * 10);
+	LONGS_EQUAL(300, bq25180_sim_charge_milliampere(&sim));
+}
+
+TEST(BQ25180TsPolicy, update_ShouldLowerVoltage_WhenWarmReductionDisabled) {
+	cfg.ts.warm_enabled = false;
+	bq25180_ts_policy_init(&policy, &dev, &cfg);
+	enter_zone(BQ25180_TS_ZONE_WARM);
+
+	LONGS_EQUAL(4100 - 3500, (bq25180_sim_peek(&sim, 0x03) & 0x7f) * 10);
+}
+
+TEST(BQ25180TsPolicy, update_ShouldNotWrite_WhenZoneUnchanged) {
+	bq25180_ts_policy_init(&policy, &dev, &cfg);
+	enter_zone(BQ25180_TS_ZONE_COOL);
+	bq25180_sim_clear_stats(&sim);
+
+	enter_zone(BQ25180_TS_ZONE_COOL);
+	LONGS_EQUAL(0, bus_writes());
+}
+
+TEST(BQ25180TsPolicy, update_ShouldLeaveItToDevice_WhenHotOrCold) {
+	bq25180_ts_policy_init(&policy, &dev, &cfg);
+	enter_zone(BQ25180_TS_ZONE_NORMAL);
+	bq25180_sim_clear_stats(&sim);
+
+	enter_zone(BQ25180_TS_ZONE_HOT_OR_COLD);
+	LONGS_EQUAL(0, bus_writes());
+	LONGS_EQUAL(0, bq25180_sim_charge_milliampere(&sim));
+	LONGS_EQUAL(0, bq25180_ts_policy_zone_changes(&policy));
+}
+
+TEST(BQ25180TsPolicy, update_ShouldRetry_WhenWriteFailed) {
+	struct bq25180_state state;
+
+	bq25180_ts_policy_init(&policy, &dev, &cfg);
+	enter_zone(BQ25180_TS_ZONE_NORMAL);
+	bq25180_sim_set_ts_status(&sim, BQ25180_TS_ZONE_COOL);
+	bq25180_sim_step(&sim, 100);
+	bq25180_dev_read_state(&dev, &state);
+
+	bq25180_sim_inject_nak(&sim, 1);
+	LONGS_EQUAL(false, bq25180_ts_policy_update(&policy, &state));
+	LONGS_EQUAL(true, bq25180_ts_policy_update(&policy, &state));
+	bq25180_sim_step(&sim, 100);
+	LONGS_EQUAL(100, bq25180_sim_charge_milliampere(&sim));
+}